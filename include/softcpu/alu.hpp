@@ -19,8 +19,9 @@ public:
   ALUResult add(std::uint16_t lhs, std::uint16_t rhs,
                 bool with_carry = false) const;
 
-  // Subtraction
-  ALUResult sub(std::uint16_t lhs, std::uint16_t rhs) const;
+  // Subtraction with optional borrow (one more is subtracted)
+  ALUResult sub(std::uint16_t lhs, std::uint16_t rhs,
+                bool with_borrow = false) const;
 
   // Bitwise AND
   ALUResult bit_and(std::uint16_t lhs, std::uint16_t rhs) const;
@@ -40,11 +41,74 @@ public:
   // Logical Shift Right
   ALUResult shr(std::uint16_t value, std::uint8_t amount) const;
 
+  // Rotate left/right; C receives the last bit rotated around
+  ALUResult rol(std::uint16_t value, std::uint8_t amount) const;
+  ALUResult ror(std::uint16_t value, std::uint8_t amount) const;
+
+  // Arithmetic shift right (sign bit replicated)
+  ALUResult sar(std::uint16_t value, std::uint8_t amount) const;
+
+  // Number of set bits
+  ALUResult popcnt(std::uint16_t value) const;
+
+  // Leading/trailing zero bits; 16 (with C set) for zero
+  ALUResult clz(std::uint16_t value) const;
+  ALUResult ctz(std::uint16_t value) const;
+
+  // Swap the two bytes
+  ALUResult bswap(std::uint16_t value) const;
+
+  // Test, set or clear bit `bit` (mod 16). Flags describe the old bit:
+  // C is its value and Z is set when it was clear.
+  ALUResult bit_test(std::uint16_t value, std::uint8_t bit) const;
+  ALUResult bit_set(std::uint16_t value, std::uint8_t bit) const;
+  ALUResult bit_clear(std::uint16_t value, std::uint8_t bit) const;
+
+  // Packed byte lanes: each word holds two independent 8-bit lanes. Z and
+  // N follow the word; C is set when any lane carried out, borrowed or
+  // (with `saturate`) was clamped. Overflow is cleared.
+  ALUResult padd_b(std::uint16_t lhs, std::uint16_t rhs, bool saturate) const;
+  ALUResult psub_b(std::uint16_t lhs, std::uint16_t rhs, bool saturate) const;
+
+  // Lanes become 0xFF where the comparison holds and 0x00 elsewhere; C is
+  // set when it holds in both lanes
+  ALUResult pcmpeq_b(std::uint16_t lhs, std::uint16_t rhs) const;
+  ALUResult pcmphi_b(std::uint16_t lhs, std::uint16_t rhs) const;
+
+  // Lane-wise unsigned minimum/maximum
+  ALUResult pmin_b(std::uint16_t lhs, std::uint16_t rhs) const;
+  ALUResult pmax_b(std::uint16_t lhs, std::uint16_t rhs) const;
+
+  // Clamp two signed words to 0..255 and pack them, `low` into the low lane;
+  // C is set when either was clamped
+  ALUResult pack_b(std::uint16_t low, std::uint16_t high) const;
+
   // Multiplication
   ALUResult mul(std::uint16_t lhs, std::uint16_t rhs) const;
 
+  // Upper 16 bits of the 32-bit product, signed or unsigned
+  ALUResult mul_high(std::uint16_t lhs, std::uint16_t rhs,
+                     bool is_signed) const;
+
+  // Signed fixed-point multiply: the 32-bit product is rounded to nearest
+  // and shifted right by `fraction_bits` (15 for Q1.15, 8 for Q8.8).
+  // Results outside the signed 16-bit range saturate and raise C and V.
+  ALUResult mul_fixed(std::uint16_t lhs, std::uint16_t rhs,
+                      std::uint8_t fraction_bits) const;
+
+  // Signed saturating add/subtract: clamp to 0x7FFF/0x8000 instead of
+  // wrapping. V is set when clamped; C is that of the plain add/subtract.
+  ALUResult add_saturating(std::uint16_t lhs, std::uint16_t rhs) const;
+  ALUResult sub_saturating(std::uint16_t lhs, std::uint16_t rhs) const;
+
+  // Signed absolute value; 0x8000 saturates to 0x7FFF with V set
+  ALUResult abs(std::uint16_t value) const;
+
   // Division
   ALUResult divide(std::uint16_t lhs, std::uint16_t rhs) const;
+
+  // Remainder of unsigned division; the dividend when `rhs` is zero
+  ALUResult remainder(std::uint16_t lhs, std::uint16_t rhs) const;
 };
 
 } // namespace softcpu
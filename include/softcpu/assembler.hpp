@@ -1,6 +1,7 @@
 #pragma once
 
 #include "softcpu/instruction.hpp"
+#include "softcpu/utils.hpp"
 
 #include <cstdint>
 #include <functional>
@@ -9,6 +10,7 @@
 #include <string>
 #include <string_view>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace softcpu {
@@ -18,6 +20,10 @@ struct AssemblyResult {
   bool ok{false};                    // True if assembly was successful
   std::vector<std::uint8_t> bytes;   // The resulting machine code
   std::vector<std::string> messages; // Error messages or warnings
+  std::vector<std::pair<std::string, std::uint16_t>>
+      labels; // Code and data labels in definition order
+  std::vector<util::PhysicalBlock>
+      banks; // Banked sections, placed at physical addresses
 };
 
 // Options for the assembler
@@ -60,6 +66,7 @@ private:
     bool is_offset{false};
     int multiplier{1};
     std::uint8_t width{2};
+    std::size_t section{0}; // 0: main image, N: banks_[N - 1]
   };
 
   // Parsed specification of an operand
@@ -75,6 +82,8 @@ private:
     bool offset_refers_symbol{false};
     std::string offset_symbol;
     int offset_sign{1};
+    AutoIndex auto_index{AutoIndex::None};
+    std::uint8_t step{0}; // Explicit auto-index step; 0 uses the default
   };
 
   // Main assembly pass
@@ -100,6 +109,10 @@ private:
                          std::vector<std::uint8_t> &program,
                          std::vector<PendingOperand> &pending);
 
+  // Finish the open banked section and resume the main image
+  void closeBank(std::uint16_t &location_counter,
+                 std::vector<std::uint8_t> &program);
+
   // Parse a single operand string
   OperandSpec parseOperand(std::string_view token);
 
@@ -108,7 +121,16 @@ private:
 
   std::unordered_map<std::string, SymbolInfo> symbols_;
   std::vector<std::string> errors_;
+  std::vector<std::pair<std::string, std::uint16_t>> labels_;
   std::uint16_t origin_{0};
+
+  // Banked sections (.bank FRAME, ADDRESS ... .endbank). While one is open
+  // the main image and its location counter are parked here.
+  std::vector<util::PhysicalBlock> banks_;
+  std::size_t current_bank_{0}; // 0: none, N: banks_[N - 1]
+  std::vector<std::uint8_t> main_program_;
+  std::uint16_t main_counter_{0};
+  std::uint16_t main_origin_{0};
 };
 
 } // namespace softcpu
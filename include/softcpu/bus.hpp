@@ -1,9 +1,16 @@
 #pragma once
 
+#include "softcpu/cache.hpp"
+#include "softcpu/heatmap.hpp"
 #include "softcpu/memory.hpp"
 
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <vector>
 
@@ -11,6 +18,23 @@ namespace softcpu {
 
 class IODevice;
 
+// Accesses a watchpoint triggers on
+enum class WatchKind : std::uint8_t { Read = 1, Write = 2, Access = 3 };
+
+// First watched access seen since the last takeWatchHit()
+struct WatchHit {
+  std::uint16_t address{0};
+  bool write{false};
+};
+
+// Result of Bus::compareBlock: where two blocks first differ and the bytes
+// found there (index == length and zero bytes when they are equal)
+struct BlockMismatch {
+  std::size_t index{0};
+  std::uint8_t lhs{0};
+  std::uint8_t rhs{0};
+};
+
 // The Bus class handles communication between the CPU, Memory, and I/O Devices
 class Bus {
 public:
@@ -22,6 +46,22 @@ public:
   // Read a 16-bit word from memory or an I/O device
   std::uint16_t read16(std::uint16_t address) const;
 
+  // Instruction fetch reads; identical to read8/read16 but never trigger
+  // read watchpoints
+  std::uint8_t fetch8(std::uint16_t address) const;
+  std::uint16_t fetch16(std::uint16_t address) const;
+
+  // Atomically replace the word at `address` with `desired` if it equals
+  // `expected`. Returns the previous value (the swap happened iff it equals
+  // `expected`). Aligned RAM words use host atomics; anything else is
+  // serialized with the device lock.
+  std::uint16_t compareExchange16(std::uint16_t address,
+                                  std::uint16_t expected,
+                                  std::uint16_t desired);
+
+  // Atomically add to the word at `address` and return its previous value
+  std::uint16_t fetchAdd16(std::uint16_t address, std::uint16_t addend);
+
   // Write a byte to memory or an I/O device
   void write8(std::uint16_t address, std::uint8_t value);
 
@@ -31,15 +71,181 @@ public:
   // Attach an I/O device to the bus
   void attachDevice(std::shared_ptr<IODevice> device);
 
+  // Return all attached devices to their power-on state
+  void resetDevices();
+
   // Update the state of all attached devices (e.g., for timers or interrupts)
   void tickDevices();
 
+  // Advance all attached devices by several cycles at once
+  void advanceDevices(std::uint64_t cycles);
+
+  // Cycles until the earliest scheduled device event that can wake a WAIT,
+  // if any. Events whose interrupt line is masked or unconnected are
+  // ignored: while the CPU sleeps nothing can unmask them.
+  std::optional<std::uint64_t> cyclesUntilNextEvent() const;
+
+  // Host pointer to [address, address + length) if the whole range is plain
+  // RAM with no device window or watchpoint, otherwise nullptr
+  std::uint8_t *ramSpan(std::uint16_t address, std::size_t length);
+  const std::uint8_t *ramSpan(std::uint16_t address,
+                              std::size_t length) const;
+
+  // ramSpan for a block read: when the range is plain RAM it is counted as
+  // one block access (heatmap, cache) and its host pointer returned
+  const std::uint8_t *readSpan(std::uint16_t address, std::size_t length);
+
+  // Copy a block with memmove semantics; uses host memory when both ranges
+  // are plain RAM and byte-wise bus accesses otherwise
+  void copyBlock(std::uint16_t destination, std::uint16_t source,
+                 std::size_t length);
+
+  // Fill a block with a byte value
+  void fillBlock(std::uint16_t destination, std::uint8_t value,
+                 std::size_t length);
+
+  // First differing byte between two blocks; each byte is read only once,
+  // so device windows see no repeated reads
+  BlockMismatch compareBlock(std::uint16_t lhs, std::uint16_t rhs,
+                             std::size_t length) const;
+
+  // Watch [address, address + length) for reads and/or writes. Watched pages
+  // join device pages on the slow path, so other pages pay nothing.
+  void addWatchpoint(std::uint16_t address, std::size_t length,
+                     WatchKind kind);
+  void clearWatchpoints();
+  bool hasWatchpoints() const { return watch_pages_.any(); }
+
+  // Collect and clear the recorded watchpoint hit
+  std::optional<WatchHit> takeWatchHit() {
+    auto hit = watch_hit_;
+    watch_hit_.reset();
+    return hit;
+  }
+
+  // Back guest page `page` (4 KiB) with host memory at `host`, or with the
+  // same page of Memory if `host` is nullptr. Used by the MMU to switch
+  // banks; the pointer must stay valid until the page is remapped. Entries
+  // are published with release ordering, so cores running in parallel see
+  // either the old or the new frame.
+  void mapPage(std::size_t page, std::uint8_t *host) {
+    tlb_[page].store(
+        host != nullptr ? host : memory_.data() + page * kPageSize,
+        std::memory_order_release);
+  }
+
+  // Count every access in `heatmap` (nullptr disables counting). The heatmap
+  // must outlive the bus or be detached first.
+  void setHeatmap(MemoryHeatmap *heatmap) { heatmap_ = heatmap; }
+  MemoryHeatmap *heatmap() const { return heatmap_; }
+
+  // Feed RAM accesses to a cache model whose miss penalties are added to the
+  // stall cycles (nullptr disables it). Not synchronized: single core only.
+  void setCache(CacheModel *cache) { cache_ = cache; }
+
+  // Serialize device accesses when several cores run on host threads. RAM
+  // accesses stay lock-free; watchpoints and the heatmap are not
+  // synchronized and should be left off for concurrent runs.
+  void setConcurrent(bool concurrent) { concurrent_ = concurrent; }
+
+  // Hold the device lock during concurrent runs (an empty lock otherwise)
+  std::unique_lock<std::recursive_mutex> lockDevices() const {
+    return concurrent_ ? std::unique_lock(device_mutex_)
+                       : std::unique_lock<std::recursive_mutex>();
+  }
+
+  // Charge extra cycles to the current instruction (e.g., DMA transfers)
+  void addStallCycles(std::uint64_t cycles) {
+    stall_cycles_.fetch_add(cycles, std::memory_order_relaxed);
+  }
+
+  // Collect and clear the stall cycles charged since the last call
+  std::uint64_t takeStallCycles() {
+    const std::uint64_t misses = cache_ != nullptr ? cache_->takePenalty() : 0;
+    if (stall_cycles_.load(std::memory_order_relaxed) == 0) {
+      return misses;
+    }
+    return misses + stall_cycles_.exchange(0, std::memory_order_relaxed);
+  }
+
 private:
   // Find the device mapped to a specific address
   IODevice *findDevice(std::uint16_t address) const;
 
+  // True if an access of `width` bytes touches a slow-path page
+  bool isSlow(std::uint16_t address, std::size_t width) const {
+    return slow_pages_.test(address >> 8) ||
+           (width == 2 && (address & 0xFF) == 0xFF &&
+            slow_pages_.test(static_cast<std::uint16_t>(address + 1) >> 8));
+  }
+
+  // Host byte backing a guest address
+  std::uint8_t *host(std::uint16_t address) const {
+    return tlb_[address / kPageSize].load(std::memory_order_acquire) +
+           address % kPageSize;
+  }
+
+  // RAM accesses through the TLB; a word may straddle two pages
+  std::uint16_t ramRead16(std::uint16_t address) const {
+    return static_cast<std::uint16_t>(
+        *host(address) |
+        (*host(static_cast<std::uint16_t>(address + 1)) << 8));
+  }
+  void ramWrite16(std::uint16_t address, std::uint16_t value) {
+    *host(address) = static_cast<std::uint8_t>(value & 0xFF);
+    *host(static_cast<std::uint16_t>(address + 1)) =
+        static_cast<std::uint8_t>(value >> 8);
+  }
+
+  // Feed the heatmap and the cache model, if attached
+  void count(std::uint16_t address, AccessKind kind, bool device,
+             std::size_t width = 1) const {
+    if (heatmap_ != nullptr) {
+      heatmap_->record(address, kind, device);
+    }
+    if (cache_ != nullptr && !device) {
+      cache_->access(address, width, kind);
+    }
+  }
+
+  // Count a block transfer on RAM
+  void countRange(std::uint16_t address, std::size_t length,
+                  AccessKind kind) const {
+    if (heatmap_ != nullptr) {
+      heatmap_->recordRange(address, length, kind);
+    }
+    if (cache_ != nullptr) {
+      cache_->accessRange(address, length, kind);
+    }
+  }
+
+  // Record a hit if a watchpoint covers the accessed bytes
+  void noteAccess(std::uint16_t address, std::size_t width, bool write) const;
+
+  // True if no device window or watchpoint overlaps the pages of the range
+  bool rangeIsRam(std::uint16_t address, std::size_t length) const;
+
   Memory &memory_;
+  // Host base of each guest page. With 16 pages the TLB covers the whole
+  // address space, so lookups never miss; the MMU refills an entry whenever
+  // a bank register changes and identity entries point into memory_. Atomic
+  // because other cores read entries while one core remaps a page; acquire
+  // loads are plain loads on common hosts.
+  std::array<std::atomic<std::uint8_t *>, kPageCount> tlb_{};
   std::vector<std::shared_ptr<IODevice>> devices_;
+  std::bitset<256> device_pages_; // Pages containing any device window
+  std::bitset<256> watch_pages_;  // Pages containing any watchpoint
+  std::bitset<256> slow_pages_;   // Union of device and watch pages
+  std::bitset<kMemorySize> watch_read_;
+  std::bitset<kMemorySize> watch_write_;
+  mutable std::optional<WatchHit> watch_hit_;
+  MemoryHeatmap *heatmap_{nullptr};
+  CacheModel *cache_{nullptr};
+  // Shared by all cores; in a concurrent run a stall may be charged to
+  // whichever core retires next
+  std::atomic<std::uint64_t> stall_cycles_{0};
+  bool concurrent_{false};
+  mutable std::recursive_mutex device_mutex_;
 };
 
 } // namespace softcpu
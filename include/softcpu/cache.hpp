@@ -0,0 +1,141 @@
+#pragma once
+
+#include "softcpu/heatmap.hpp"
+#include "softcpu/utils.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <vector>
+
+namespace softcpu {
+
+class CallProfiler;
+
+// Geometry and timing of one cache
+struct CacheConfig {
+  std::size_t size_bytes{0};      // Total capacity (0 leaves it out)
+  std::size_t ways{1};            // Associativity (1 = direct mapped)
+  std::size_t line_bytes{16};     // Bytes per line
+  std::uint32_t miss_penalty{10}; // Cycles per line fill or write-back
+
+  // Powers of two throughout, and the lines fit the capacity
+  bool valid() const;
+};
+
+// Counters of one cache
+struct CacheStats {
+  std::uint64_t accesses{0};
+  std::uint64_t misses{0};
+  std::uint64_t writebacks{0};     // Dirty lines evicted
+  std::uint64_t penalty_cycles{0}; // Cycles charged for misses
+
+  double missRate() const {
+    return accesses > 0 ? static_cast<double>(misses) / accesses : 0.0;
+  }
+};
+
+// Set-associative, write-back, write-allocate cache with LRU replacement.
+// Only tags are kept: data always comes from the bus, so the model changes
+// timing and never contents.
+class Cache {
+public:
+  explicit Cache(const CacheConfig &config);
+
+  // Look up the line holding `address`, filling it on a miss. Returns the
+  // cycles charged (0 on a hit).
+  std::uint32_t access(std::uint16_t address, bool write);
+
+  // Line number (address / line size) of an address
+  std::uint32_t lineOf(std::uint16_t address) const {
+    return address >> line_shift_;
+  }
+
+  // Invalidate every line and zero the counters
+  void clear();
+
+  const CacheConfig &config() const { return config_; }
+  const CacheStats &stats() const { return stats_; }
+
+private:
+  static constexpr std::uint32_t kInvalid = 0xFFFFFFFF;
+
+  struct Line {
+    std::uint32_t tag{kInvalid}; // Line number; kInvalid when empty
+    bool dirty{false};
+    std::uint64_t used{0}; // Access clock of the last hit or fill
+  };
+
+  CacheConfig config_;
+  unsigned line_shift_{0};
+  std::size_t set_mask_{0};
+  std::vector<Line> lines_; // Set-major: ways of set 0, then set 1, ...
+  std::uint64_t clock_{0};
+  CacheStats stats_;
+};
+
+// Instruction and data caches fed by the Bus. Fetches go to the instruction
+// cache and reads and writes to the data cache; device windows are uncached.
+// Miss penalties are collected as stall cycles, and every access is also
+// charged to the PC of the instruction that made it for per-function
+// reports. Tags are guest addresses, so MMU bank switches are not seen.
+class CacheModel {
+public:
+  // Per-instruction counters (index = PC)
+  struct SiteCounts {
+    std::uint64_t fetches{0};
+    std::uint64_t fetch_misses{0};
+    std::uint64_t data{0};
+    std::uint64_t data_misses{0};
+    std::uint64_t penalty_cycles{0};
+  };
+
+  // A cache with size_bytes == 0 is left out; its accesses are free
+  CacheModel(const CacheConfig &instruction, const CacheConfig &data);
+
+  // Attribute the following accesses to the instruction at `pc`
+  void setPc(std::uint16_t pc) { pc_ = pc; }
+
+  // One bus access of `width` bytes; a word spanning two lines touches both
+  void access(std::uint16_t address, std::size_t width, AccessKind kind);
+
+  // A block transfer: one access per line of [address, address + length)
+  void accessRange(std::uint16_t address, std::size_t length,
+                   AccessKind kind);
+
+  // Collect and clear the penalty cycles charged since the last call
+  std::uint64_t takePenalty() {
+    const auto cycles = penalty_;
+    penalty_ = 0;
+    return cycles;
+  }
+
+  // Invalidate both caches and zero all counters
+  void clear();
+
+  const Cache *instructionCache() const {
+    return instruction_ ? &*instruction_ : nullptr;
+  }
+  const Cache *dataCache() const { return data_ ? &*data_ : nullptr; }
+  const SiteCounts &site(std::uint16_t pc) const { return sites_[pc]; }
+
+  // Print totals per cache, then per function. Functions start at the
+  // entries seen by `profiler` if one is given, otherwise at the addresses
+  // in `symbols`; each PC is charged to the nearest entry at or below it.
+  void writeReport(std::ostream &out, const util::SymbolMap &symbols,
+                   const CallProfiler *profiler) const;
+
+private:
+  // Charge one line access to `cache` and the current site
+  void charge(Cache &cache, std::uint16_t address, bool fetch, bool write);
+
+  std::optional<Cache> instruction_;
+  std::optional<Cache> data_;
+  std::vector<SiteCounts> sites_;
+  std::uint16_t pc_{0};
+  std::uint64_t penalty_{0};
+};
+
+} // namespace softcpu
@@ -9,11 +9,18 @@ namespace softcpu {
 // Constants defining the architecture of the SoftCPU
 constexpr std::size_t kMemorySize =
     64 * 1024; // 64 KiB addressable space (16-bit address bus)
+constexpr std::size_t kPageSize =
+    4 * 1024; // Granule of MMU bank switching
+constexpr std::size_t kPageCount =
+    kMemorySize / kPageSize; // Guest pages in the address space
 constexpr std::size_t kRegisterCount = 8; // 8 General purpose registers: R0-R7
 constexpr std::uint16_t kResetVector =
     0x0000; // Default entry point (Program Counter start address)
 constexpr std::uint16_t kStackReset =
     0xFF00; // Default stack pointer address (grows downwards)
+constexpr std::size_t kMaxCores = 8; // Cores sharing one bus
+constexpr std::uint16_t kCoreStackSpacing =
+    0x0800; // Core N starts with SP = kStackReset - N * spacing
 constexpr std::uint8_t kInstructionHeaderSize =
     4; // Size of instruction header: opcode + two operands + modifier byte
 
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace softcpu {
+
+// Destination for bytes written to the console device
+class ConsoleSink {
+public:
+  virtual ~ConsoleSink() = default;
+
+  // Emit a single character
+  virtual void put(char ch) = 0;
+
+  // Emit a run of characters
+  virtual void write(std::string_view text) {
+    for (char ch : text) {
+      put(ch);
+    }
+  }
+
+  // Push any buffered output to its destination
+  virtual void flush() {}
+};
+
+// Writes into the stdio buffer of stdout; flushed on demand instead of per
+// character so console-heavy guests do not pay a syscall per byte
+class StdoutSink final : public ConsoleSink {
+public:
+  void put(char ch) override;
+  void write(std::string_view text) override;
+  void flush() override;
+};
+
+// Captures output into a bounded buffer allocated up front; bytes beyond the
+// capacity are counted but dropped
+class CaptureSink final : public ConsoleSink {
+public:
+  explicit CaptureSink(std::size_t capacity);
+
+  void put(char ch) override;
+  void write(std::string_view text) override;
+
+  // Captured text so far
+  std::string_view text() const { return {data_.data(), size_}; }
+
+  // Number of bytes discarded because the buffer was full
+  std::size_t dropped() const { return dropped_; }
+
+  std::size_t capacity() const { return data_.size(); }
+
+  // Discard captured text
+  void clear();
+
+private:
+  std::vector<char> data_;
+  std::size_t size_{0};
+  std::size_t dropped_{0};
+};
+
+// Appends output to a file through a large stdio buffer
+class FileSink final : public ConsoleSink {
+public:
+  explicit FileSink(const std::string &path);
+  ~FileSink() override;
+
+  FileSink(const FileSink &) = delete;
+  FileSink &operator=(const FileSink &) = delete;
+
+  // True if the file was opened successfully
+  bool ok() const { return file_ != nullptr; }
+
+  void put(char ch) override;
+  void write(std::string_view text) override;
+  void flush() override;
+
+private:
+  std::FILE *file_{nullptr};
+};
+
+// Discards all output
+class NullSink final : public ConsoleSink {
+public:
+  void put(char) override {}
+  void write(std::string_view) override {}
+};
+
+// Console back ends selectable from the CLI and RunOptions
+enum class ConsoleMode : std::uint8_t { Stdout, Capture, File, Null };
+
+// Description of a console sink to construct
+struct ConsoleOptions {
+  ConsoleMode mode{ConsoleMode::Stdout};
+  std::string path;           // Output file for ConsoleMode::File
+  std::size_t capacity{4096}; // Buffer size for ConsoleMode::Capture
+};
+
+// Build a sink from options. Returns nullptr if the sink cannot be opened.
+std::shared_ptr<ConsoleSink> makeConsoleSink(const ConsoleOptions &options);
+
+} // namespace softcpu
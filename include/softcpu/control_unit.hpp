@@ -1,7 +1,10 @@
 #pragma once
 
+#include "softcpu/coverage.hpp"
 #include "softcpu/cpu.hpp"
 #include "softcpu/instruction.hpp"
+#include "softcpu/pipeline.hpp"
+#include "softcpu/profiler.hpp"
 
 #include <optional>
 
@@ -18,6 +21,25 @@ public:
   // Perform one instruction cycle (fetch, decode, execute)
   bool step(bool trace = false);
 
+  // Push PC and flags, disable interrupts, and jump to a handler
+  void enterInterrupt(std::uint16_t vector);
+
+  // True if execution stopped on a fault (an unknown opcode, or CAS/FADD
+  // without a memory operand) rather than HALT
+  bool faulted() const { return fault_address_.has_value(); }
+
+  // Address of the instruction that faulted, if any
+  std::optional<std::uint16_t> faultAddress() const { return fault_address_; }
+
+  // Report CALL/RET and interrupt entry/return to a profiler (or nullptr)
+  void setProfiler(CallProfiler *profiler) { profiler_ = profiler; }
+
+  // Record taken branches as edges in `coverage` (or nullptr)
+  void setCoverage(EdgeCoverage *coverage) { coverage_ = coverage; }
+
+  // Charge pipeline hazard cycles from `pipeline` as stalls (or nullptr)
+  void setPipeline(PipelineModel *pipeline) { pipeline_ = pipeline; }
+
 private:
   // Fetch the next instruction from memory pointed to by PC
   DecodedInstruction fetchInstruction();
@@ -27,12 +49,22 @@ private:
   Operand resolveOperand(const OperandDescriptor &descriptor,
                          std::uint16_t &pc);
 
+  // Step the base register of an auto-indexed operand
+  void updateAutoIndex(const Operand &operand);
+
+  // Jump to `target`, recording the edge when coverage is enabled
+  void takeBranch(const DecodedInstruction &inst, std::uint16_t target);
+
   // Execute the decoded instruction
   bool execute(const DecodedInstruction &instruction, bool trace);
 
   Bus &bus_;
   RegisterFile &registers_;
   ALU &alu_;
+  std::optional<std::uint16_t> fault_address_;
+  CallProfiler *profiler_{nullptr};
+  EdgeCoverage *coverage_{nullptr};
+  PipelineModel *pipeline_{nullptr};
 };
 
 } // namespace softcpu
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace softcpu {
+
+// AFL-style edge coverage over a caller-provided byte map (e.g., AFL's shared
+// memory segment). Each taken branch bumps the counter for its (source PC,
+// target PC) pair; counters wrap but skip zero so a hot edge never vanishes.
+class EdgeCoverage {
+public:
+  // `size` must be a power of two; AFL uses 65536
+  EdgeCoverage(std::uint8_t *map, std::size_t size)
+      : map_(map), mask_(size - 1) {}
+
+  // Count a taken branch from the instruction at `from` to `to`
+  void record(std::uint16_t from, std::uint16_t to) {
+    auto &counter = map_[(scramble(from) >> 1 ^ scramble(to)) & mask_];
+    ++counter;
+    counter += counter == 0 ? 1 : 0;
+  }
+
+  std::uint8_t *map() const { return map_; }
+  std::size_t size() const { return mask_ + 1; }
+
+  // Number of map entries with a non-zero count
+  std::size_t edgesHit() const;
+
+private:
+  // Spread nearby addresses across the map (multiplicative hash)
+  static std::uint32_t scramble(std::uint16_t address) {
+    return (static_cast<std::uint32_t>(address) * 0x9E3779B1u) >> 8;
+  }
+
+  std::uint8_t *map_;
+  std::size_t mask_;
+};
+
+// Size of the AFL shared-memory coverage map
+inline constexpr std::size_t kAflMapSize = 1u << 16;
+
+// Attach the map named by the __AFL_SHM_ID environment variable, or return
+// nullptr when not running under AFL (or on hosts without SysV shm)
+std::uint8_t *attachAflSharedMemory();
+
+} // namespace softcpu
@@ -4,14 +4,21 @@
 #include "softcpu/instruction.hpp"
 
 #include <array>
+#include <atomic>
 #include <cstdint>
 #include <memory>
+#include <optional>
 
 namespace softcpu {
 
 class Bus;
 class ALU;
 class ControlUnit;
+class InterruptController;
+class CallProfiler;
+class CacheModel;
+class PipelineModel;
+class EdgeCoverage;
 
 // Structure holding the CPU's register state
 struct RegisterFile {
@@ -19,6 +26,8 @@ struct RegisterFile {
   std::uint16_t pc{kResetVector};                  // Program Counter
   std::uint16_t sp{kStackReset};                   // Stack Pointer
   FlagRegister flags{};                            // Status Flags
+  bool interrupts_enabled{false}; // Interrupt enable (EI/DI)
+  bool waiting{false};            // Idle in WAIT until an interrupt is pending
 
   // Reset registers to their default state
   void reset() {
@@ -28,6 +37,8 @@ struct RegisterFile {
     pc = kResetVector;
     sp = kStackReset;
     flags.value = 0;
+    interrupts_enabled = false;
+    waiting = false;
   }
 };
 
@@ -39,8 +50,47 @@ struct DecodedInstruction {
   std::uint8_t modifier{0};
   std::uint16_t size_bytes{kInstructionHeaderSize};
   std::uint16_t address{0}; // Address where the instruction is located
+  std::uint16_t branch_target{0}; // Trailing target word of BEQ/BNE/BLT
 };
 
+// Target of a jump, branch or call that names it directly
+inline std::optional<std::uint16_t>
+directTarget(const DecodedInstruction &inst) {
+  if (isCompareBranch(inst.opcode)) {
+    return inst.branch_target;
+  }
+  if (inst.operand_a.type != OperandType::Immediate) {
+    return std::nullopt;
+  }
+  return inst.operand_a.value;
+}
+
+// LOAD.B/LOAD.SB/STORE.B: the memory operand is a single byte
+inline bool isByteAccess(const DecodedInstruction &inst) {
+  return (inst.opcode == Opcode::LOAD || inst.opcode == Opcode::STORE) &&
+         (inst.modifier & kByteAccess) != 0;
+}
+
+// Attach the modifier's auto-index mode to the operand it applies to
+inline void decodeAutoIndex(DecodedInstruction &inst) {
+  const auto mode =
+      static_cast<AutoIndex>(inst.modifier & kAutoIndexMask);
+  if ((mode != AutoIndex::PostIncrement && mode != AutoIndex::PreDecrement) ||
+      usesModifierRegister(inst.opcode)) {
+    return;
+  }
+  Operand &operand = inst.operand_b.type == OperandType::RegisterIndirect
+                         ? inst.operand_b
+                         : inst.operand_a;
+  if (operand.type != OperandType::RegisterIndirect) {
+    return;
+  }
+  operand.auto_index = mode;
+  operand.step =
+      isByteAccess(inst) || (inst.modifier & kAutoIndexByteStep) != 0 ? 1
+                                                                        : 2;
+}
+
 // The Central Processing Unit
 class CPU {
 public:
@@ -54,15 +104,69 @@ public:
   // error occurs.
   bool step(bool trace = false);
 
+  // Connect the interrupt controller polled before each instruction
+  void attachInterruptController(InterruptController *controller) {
+    interrupts_ = controller;
+  }
+
+  // Wake from WAIT when `doorbell` is set (e.g., a mailbox message); the
+  // CPU clears it on waking
+  void attachDoorbell(std::atomic<bool> *doorbell) { doorbell_ = doorbell; }
+
+  // Whether step() and idle() also advance the bus devices. Cores of a
+  // multi-core machine leave that to the scheduler.
+  void setDrivesDevices(bool drives) { drives_devices_ = drives; }
+
+  // True if an interrupt or doorbell would end a WAIT
+  bool wakePending() const;
+
+  // Feed a call-graph profiler with every step (nullptr detaches it)
+  void attachProfiler(CallProfiler *profiler);
+
+  // Tell a cache model which instruction its accesses belong to (nullptr
+  // detaches it)
+  void attachCache(CacheModel *cache) { cache_ = cache; }
+
+  // Add pipeline hazard cycles to every instruction (nullptr detaches it)
+  void attachPipeline(PipelineModel *pipeline);
+
+  // Record taken branches in an edge-coverage map (nullptr detaches it)
+  void attachCoverage(EdgeCoverage *coverage);
+
+  // True while the CPU is idle in WAIT
+  bool waiting() const { return registers_.waiting; }
+
+  // True if the last stop was caused by a fault (see ControlUnit::faulted)
+  bool faulted() const;
+
+  // Address of the faulting instruction, if the last stop was a fault
+  std::optional<std::uint16_t> faultAddress() const;
+
+  // Let an idle CPU sit out several cycles at once while devices advance
+  void idle(std::uint64_t cycles);
+
   // Access the register file
   RegisterFile &registers() { return registers_; }
   const RegisterFile &registers() const { return registers_; }
 
+  // Cycles elapsed since reset, including stall cycles charged by devices
+  std::uint64_t cycles() const { return cycles_; }
+
+  // Instructions retired since reset
+  std::uint64_t instructions() const { return instructions_; }
+
 private:
   Bus &bus_;
   std::unique_ptr<ALU> alu_;
   std::unique_ptr<ControlUnit> control_;
   RegisterFile registers_;
+  InterruptController *interrupts_{nullptr};
+  std::atomic<bool> *doorbell_{nullptr};
+  bool drives_devices_{true};
+  CallProfiler *profiler_{nullptr};
+  CacheModel *cache_{nullptr};
+  std::uint64_t cycles_{0};
+  std::uint64_t instructions_{0};
 };
 
 } // namespace softcpu
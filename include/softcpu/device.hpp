@@ -1,10 +1,32 @@
 #pragma once
 
+#include "softcpu/common.hpp"
+#include "softcpu/console.hpp"
+
+#include <array>
+#include <atomic>
 #include <cstdint>
+#include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace softcpu {
 
+class Bus;
+class InterruptController;
+class Memory;
+
+// Connection from a device to one input line of the interrupt controller
+struct InterruptLine {
+  InterruptController *controller{nullptr};
+  std::uint8_t line{0};
+
+  // Latch the line as pending (no-op if unconnected)
+  void raise() const;
+};
+
 // Abstract base class for all I/O devices
 class IODevice {
 public:
@@ -30,10 +52,37 @@ public:
   // Write a byte to the device at the given offset
   virtual void write(std::uint16_t offset, std::uint8_t value) = 0;
 
+  // Return registers to their power-on state
+  virtual void reset() {}
+
   // Perform periodic updates (e.g., for timers)
   virtual void tick() {}
 
+  // Advance the device by several cycles at once (e.g., after a stall).
+  // Devices without time-based behaviour override this with a no-op.
+  virtual void advance(std::uint64_t cycles) {
+    while (cycles-- > 0) {
+      tick();
+    }
+  }
+
+  // Cycles until the device next raises an interrupt, if one is scheduled.
+  // Lets an idle (WAIT) CPU skip straight to the next event.
+  virtual std::optional<std::uint64_t> cyclesUntilEvent() const {
+    return std::nullopt;
+  }
+
+  // Route the device's interrupt output to a controller line
+  void connectInterrupt(InterruptLine line) { irq_ = line; }
+
+  // True if the device's interrupt output is connected to an unmasked line,
+  // so that its events can end a WAIT
+  bool interruptUnmasked() const;
+
 protected:
+  // Signal the connected interrupt line
+  void raiseInterrupt() const { irq_.raise(); }
+
   // Calculate the offset within the device's address space
   std::uint16_t offset(std::uint16_t address) const {
     return static_cast<std::uint16_t>(address - base_);
@@ -43,18 +92,28 @@ private:
   std::string name_;
   std::uint16_t base_;
   std::uint16_t size_;
+  InterruptLine irq_{};
 };
 
-// Simple console output device
+// Simple console output device forwarding data bytes to a ConsoleSink
 class ConsoleDevice final : public IODevice {
 public:
-  ConsoleDevice();
+  explicit ConsoleDevice(
+      std::shared_ptr<ConsoleSink> sink = std::make_shared<StdoutSink>());
   std::uint8_t read(std::uint16_t offset) override;
   void write(std::uint16_t offset, std::uint8_t value) override;
-  std::string buffer() const { return buffer_; }
+  void reset() override { ready_ = true; }
+  void advance(std::uint64_t) override {}
+
+  // Send a run of bytes to the back end in one write (e.g., from DMA)
+  void emit(std::string_view text) { sink_->write(text); }
+
+  // Replace the output back end
+  void setSink(std::shared_ptr<ConsoleSink> sink) { sink_ = std::move(sink); }
+  const std::shared_ptr<ConsoleSink> &sink() const { return sink_; }
 
 private:
-  std::string buffer_;
+  std::shared_ptr<ConsoleSink> sink_;
   bool ready_{true};
 };
 
@@ -64,14 +123,22 @@ public:
   TimerDevice();
   std::uint8_t read(std::uint16_t offset) override;
   void write(std::uint16_t offset, std::uint8_t value) override;
+  void reset() override;
   void tick() override;
+  void advance(std::uint64_t cycles) override;
+  std::optional<std::uint64_t> cyclesUntilEvent() const override;
 
 private:
+  // Ticks until the counter next equals the compare register
+  std::optional<std::uint64_t> cyclesUntilMatch() const;
+
   std::uint32_t divider_{0};
   std::uint16_t period_{1000};
   std::uint16_t counter_{0};
+  std::uint16_t compare_{0};
   bool enabled_{false};
   bool auto_reload_{true};
+  bool compare_irq_{false};
 };
 
 // LED Panel device for visual output
@@ -80,10 +147,159 @@ public:
   LedPanel();
   std::uint8_t read(std::uint16_t offset) override;
   void write(std::uint16_t offset, std::uint8_t value) override;
+  void reset() override { state_ = 0; }
+  void advance(std::uint64_t) override {}
   std::uint8_t state() const { return state_; }
 
 private:
   std::uint8_t state_{0};
 };
 
+// DMA controller performing block copies, fills, and memory-to-console
+// transfers on host memory. Transfers complete immediately and charge a
+// modelled cycle cost to the CPU as bus stall cycles.
+class DmaController final : public IODevice {
+public:
+  enum class Mode : std::uint8_t { Copy = 0, Fill = 1, ToConsole = 2 };
+
+  // Mode 2 writes to `console`
+  DmaController(Bus &bus, ConsoleDevice &console);
+  std::uint8_t read(std::uint16_t offset) override;
+  void write(std::uint16_t offset, std::uint8_t value) override;
+  void reset() override;
+  void advance(std::uint64_t) override {}
+
+private:
+  // Run the programmed transfer and return its modelled cycle cost
+  std::uint64_t transfer();
+
+  Bus &bus_;
+  ConsoleDevice &console_;
+  std::uint16_t source_{0};
+  std::uint16_t destination_{0};
+  std::uint16_t length_{0};
+  std::uint8_t mode_{0};
+  std::uint8_t fill_{0};
+  bool done_{false};
+  bool error_{false};
+};
+
+// Memory management unit mapping each 4 KiB guest page onto a frame of a
+// larger physical store. Frames 0-15 are Memory itself, so the power-on
+// mapping (page N on frame N) behaves exactly like a machine without an MMU;
+// higher frames live in an extended store owned by the device. Bank
+// registers hold 16-bit frame numbers written low byte first: the new
+// mapping takes effect when the high byte is written.
+class MmuDevice final : public IODevice {
+public:
+  // Largest physical store the 16-bit frame registers can address
+  static constexpr std::size_t kMaxFrames = 0xFFFF;
+
+  MmuDevice(Bus &bus, Memory &memory);
+  std::uint8_t read(std::uint16_t offset) override;
+  void write(std::uint16_t offset, std::uint8_t value) override;
+  void reset() override;
+  void advance(std::uint64_t) override {}
+
+  // Resize physical memory to `bytes`, rounded up to whole frames and at
+  // least 64 KiB. The extended store is zeroed and every page is remapped
+  // to its power-on frame.
+  void setPhysicalSize(std::size_t bytes);
+  std::size_t physicalSize() const { return frameCount() * kPageSize; }
+  std::size_t frameCount() const {
+    return kPageCount + extended_.size() / kPageSize;
+  }
+
+  // Host pointer to the first byte of a frame, or nullptr if out of range
+  std::uint8_t *frame(std::size_t index);
+
+  // Frame currently backing a guest page
+  std::uint16_t bank(std::size_t page) const { return banks_[page]; }
+
+  // Zero the extended store (frames 16 and up)
+  void clearExtended();
+
+  // Contents of the extended store, for snapshots
+  const std::vector<std::uint8_t> &extended() const { return extended_; }
+
+  // Copy a saved extended store back; the physical size must be unchanged
+  void restoreExtended(const std::vector<std::uint8_t> &bytes);
+
+private:
+  // Point a guest page at a frame and refill the bus TLB entry
+  void map(std::size_t page, std::uint16_t frame);
+
+  Bus &bus_;
+  Memory &memory_;
+  std::vector<std::uint8_t> extended_;
+  std::array<std::uint16_t, kPageCount> banks_{};
+  std::uint8_t latch_{0}; // Low byte of a bank register write in progress
+  bool error_{false};     // A write named a frame that does not exist
+};
+
+// Inter-processor mailboxes with one 16-bit message slot per core. Posting
+// a message (writing the high byte of a slot) marks it pending and rings the
+// core's doorbell, which ends a WAIT on that core.
+class Mailbox final : public IODevice {
+public:
+  Mailbox();
+  std::uint8_t read(std::uint16_t offset) override;
+  void write(std::uint16_t offset, std::uint8_t value) override;
+  void reset() override;
+  void advance(std::uint64_t) override {}
+
+  // Number of cores reported to software
+  void setCoreCount(std::size_t count) { cores_ = count; }
+
+  // Doorbell rung when a message is posted to `core`
+  std::atomic<bool> &doorbell(std::size_t core) { return doorbells_[core]; }
+
+private:
+  std::size_t cores_{1};
+  std::array<std::uint16_t, kMaxCores> messages_{};
+  std::array<std::uint8_t, kMaxCores> latches_{}; // Low byte being posted
+  std::array<bool, kMaxCores> pending_{};
+  std::array<std::atomic<bool>, kMaxCores> doorbells_{};
+};
+
+// Interrupt controller with eight lines, a pending latch, an enable mask, and
+// a vector table of handler addresses
+class InterruptController final : public IODevice {
+public:
+  static constexpr std::size_t kLineCount = 8;
+
+  InterruptController();
+  std::uint8_t read(std::uint16_t offset) override;
+  void write(std::uint16_t offset, std::uint8_t value) override;
+  void reset() override;
+  void advance(std::uint64_t) override {}
+
+  // Latch a line as pending
+  void raise(std::uint8_t line) {
+    pending_ |= static_cast<std::uint8_t>(1u << (line % kLineCount));
+  }
+
+  // True if any pending line is unmasked. Lock-free so that core 0 can poll
+  // it while other cores program the controller.
+  bool hasPending() const {
+    return (pending_.load(std::memory_order_relaxed) &
+            mask_.load(std::memory_order_relaxed)) != 0;
+  }
+
+  // True if `line` is enabled in the mask register
+  bool unmasked(std::uint8_t line) const {
+    return ((mask_.load(std::memory_order_relaxed) >> (line % kLineCount)) &
+            1u) != 0;
+  }
+
+  // Take the highest-priority (lowest numbered) unmasked pending line,
+  // clear it, and return its handler address
+  std::optional<std::uint16_t> acknowledge();
+
+private:
+  std::array<std::uint16_t, kLineCount> vectors_{};
+  std::atomic<std::uint8_t> pending_{0};
+  std::atomic<std::uint8_t> mask_{0};
+};
+
 } // namespace softcpu
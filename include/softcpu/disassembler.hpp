@@ -0,0 +1,94 @@
+#pragma once
+
+#include "softcpu/cpu.hpp"
+#include "softcpu/utils.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace softcpu {
+
+// How control reaches one block from another
+enum class EdgeKind : std::uint8_t {
+  Taken,       // Branch or jump target
+  Fallthrough, // Next instruction in memory
+  Call         // CALL target (the caller's block continues after the CALL)
+};
+
+struct CfgEdge {
+  std::uint16_t from{0}; // Start of the source block
+  std::uint16_t to{0};   // Start of the destination block
+  EdgeKind kind{EdgeKind::Taken};
+};
+
+// Straight-line run of instructions entered only at the top
+struct BasicBlock {
+  std::uint16_t start{0};
+  std::vector<DecodedInstruction> instructions;
+  std::uint64_t cycles{0}; // Static cost: one cycle per instruction
+  bool variable_cost{false}; // Block instructions or WAIT add run-time cycles
+  bool invalid{false};       // Ends in an unknown opcode or leaves the image
+  bool loop_header{false};
+  unsigned loop_depth{0}; // Natural loops containing the block
+};
+
+// Basic blocks and edges reachable from a set of roots
+struct ControlFlowGraph {
+  std::vector<BasicBlock> blocks; // Ordered by start address
+  std::vector<CfgEdge> edges;
+  std::vector<std::uint16_t> roots;     // Entry point and labels
+  std::vector<std::uint16_t> functions; // Unreached roots and CALL targets
+  std::size_t loops{0};                 // Distinct loop headers
+
+  // Index of the block starting at `address`, if any
+  std::optional<std::size_t> blockAt(std::uint16_t address) const;
+};
+
+// Decodes instructions from a memory image the way the control unit does,
+// and recovers the control-flow graph by recursive traversal. Only bytes in
+// [begin, end) are treated as code.
+class Disassembler {
+public:
+  // `memory` holds the full 64 KiB address space
+  Disassembler(const std::uint8_t *memory, std::uint16_t begin,
+               std::size_t end);
+
+  // Decode the instruction at `address`. Returns nullopt if the opcode is
+  // unknown or the instruction runs past the end of the code range.
+  std::optional<DecodedInstruction> decode(std::uint16_t address) const;
+
+  // Assembler syntax for an instruction; jump targets and absolute
+  // addresses are named from `symbols` when possible
+  static std::string format(const DecodedInstruction &inst,
+                            const util::SymbolMap &symbols);
+
+  // Follow every path from `roots`: conditional branches continue at both
+  // successors, direct jumps and calls at their targets. Indirect jumps,
+  // RET, RETI and HALT end a path. Blocks are annotated with static cost
+  // and natural-loop nesting.
+  ControlFlowGraph recover(const std::vector<std::uint16_t> &roots) const;
+
+  // Listing grouped by block with addresses, bytes and annotations
+  void writeListing(std::ostream &out, const ControlFlowGraph &cfg,
+                    const util::SymbolMap &symbols) const;
+
+  // Graphviz digraph: one box per block; taken edges solid, fallthroughs
+  // dashed, calls dotted
+  static void writeDot(std::ostream &out, const ControlFlowGraph &cfg,
+                       const util::SymbolMap &symbols);
+
+private:
+  bool inRange(std::size_t address) const {
+    return address >= begin_ && address < end_;
+  }
+
+  const std::uint8_t *memory_;
+  std::size_t begin_;
+  std::size_t end_;
+};
+
+} // namespace softcpu
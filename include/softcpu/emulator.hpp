@@ -1,10 +1,18 @@
 #pragma once
 
 #include "softcpu/bus.hpp"
+#include "softcpu/cache.hpp"
+#include "softcpu/console.hpp"
+#include "softcpu/coverage.hpp"
 #include "softcpu/cpu.hpp"
 #include "softcpu/device.hpp"
+#include "softcpu/heatmap.hpp"
 #include "softcpu/memory.hpp"
+#include "softcpu/pipeline.hpp"
+#include "softcpu/profiler.hpp"
 
+#include <array>
+#include <bitset>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -17,6 +25,64 @@ struct RunOptions {
   std::uint64_t cycle_limit{
       0};            // Maximum number of cycles to run (0 for unlimited)
   bool trace{false}; // Enable instruction tracing
+  std::shared_ptr<ConsoleSink>
+      console; // Console back end to install (null keeps the current one)
+  std::uint64_t clock_hz{
+      0}; // Pace execution to this guest clock (0 runs flat out)
+  std::uint16_t stack_floor{
+      0}; // Stop with StackEscape if SP drops below this (0 disables)
+  std::uint16_t stack_ceiling{
+      0xFFFF}; // Stop with StackEscape if SP rises above this
+  std::uint64_t quantum{
+      10000}; // Multi-core: cycles each core runs between synchronizations
+  bool deterministic{
+      false}; // Multi-core: run the cores in turn on the calling thread
+};
+
+// Why Emulator::run returned
+enum class StopReason : std::uint8_t {
+  Halted,      // HALT executed
+  CycleLimit,  // RunOptions::cycle_limit reached
+  Idle,        // WAIT with no device event left to wake the CPU
+  Fault,       // Unknown opcode, or CAS/FADD without a memory operand
+  StackEscape, // SP left [stack_floor, stack_ceiling]
+  Breakpoint,  // PC reached a breakpoint; the instruction has not executed
+  Watchpoint   // An instruction touched a watched address; it has completed
+};
+
+// Human readable name of a stop reason
+const char *stopReasonName(StopReason reason);
+
+// Measurements from the most recent call to Emulator::run
+struct RunStats {
+  StopReason stop_reason{StopReason::Halted};
+  std::uint16_t stop_address{0}; // Breakpoint or fault PC, watched address,
+                                 // or SP that escaped the stack bounds
+  bool stop_on_write{false};     // Watchpoint hit was a write
+  std::uint8_t stop_core{0};     // Core that faulted (multi-core runs)
+  std::uint64_t cycles{0};       // Guest cycles executed
+  std::uint64_t instructions{0}; // Instructions retired
+  double wall_seconds{0.0};      // Host wall-clock time
+  double cpu_seconds{0.0};       // Host CPU time consumed by the process
+
+  // Guest cycles per wall-clock second
+  double achievedHz() const {
+    return wall_seconds > 0.0 ? static_cast<double>(cycles) / wall_seconds
+                              : 0.0;
+  }
+
+  // Fraction of one host core kept busy during the run
+  double hostUtilization() const {
+    return wall_seconds > 0.0 ? cpu_seconds / wall_seconds : 0.0;
+  }
+};
+
+// Memory image and registers captured for fast resets (e.g., fuzzing).
+// `extended` holds physical frames above 64 KiB and is empty without them.
+struct Snapshot {
+  std::array<std::uint8_t, kMemorySize> memory{};
+  std::vector<std::uint8_t> extended;
+  RegisterFile registers;
 };
 
 // Main Emulator class that integrates CPU, Memory, Bus, and Devices
@@ -27,6 +93,14 @@ public:
   // Reset the emulator state (CPU, Memory, etc.)
   void reset();
 
+  // Capture memory (including extended frames) and registers
+  void saveSnapshot(Snapshot &snapshot) const;
+
+  // Return to a captured state: memory, extended frames and registers are
+  // copied back, the CPU counters and devices (and so the MMU mapping) are
+  // reset. Much cheaper than reloading an image.
+  void restoreSnapshot(const Snapshot &snapshot);
+
   // Attach default I/O devices to the bus
   void attachDefaultDevices();
 
@@ -34,6 +108,16 @@ public:
   void loadImage(const std::vector<std::uint8_t> &image,
                  std::uint16_t origin = kResetVector);
 
+  // Size physical memory for the MMU (see MmuDevice::setPhysicalSize). The
+  // default is the 64 KiB of Memory with nothing to bank in.
+  void setPhysicalMemory(std::size_t bytes);
+  std::size_t physicalMemorySize() const { return mmu_->physicalSize(); }
+
+  // Copy bytes into physical memory at a 32-bit physical address (frame *
+  // 4 KiB + offset), e.g. banked sections. Returns false if out of range.
+  bool loadPhysical(std::uint32_t address,
+                    const std::vector<std::uint8_t> &bytes);
+
   // Load a binary file from disk into memory
   bool loadBinaryFile(const std::string &path,
                       std::uint16_t origin = kResetVector);
@@ -44,22 +128,131 @@ public:
   // Dump a range of memory to standard output (hexdump format)
   bool dumpToStdout(std::uint16_t start, std::size_t count) const;
 
-  // Run the emulation loop
+  // Run the emulation loop. Returns false if execution stopped on a fault.
+  // Calling run again after a breakpoint or watchpoint stop resumes.
   bool run(const RunOptions &options);
 
-  // Accessors for registers
+  // Stop before executing the instruction at `address`
+  void setBreakpoint(std::uint16_t address, bool enabled = true);
+  void clearBreakpoints();
+  bool hasBreakpoint(std::uint16_t address) const {
+    return breakpoints_.test(address);
+  }
+
+  // Stop after an instruction reads and/or writes the watched range
+  void addWatchpoint(std::uint16_t address, std::size_t length,
+                     WatchKind kind);
+  void clearWatchpoints();
+
+  // Start counting bus accesses into a fresh heatmap, or stop counting.
+  // Counters accumulate across runs until the heatmap is re-enabled.
+  void enableHeatmap(bool enabled = true);
+
+  // Current heatmap, or nullptr if counting is off
+  const MemoryHeatmap *heatmap() const { return heatmap_.get(); }
+
+  // Start a fresh call-graph profile rooted at the current PC, or stop
+  // profiling. Set PC before enabling.
+  void enableProfiler(bool enabled = true);
+
+  // Current profiler, or nullptr if profiling is off
+  const CallProfiler *profiler() const { return profiler_.get(); }
+
+  // Model instruction and data caches with cold lines and fresh counters;
+  // miss penalties are added to the cycle count. A zero size_bytes leaves
+  // that cache out. Returns false if a geometry is invalid. Single core only.
+  bool enableCache(const CacheConfig &instruction, const CacheConfig &data);
+  void disableCache();
+
+  // Current cache model, or nullptr if caches are not modelled
+  const CacheModel *cache() const { return cache_.get(); }
+
+  // Model 5-stage pipeline hazards with fresh counters and predictor
+  // tables; their cycles are added to the cycle count. Returns false if the
+  // table sizes are out of range. Single core only.
+  bool enablePipeline(const PipelineConfig &config);
+  void disablePipeline();
+
+  // Current pipeline model, or nullptr if pipeline timing is off
+  const PipelineModel *pipeline() const { return pipeline_.get(); }
+
+  // Record taken branches into a caller-owned coverage map (nullptr to stop)
+  void setCoverage(EdgeCoverage *coverage);
+
+  // Statistics of the last run
+  const RunStats &lastRunStats() const { return stats_; }
+
+  // Cycles and instructions retired since the last reset
+  std::uint64_t cycles() const { return cpu_->cycles(); }
+  std::uint64_t instructions() const { return cpu_->instructions(); }
+
+  // Run `count` cores (1 to kMaxCores) on the shared bus. Extra cores are
+  // reset: core N starts at the reset vector with R0 = N and its own stack.
+  void setCoreCount(std::size_t count);
+  std::size_t coreCount() const { return secondary_.size() + 1; }
+
+  // Accessors for registers (of core 0, or of a given core)
   RegisterFile &registers();
   const RegisterFile &registers() const;
+  RegisterFile &registers(std::size_t core);
+
+  // Route console output to a different back end
+  void setConsoleSink(std::shared_ptr<ConsoleSink> sink);
+
+  // Current console back end (e.g., to read back a CaptureSink)
+  const std::shared_ptr<ConsoleSink> &consoleSink() const;
+
+  // Fetch a byte through the bus, so MMU mappings apply (unlike memory())
+  std::uint8_t fetch8(std::uint16_t address) const;
 
   // Accessors for memory
   Memory &memory();
   const Memory &memory() const;
 
 private:
+  // Execute until the cycle counter reaches `end` (StopReason::CycleLimit)
+  // or something stops the CPU. Policy selects whether breakpoints and
+  // watchpoints are checked, so the plain loop carries no debug branches.
+  template <typename Policy>
+  StopReason runUntil(const RunOptions &options, std::uint64_t end);
+
+  // Execute in slices, sleeping between them to match options.clock_hz
+  template <typename Policy>
+  StopReason runPaced(const RunOptions &options, std::uint64_t end);
+
+  // Multi-core run: every core executes a quantum, then the cores
+  // synchronize, devices advance by the quantum, and stop conditions are
+  // checked. Cores run on their own host threads unless
+  // options.deterministic is set.
+  StopReason runMulticore(const RunOptions &options, std::uint64_t budget);
+
+  CPU &core(std::size_t index) {
+    return index == 0 ? *cpu_ : *secondary_[index - 1];
+  }
+
+  // Reset a core to its power-on registers
+  void resetCore(std::size_t index);
+
+  // Fast-forward an idle CPU to the next device event, but not past `end`.
+  // Returns false if no event is scheduled.
+  bool skipToNextEvent(std::uint64_t end);
+
   Memory memory_;
   Bus bus_;
   std::unique_ptr<CPU> cpu_;
+  std::vector<std::unique_ptr<CPU>> secondary_; // Cores 1 and up
+  std::shared_ptr<ConsoleDevice> console_;
+  std::shared_ptr<InterruptController> interrupts_;
+  std::shared_ptr<MmuDevice> mmu_;
+  std::shared_ptr<Mailbox> mailbox_;
   std::vector<std::shared_ptr<IODevice>> devices_;
+  RunStats stats_;
+  std::unique_ptr<MemoryHeatmap> heatmap_;
+  std::unique_ptr<CallProfiler> profiler_;
+  std::unique_ptr<CacheModel> cache_;
+  std::unique_ptr<PipelineModel> pipeline_;
+  std::bitset<kMemorySize> breakpoints_;
+  bool resume_at_breakpoint_{false}; // Step over the breakpoint at PC once
 };
 
 } // namespace softcpu
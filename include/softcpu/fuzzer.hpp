@@ -0,0 +1,95 @@
+#pragma once
+
+#include "softcpu/common.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace softcpu {
+
+// Configuration of a fuzzing campaign
+struct FuzzOptions {
+  std::vector<std::uint8_t> image;     // Program under test
+  std::uint16_t origin{kResetVector};  // Load address of the image
+  std::uint16_t entry{kResetVector};   // Initial PC
+  std::uint16_t input_address{0};      // Region the input is written to
+  std::size_t input_length{0};         // Region size; the tail is zeroed
+  std::uint64_t cycle_budget{100000};  // Cycles per execution
+  std::uint16_t stack_floor{0xF000};   // SP below this is a stack escape
+  std::uint16_t stack_ceiling{kStackReset}; // SP above this is an escape
+  unsigned jobs{1};                    // Worker threads
+  std::uint64_t max_execs{0};          // Stop after this many (0: no limit)
+  double max_seconds{0.0};             // Stop after this long (0: no limit)
+  std::uint64_t seed{1};               // Mutation RNG seed
+  std::string output_dir;              // queue/ and crashes/ go here
+  std::vector<std::vector<std::uint8_t>> seeds; // Initial corpus
+};
+
+// Progress of a campaign
+struct FuzzStats {
+  std::uint64_t execs{0};
+  std::uint64_t crashes{0};     // Distinct crash signatures
+  std::size_t corpus_size{0};
+  std::size_t edges{0};         // Edge buckets seen so far
+  double seconds{0.0};
+};
+
+// Coverage-guided fuzzer running one Emulator per worker thread. Every
+// execution restores a memory snapshot, writes the mutated input into the
+// input region, and runs under a cycle budget with edge coverage enabled.
+// Inputs reaching new (edge, hit-count bucket) pairs join a shared corpus.
+// Faults and stack escapes are crashes; the first input for each
+// (kind, PC) signature is minimized and saved.
+class Fuzzer {
+public:
+  explicit Fuzzer(FuzzOptions options);
+
+  // Run the campaign until a limit is reached or stop() is called. Calls
+  // `progress` about once a second from the calling thread.
+  FuzzStats run(const std::function<void(const FuzzStats &)> &progress = {});
+
+  // Ask workers to finish (e.g., from a signal handler)
+  void stop() { stop_ = true; }
+
+private:
+  struct Crash {
+    bool found{false};
+    std::uint8_t kind{0};
+    std::uint16_t address{0};
+  };
+
+  class Worker;
+  friend class Worker;
+
+  // Merge a bucketed coverage map; returns true if it adds anything new
+  bool mergeCoverage(const std::uint8_t *map);
+
+  // Append to the corpus and save the input under queue/
+  void addToCorpus(const std::vector<std::uint8_t> &input);
+
+  // Record a crash signature; returns true if it was not seen before
+  bool claimCrash(const Crash &crash);
+
+  // Save a minimized reproducer under crashes/
+  void saveCrash(const Crash &crash, const std::vector<std::uint8_t> &input);
+
+  FuzzStats snapshotStats() const;
+
+  FuzzOptions options_;
+  std::atomic<bool> stop_{false};
+  std::atomic<std::uint64_t> execs_{0};
+  std::atomic<std::uint64_t> corpus_generation_{0};
+
+  mutable std::mutex mutex_; // Guards everything below
+  std::vector<std::uint8_t> virgin_; // Buckets seen per edge (bit set)
+  std::size_t edges_{0};
+  std::vector<std::vector<std::uint8_t>> corpus_;
+  std::vector<std::uint32_t> crash_signatures_;
+};
+
+} // namespace softcpu
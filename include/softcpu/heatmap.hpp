@@ -0,0 +1,67 @@
+#pragma once
+
+#include "softcpu/common.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace softcpu {
+
+// Kind of bus access counted by the heatmap
+enum class AccessKind : std::uint8_t { Fetch = 0, Read = 1, Write = 2 };
+
+// Number of AccessKind values
+inline constexpr std::size_t kAccessKinds = 3;
+
+// Per-page and per-word access counters fed by the Bus. Counting is a few
+// array increments per access, cheap enough to leave on for batch runs.
+class MemoryHeatmap {
+public:
+  static constexpr std::size_t kPages = kMemorySize / 256;
+  static constexpr std::size_t kWords = kMemorySize / 2;
+
+  // Access counts of one page, split by RAM and device window
+  struct PageCounts {
+    std::array<std::uint64_t, kAccessKinds> ram{};
+    std::array<std::uint64_t, kAccessKinds> device{};
+  };
+
+  MemoryHeatmap();
+
+  // Count one access at `address`; a 16-bit access counts once
+  void record(std::uint16_t address, AccessKind kind, bool device) {
+    auto &page = pages_[address >> 8];
+    ++(device ? page.device : page.ram)[static_cast<std::size_t>(kind)];
+    ++words_[address >> 1][static_cast<std::size_t>(kind)];
+  }
+
+  // Count a block transfer on RAM as one access per word touched
+  void recordRange(std::uint16_t address, std::size_t length, AccessKind kind);
+
+  // Zero every counter
+  void clear();
+
+  const PageCounts &page(std::size_t index) const { return pages_[index]; }
+  std::uint64_t word(std::size_t index, AccessKind kind) const {
+    return words_[index][static_cast<std::size_t>(kind)];
+  }
+
+  // Write one row per page: page,base,fetch,read,write for RAM and devices
+  bool writePageCsv(const std::string &path) const;
+
+  // Write one row per word with any accesses: address,fetch,read,write
+  bool writeWordCsv(const std::string &path) const;
+
+  // Write a 128x256 binary PPM with one pixel per word (one row per page).
+  // Red, green and blue show writes, reads and fetches on a log scale.
+  bool writePpm(const std::string &path) const;
+
+private:
+  std::array<PageCounts, kPages> pages_{};
+  std::vector<std::array<std::uint64_t, kAccessKinds>> words_;
+};
+
+} // namespace softcpu
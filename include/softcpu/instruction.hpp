@@ -40,7 +40,238 @@ enum class Opcode : std::uint8_t {
   OUT = 0x1C,   // Output to Port
   IN = 0x1D,    // Input from Port
   ADJSP = 0x1E, // Adjust Stack Pointer
-  SYS = 0x1F    // System Call
+  SYS = 0x1F,   // System Call
+  MEMCPY = 0x20, // Copy a block of bytes
+  MEMSET = 0x21, // Fill a block of bytes
+  MEMCMP = 0x22, // Compare two blocks of bytes
+  EI = 0x23,     // Enable interrupts
+  DI = 0x24,     // Disable interrupts
+  RETI = 0x25,   // Return from interrupt handler
+  WAIT = 0x26,   // Idle until an interrupt is pending
+  CAS = 0x27,    // Atomic compare-and-swap of a memory word
+  FADD = 0x28,   // Atomic fetch-and-add of a memory word
+  ADC = 0x29,    // Add with carry
+  SBC = 0x2A,    // Subtract with borrow
+  MULH = 0x2B,   // Multiply, signed upper word
+  MULHU = 0x2C,  // Multiply, unsigned upper word
+  DIVMOD = 0x2D, // Divide with remainder
+  JNC = 0x30,    // Jump if no carry
+  JNN = 0x31,    // Jump if not negative
+  JV = 0x32,     // Jump if overflow
+  JNV = 0x33,    // Jump if no overflow
+  JLT = 0x34,    // Jump if signed less
+  JGE = 0x35,    // Jump if signed greater or equal
+  JGT = 0x36,    // Jump if signed greater
+  JLE = 0x37,    // Jump if signed less or equal
+  JB = 0x38,     // Jump if unsigned below
+  JAE = 0x39,    // Jump if unsigned above or equal
+  JA = 0x3A,     // Jump if unsigned above
+  JBE = 0x3B,    // Jump if unsigned below or equal
+  BEQ = 0x3C,    // Compare and branch if equal
+  BNE = 0x3D,    // Compare and branch if not equal
+  BLT = 0x3E,    // Compare and branch if signed less
+  ROL = 0x40,    // Rotate left
+  ROR = 0x41,    // Rotate right
+  SAR = 0x42,    // Arithmetic shift right
+  POPCNT = 0x43, // Count set bits
+  CLZ = 0x44,    // Count leading zeros
+  CTZ = 0x45,    // Count trailing zeros
+  BSWAP = 0x46,  // Swap bytes
+  BTST = 0x47,   // Test bit
+  BSET = 0x48,   // Set bit
+  BCLR = 0x49,   // Clear bit
+  PADDB = 0x50,  // Packed byte add
+  PADDUSB = 0x51, // Packed byte add, unsigned saturating
+  PSUBB = 0x52,  // Packed byte subtract
+  PSUBUSB = 0x53, // Packed byte subtract, unsigned saturating
+  PCMPEQB = 0x54, // Packed byte compare equal to mask
+  PCMPHIB = 0x55, // Packed byte compare unsigned higher to mask
+  PMINUB = 0x56, // Packed byte unsigned minimum
+  PMAXUB = 0x57, // Packed byte unsigned maximum
+  PACKUSB = 0x58, // Pack two words into bytes, unsigned saturating
+  UNPKB = 0x59,  // Unpack two bytes into words
+  MULQ = 0x60,   // Q1.15 multiply, rounded
+  MULQ8 = 0x61,  // Q8.8 multiply, rounded
+  ADDS = 0x62,   // Add, signed saturating
+  SUBS = 0x63,   // Subtract, signed saturating
+  ABS = 0x64,    // Absolute value, saturating
+  NEG = 0x65     // Two's complement negate
+};
+
+// Instructions without a modifier register (see usesModifierRegister) may
+// auto-index a register-indirect operand: modifier bits 1..0 select the mode
+// and bit 2 makes the step one byte instead of a word. The mode applies to
+// operand B when it is register indirect, otherwise to operand A.
+constexpr std::uint8_t kAutoIndexMask = 0x03;
+constexpr std::uint8_t kAutoIndexByteStep = 0x04;
+
+// LOAD and STORE access a single byte when modifier bit 3 is set. Bit 2
+// then sign-extends a loaded byte instead of selecting the auto-index step,
+// which is always one byte for byte accesses.
+constexpr std::uint8_t kByteAccess = 0x08;
+constexpr std::uint8_t kSignExtend = 0x04;
+
+// Predicate in modifier bits 7..4: the instruction executes only when the
+// condition holds. After CMP a, b the unsigned conditions read C as
+// no-borrow (C means a >= b) and the signed ones compare N with V.
+enum class Condition : std::uint8_t {
+  Always = 0,
+  Z = 1,   // Zero (EQ)
+  NZ = 2,  // Not zero (NE)
+  N = 3,   // Negative (MI)
+  NN = 4,  // Not negative (PL)
+  C = 5,   // Carry (HS: unsigned a >= b)
+  NC = 6,  // No carry (LO: unsigned a < b)
+  V = 7,   // Overflow (VS)
+  NV = 8,  // No overflow (VC)
+  LT = 9,  // Signed a < b: N != V
+  GE = 10, // Signed a >= b: N == V
+  GT = 11, // Signed a > b: !Z && N == V
+  LE = 12, // Signed a <= b: Z || N != V
+  HI = 13, // Unsigned a > b: C && !Z
+  LS = 14  // Unsigned a <= b: !C || Z
+  // 15 is reserved and never holds
+};
+constexpr std::uint8_t kConditionShift = 4;
+
+inline Condition conditionOf(std::uint8_t modifier) {
+  return static_cast<Condition>(modifier >> kConditionShift);
+}
+
+// True if `condition` holds for `flags`
+inline bool conditionHolds(Condition condition, const FlagRegister &flags) {
+  const bool z = flags.test(StatusFlag::kZero);
+  const bool n = flags.test(StatusFlag::kNegative);
+  const bool c = flags.test(StatusFlag::kCarry);
+  const bool v = flags.test(StatusFlag::kOverflow);
+  switch (condition) {
+  case Condition::Always:
+    return true;
+  case Condition::Z:
+    return z;
+  case Condition::NZ:
+    return !z;
+  case Condition::N:
+    return n;
+  case Condition::NN:
+    return !n;
+  case Condition::C:
+    return c;
+  case Condition::NC:
+    return !c;
+  case Condition::V:
+    return v;
+  case Condition::NV:
+    return !v;
+  case Condition::LT:
+    return n != v;
+  case Condition::GE:
+    return n == v;
+  case Condition::GT:
+    return !z && n == v;
+  case Condition::LE:
+    return z || n != v;
+  case Condition::HI:
+    return c && !z;
+  case Condition::LS:
+    return !c || z;
+  }
+  return false;
+}
+
+// Assembler suffix of a condition ("" for Always)
+inline const char *conditionName(Condition condition) {
+  switch (condition) {
+  case Condition::Always:
+    return "";
+  case Condition::Z:
+    return "Z";
+  case Condition::NZ:
+    return "NZ";
+  case Condition::N:
+    return "N";
+  case Condition::NN:
+    return "NN";
+  case Condition::C:
+    return "C";
+  case Condition::NC:
+    return "NC";
+  case Condition::V:
+    return "V";
+  case Condition::NV:
+    return "NV";
+  case Condition::LT:
+    return "LT";
+  case Condition::GE:
+    return "GE";
+  case Condition::GT:
+    return "GT";
+  case Condition::LE:
+    return "LE";
+  case Condition::HI:
+    return "HI";
+  case Condition::LS:
+    return "LS";
+  }
+  return "?";
+}
+
+// Flag condition tested by a conditional jump (Always for other opcodes)
+inline Condition branchCondition(Opcode opcode) {
+  switch (opcode) {
+  case Opcode::JZ:
+    return Condition::Z;
+  case Opcode::JNZ:
+    return Condition::NZ;
+  case Opcode::JN:
+    return Condition::N;
+  case Opcode::JNN:
+    return Condition::NN;
+  case Opcode::JC:
+  case Opcode::JAE:
+    return Condition::C;
+  case Opcode::JNC:
+  case Opcode::JB:
+    return Condition::NC;
+  case Opcode::JV:
+    return Condition::V;
+  case Opcode::JNV:
+    return Condition::NV;
+  case Opcode::JLT:
+    return Condition::LT;
+  case Opcode::JGE:
+    return Condition::GE;
+  case Opcode::JGT:
+    return Condition::GT;
+  case Opcode::JLE:
+    return Condition::LE;
+  case Opcode::JA:
+    return Condition::HI;
+  case Opcode::JBE:
+    return Condition::LS;
+  default:
+    return Condition::Always;
+  }
+}
+
+// BEQ/BNE/BLT a, b, target: compare two operands and branch to a trailing
+// target word without touching the flags
+inline bool isCompareBranch(Opcode opcode) {
+  return opcode == Opcode::BEQ || opcode == Opcode::BNE ||
+         opcode == Opcode::BLT;
+}
+
+// True for jumps taken only when a condition holds
+inline bool isConditionalBranch(Opcode opcode) {
+  return branchCondition(opcode) != Condition::Always ||
+         isCompareBranch(opcode);
+}
+
+// Register update of an auto-indexed operand
+enum class AutoIndex : std::uint8_t {
+  None = 0,
+  PostIncrement = 1, // [r]+: access at r, then add the step
+  PreDecrement = 2   // -[r]: subtract the step, then access at r
 };
 
 // Types of operands supported by the instruction set
@@ -67,6 +298,8 @@ struct Operand {
   std::uint16_t value{0};
   std::int16_t offset{0};
   bool has_offset{false};
+  AutoIndex auto_index{AutoIndex::None};
+  std::uint8_t step{0}; // Bytes added or subtracted by auto-indexing
 };
 
 // Encode an operand type and payload into a single byte
@@ -93,6 +326,26 @@ inline bool operandNeedsWord(OperandType type) {
   }
 }
 
+// Modifier bits naming a third register: the count of the block
+// instructions (MEMCPY/MEMSET/MEMCMP), the expected value of CAS, the
+// remainder of DIVMOD and the high byte of UNPKB
+constexpr std::uint8_t kModifierRegisterMask = 0x07;
+
+// True for instructions whose modifier bits 2..0 name a register
+inline bool usesModifierRegister(Opcode opcode) {
+  switch (opcode) {
+  case Opcode::MEMCPY:
+  case Opcode::MEMSET:
+  case Opcode::MEMCMP:
+  case Opcode::CAS:
+  case Opcode::DIVMOD:
+  case Opcode::UNPKB:
+    return true;
+  default:
+    return false;
+  }
+}
+
 // Get the string representation of an opcode
 inline const char *opcodeName(Opcode opcode) {
   switch (opcode) {
@@ -160,8 +413,123 @@ inline const char *opcodeName(Opcode opcode) {
     return "ADJSP";
   case Opcode::SYS:
     return "SYS";
+  case Opcode::MEMCPY:
+    return "MEMCPY";
+  case Opcode::MEMSET:
+    return "MEMSET";
+  case Opcode::MEMCMP:
+    return "MEMCMP";
+  case Opcode::EI:
+    return "EI";
+  case Opcode::DI:
+    return "DI";
+  case Opcode::RETI:
+    return "RETI";
+  case Opcode::WAIT:
+    return "WAIT";
+  case Opcode::CAS:
+    return "CAS";
+  case Opcode::FADD:
+    return "FADD";
+  case Opcode::ADC:
+    return "ADC";
+  case Opcode::SBC:
+    return "SBC";
+  case Opcode::MULH:
+    return "MULH";
+  case Opcode::MULHU:
+    return "MULHU";
+  case Opcode::DIVMOD:
+    return "DIVMOD";
+  case Opcode::JNC:
+    return "JNC";
+  case Opcode::JNN:
+    return "JNN";
+  case Opcode::JV:
+    return "JV";
+  case Opcode::JNV:
+    return "JNV";
+  case Opcode::JLT:
+    return "JLT";
+  case Opcode::JGE:
+    return "JGE";
+  case Opcode::JGT:
+    return "JGT";
+  case Opcode::JLE:
+    return "JLE";
+  case Opcode::JB:
+    return "JB";
+  case Opcode::JAE:
+    return "JAE";
+  case Opcode::JA:
+    return "JA";
+  case Opcode::JBE:
+    return "JBE";
+  case Opcode::BEQ:
+    return "BEQ";
+  case Opcode::BNE:
+    return "BNE";
+  case Opcode::BLT:
+    return "BLT";
+  case Opcode::ROL:
+    return "ROL";
+  case Opcode::ROR:
+    return "ROR";
+  case Opcode::SAR:
+    return "SAR";
+  case Opcode::POPCNT:
+    return "POPCNT";
+  case Opcode::CLZ:
+    return "CLZ";
+  case Opcode::CTZ:
+    return "CTZ";
+  case Opcode::BSWAP:
+    return "BSWAP";
+  case Opcode::BTST:
+    return "BTST";
+  case Opcode::BSET:
+    return "BSET";
+  case Opcode::BCLR:
+    return "BCLR";
+  case Opcode::PADDB:
+    return "PADDB";
+  case Opcode::PADDUSB:
+    return "PADDUSB";
+  case Opcode::PSUBB:
+    return "PSUBB";
+  case Opcode::PSUBUSB:
+    return "PSUBUSB";
+  case Opcode::PCMPEQB:
+    return "PCMPEQB";
+  case Opcode::PCMPHIB:
+    return "PCMPHIB";
+  case Opcode::PMINUB:
+    return "PMINUB";
+  case Opcode::PMAXUB:
+    return "PMAXUB";
+  case Opcode::PACKUSB:
+    return "PACKUSB";
+  case Opcode::UNPKB:
+    return "UNPKB";
+  case Opcode::MULQ:
+    return "MULQ";
+  case Opcode::MULQ8:
+    return "MULQ8";
+  case Opcode::ADDS:
+    return "ADDS";
+  case Opcode::SUBS:
+    return "SUBS";
+  case Opcode::ABS:
+    return "ABS";
+  case Opcode::NEG:
+    return "NEG";
   }
   return "?";
 }
 
+// True if `value` encodes an opcode the CPU executes
+inline bool isKnownOpcode(std::uint8_t value) {
+  return opcodeName(static_cast<Opcode>(value))[0] != '?';
+}
+
 } // namespace softcpu
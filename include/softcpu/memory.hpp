@@ -31,8 +31,13 @@ public:
   // Access the raw memory array
   const std::array<std::uint8_t, kMemorySize> &bytes() const { return bytes_; }
 
+  // Raw host pointer to the first byte, for block transfers
+  std::uint8_t *data() { return bytes_.data(); }
+  const std::uint8_t *data() const { return bytes_.data(); }
+
 private:
-  std::array<std::uint8_t, kMemorySize> bytes_{};
+  // Word aligned so that atomic instructions can use host atomics
+  alignas(std::uint64_t) std::array<std::uint8_t, kMemorySize> bytes_{};
 };
 
 } // namespace softcpu
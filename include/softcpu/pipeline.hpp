@@ -0,0 +1,102 @@
+#pragma once
+
+#include "softcpu/cpu.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace softcpu {
+
+// Direction predictors for conditional branches
+enum class PredictorKind : std::uint8_t {
+  Static, // Backward taken, forward not taken
+  TwoBit, // Per-branch 2-bit saturating counters
+  Gshare  // 2-bit counters indexed by PC xor global history
+};
+
+// Name used on the command line ("static", "2bit", "gshare")
+const char *predictorName(PredictorKind kind);
+
+// Settings of the pipeline timing model
+struct PipelineConfig {
+  PredictorKind predictor{PredictorKind::TwoBit};
+  bool forwarding{true};     // EX/MEM results bypass the register file
+  unsigned table_bits{10};   // log2 of the counter table size
+  unsigned history_bits{10}; // gshare global history length
+};
+
+// Extra cycles charged by the pipeline, split by cause
+struct PipelineStats {
+  std::uint64_t instructions{0};
+  std::uint64_t load_use_cycles{0}; // Waiting on a value loaded from memory
+  std::uint64_t data_cycles{0};     // Other read-after-write hazards
+  std::uint64_t mispredict_cycles{0};
+  std::uint64_t redirect_cycles{0}; // Bubbles behind jumps, calls, returns
+  std::uint64_t branches{0};        // Conditional branches
+  std::uint64_t taken{0};
+  std::uint64_t mispredicts{0};
+
+  std::uint64_t stallCycles() const {
+    return load_use_cycles + data_cycles + mispredict_cycles +
+           redirect_cycles;
+  }
+};
+
+// Timing model of a classic 5-stage in-order pipeline (IF, ID, EX, MEM,
+// WB). Instructions still execute atomically; after each one retires the
+// model works out when it could have entered EX and returns the cycles lost
+// to hazards, which the CPU charges like bus stalls.
+//
+// - Data hazards: registers R0-R7 and the flags. With forwarding only a
+//   value coming from memory stalls the next instruction (one cycle);
+//   without it every consumer waits for write-back.
+// - Control hazards: conditional branches resolve in EX, so a mispredict
+//   costs two cycles; a correctly predicted taken branch and a direct
+//   JMP/CALL cost one (target decoded in ID); RET, RETI and jumps through
+//   a register or memory cost two.
+class PipelineModel {
+public:
+  explicit PipelineModel(const PipelineConfig &config);
+
+  // Table sizes are in range
+  static bool valid(const PipelineConfig &config);
+
+  // Account for `inst`, which left PC at `next_pc`. Returns the stall
+  // cycles it adds on top of its one issue cycle.
+  std::uint64_t retire(const DecodedInstruction &inst, std::uint16_t next_pc);
+
+  // Forget in-flight state and counters; predictor tables are cleared too
+  void clear();
+
+  const PipelineConfig &config() const { return config_; }
+  const PipelineStats &stats() const { return stats_; }
+
+  // Print CPI split by cause. `total_cycles` is the CPU's cycle count over
+  // the same instructions; cycles not explained by the pipeline are shown
+  // as memory and device stalls.
+  void writeReport(std::ostream &out, std::uint64_t total_cycles) const;
+
+private:
+  // Predict and train on a conditional branch; true if predicted correctly
+  bool predict(std::uint16_t pc, std::uint16_t target, bool taken);
+
+  // Counter table index for a branch at `pc`
+  std::size_t tableIndex(std::uint16_t pc) const;
+
+  // Registers R0-R7 plus the flags
+  static constexpr std::size_t kTrackedRegisters = kRegisterCount + 1;
+
+  PipelineConfig config_;
+  PipelineStats stats_;
+  std::vector<std::uint8_t> counters_; // 2-bit saturating counters
+  std::uint32_t history_{0};
+  std::uint64_t clock_{0};  // Cycle the last instruction entered EX
+  std::uint64_t resume_{0}; // Earliest EX cycle after control bubbles
+  std::array<std::uint64_t, kTrackedRegisters> ready_{};
+  std::array<bool, kTrackedRegisters> loaded_{};
+};
+
+} // namespace softcpu
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "softcpu/utils.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+namespace softcpu {
+
+// Totals for one function, keyed by its entry address
+struct FunctionProfile {
+  std::uint16_t entry{0};
+  std::uint64_t calls{0};
+  std::uint64_t inclusive_instructions{0}; // Including callees
+  std::uint64_t inclusive_cycles{0};
+  std::uint64_t exclusive_instructions{0}; // Function body only
+  std::uint64_t exclusive_cycles{0};
+  std::uint16_t max_stack_bytes{0}; // Deepest SP below its value on entry
+};
+
+// Call-graph profiler driven by CALL/RET and interrupt entry/RETI. It keeps
+// a shadow call stack, charges every retired instruction to the function on
+// top of it, and folds callee totals into inclusive counts when frames
+// return. Recursive frames only count once towards inclusive totals.
+class CallProfiler {
+public:
+  // Start a fresh profile with a root frame for code entered at `entry`
+  void reset(std::uint16_t entry, std::uint16_t sp);
+
+  // Control flow events; applied once the current instruction retires so
+  // CALL is charged to the caller and RET to the callee
+  void onCall(std::uint16_t target, std::uint16_t return_address) {
+    pending_ = Pending::Call;
+    pending_target_ = target;
+    pending_return_ = return_address;
+  }
+  void onReturn(std::uint16_t return_address) {
+    pending_ = Pending::Return;
+    pending_return_ = return_address;
+  }
+
+  // Charge one step's cycles to the current function
+  void retire(std::uint64_t cycles, bool instruction, std::uint16_t sp);
+
+  // Per-function totals, open frames included, by descending inclusive cycles
+  std::vector<FunctionProfile> functions() const;
+
+  // Deepest shadow call stack seen
+  std::size_t maxCallDepth() const { return max_depth_; }
+
+  // Largest distance SP moved below its value at reset
+  std::uint16_t maxStackBytes() const { return max_stack_bytes_; }
+
+  // Print a table of functions, naming entry points from `symbols`
+  void writeReport(std::ostream &out, const util::SymbolMap &symbols) const;
+
+private:
+  enum class Pending : std::uint8_t { None, Call, Return };
+
+  struct Activity {
+    FunctionProfile profile;
+    std::size_t active{0}; // Frames of this function on the shadow stack
+  };
+
+  struct Frame {
+    Activity *function{nullptr};
+    std::uint16_t return_address{0};
+    std::uint16_t entry_sp{0};
+    std::uint16_t min_sp{0};
+    std::uint64_t entry_instructions{0};
+    std::uint64_t entry_cycles{0};
+  };
+
+  void push(std::uint16_t target, std::uint16_t return_address,
+            std::uint16_t sp);
+  void pop();
+
+  std::unordered_map<std::uint16_t, Activity> functions_;
+  std::vector<Frame> stack_;
+  Pending pending_{Pending::None};
+  std::uint16_t pending_target_{0};
+  std::uint16_t pending_return_{0};
+  std::uint16_t base_sp_{0};
+  std::uint16_t max_stack_bytes_{0};
+  std::size_t max_depth_{0};
+  std::uint64_t instructions_{0};
+  std::uint64_t cycles_{0};
+};
+
+} // namespace softcpu
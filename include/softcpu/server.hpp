@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace softcpu {
+
+// Options for the job server
+struct ServerOptions {
+  std::string socket_path;        // Unix domain socket to listen on
+  unsigned workers{4};            // Pre-constructed emulators / threads
+  std::size_t console_capacity{65536}; // Console bytes returned per run
+};
+
+// Job server executing run requests on a pool of warm Emulator instances.
+// Each worker thread owns one Emulator and serves one connection at a time;
+// a connection may send any number of requests and gets one response per
+// request, in order. The wire protocol is described in docs/emulator.md.
+class JobServer {
+public:
+  explicit JobServer(ServerOptions options);
+
+  // Bind the socket and serve until stop() is called. Returns false (with a
+  // message in error()) if the socket cannot be set up.
+  bool serve();
+
+  // Stop accepting connections; safe to call from a signal handler
+  void stop() { stop_ = true; }
+
+  const std::string &error() const { return error_; }
+
+  // Contents of an image file, cached until its modification time changes
+  bool loadImage(const std::string &path, std::vector<std::uint8_t> &image);
+
+private:
+  struct CachedImage {
+    std::filesystem::file_time_type modified;
+    std::vector<std::uint8_t> bytes;
+  };
+
+  ServerOptions options_;
+  std::atomic<bool> stop_{false};
+  std::string error_;
+  std::mutex cache_mutex_;
+  std::map<std::string, CachedImage> image_cache_;
+};
+
+} // namespace softcpu
@@ -0,0 +1,122 @@
+/* C interface to the SoftCPU-16 emulator (libsoftcpu).
+ *
+ * The ABI is stable within a major SOFTCPU_ABI_VERSION: functions are only
+ * ever added, and structs passed by pointer are never reordered. Machines are
+ * opaque handles; memory is exposed as a direct pointer to the 64 KiB guest
+ * address space so hosts can read and write it without copies. A machine must
+ * not be used from two threads at once; distinct machines are independent.
+ */
+#ifndef SOFTCPU_SOFTCPU_H
+#define SOFTCPU_SOFTCPU_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32) && defined(SOFTCPU_BUILDING_LIBRARY)
+#define SOFTCPU_API __declspec(dllexport)
+#elif defined(_WIN32)
+#define SOFTCPU_API __declspec(dllimport)
+#else
+#define SOFTCPU_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SOFTCPU_ABI_VERSION 1
+
+/* Size of the guest address space in bytes */
+#define SOFTCPU_MEMORY_SIZE 65536
+
+/* Number of general purpose registers (R7 doubles as the stack pointer) */
+#define SOFTCPU_REGISTER_COUNT 8
+
+typedef struct softcpu_machine softcpu_machine;
+
+/* Why a run returned; values match softcpu::StopReason */
+typedef enum softcpu_stop_reason {
+  SOFTCPU_STOP_HALTED = 0,
+  SOFTCPU_STOP_CYCLE_LIMIT = 1,
+  SOFTCPU_STOP_IDLE = 2,
+  SOFTCPU_STOP_FAULT = 3,
+  SOFTCPU_STOP_STACK_ESCAPE = 4,
+  SOFTCPU_STOP_BREAKPOINT = 5,
+  SOFTCPU_STOP_WATCHPOINT = 6
+} softcpu_stop_reason;
+
+/* Outcome of one run */
+typedef struct softcpu_run_result {
+  int32_t reason;        /* softcpu_stop_reason */
+  uint16_t stop_address; /* Fault PC, breakpoint PC, ... (see RunStats) */
+  uint16_t reserved;
+  uint64_t cycles;       /* Cycles executed by this run */
+  uint64_t instructions; /* Instructions retired by this run */
+} softcpu_run_result;
+
+/* ABI version the library was built with */
+SOFTCPU_API int softcpu_abi_version(void);
+
+/* Create a machine with the default devices, reset and with zeroed memory.
+ * Console output is discarded until softcpu_capture_console is called.
+ * Returns NULL if the machine cannot be allocated or constructed. */
+SOFTCPU_API softcpu_machine *softcpu_create(void);
+SOFTCPU_API void softcpu_destroy(softcpu_machine *machine);
+
+/* Zero memory and reset the CPU and devices */
+SOFTCPU_API void softcpu_reset(softcpu_machine *machine);
+
+/* Copy an image into memory at `origin`. Returns 0 on success, -1 if it
+ * would run past the end of memory. */
+SOFTCPU_API int softcpu_load(softcpu_machine *machine, const uint8_t *image,
+                             size_t size, uint16_t origin);
+
+/* Direct pointer to the SOFTCPU_MEMORY_SIZE bytes of guest memory. Valid for
+ * the lifetime of the machine. Device registers are not part of it. */
+SOFTCPU_API uint8_t *softcpu_memory(softcpu_machine *machine);
+
+/* Registers; index 7 is the stack pointer, as in instructions */
+SOFTCPU_API uint16_t softcpu_get_register(const softcpu_machine *machine,
+                                          unsigned index);
+SOFTCPU_API void softcpu_set_register(softcpu_machine *machine, unsigned index,
+                                      uint16_t value);
+SOFTCPU_API uint16_t softcpu_get_pc(const softcpu_machine *machine);
+SOFTCPU_API void softcpu_set_pc(softcpu_machine *machine, uint16_t value);
+SOFTCPU_API uint16_t softcpu_get_sp(const softcpu_machine *machine);
+SOFTCPU_API void softcpu_set_sp(softcpu_machine *machine, uint16_t value);
+SOFTCPU_API uint16_t softcpu_get_flags(const softcpu_machine *machine);
+SOFTCPU_API void softcpu_set_flags(softcpu_machine *machine, uint16_t value);
+
+/* Cycles and instructions since the last reset */
+SOFTCPU_API uint64_t softcpu_cycles(const softcpu_machine *machine);
+SOFTCPU_API uint64_t softcpu_instructions(const softcpu_machine *machine);
+
+/* Run for at most `cycles` cycles (0 = until the machine stops) */
+SOFTCPU_API softcpu_stop_reason softcpu_run(softcpu_machine *machine,
+                                            uint64_t cycles,
+                                            softcpu_run_result *result);
+
+/* Run `count` machines for up to `cycles` each, writing one result per
+ * machine (results may be NULL). With `threads` > 1 the machines are split
+ * across that many host threads; otherwise they run in order. Machines whose
+ * thread cannot be started run on the calling thread instead. */
+SOFTCPU_API void softcpu_run_batch(softcpu_machine *const *machines,
+                                   size_t count, uint64_t cycles,
+                                   unsigned threads,
+                                   softcpu_run_result *results);
+
+/* Capture console output in a buffer of `capacity` bytes (0 discards it) */
+SOFTCPU_API void softcpu_capture_console(softcpu_machine *machine,
+                                         size_t capacity);
+
+/* Console bytes captured so far; the pointer stays valid until the next
+ * run, softcpu_clear_console or softcpu_capture_console call */
+SOFTCPU_API const char *softcpu_console_output(const softcpu_machine *machine,
+                                               size_t *size);
+SOFTCPU_API void softcpu_clear_console(softcpu_machine *machine);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOFTCPU_SOFTCPU_H */
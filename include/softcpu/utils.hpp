@@ -1,9 +1,11 @@
 #pragma once
 
 #include <cstdint>
+#include <map>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 namespace softcpu::util {
@@ -25,4 +27,32 @@ std::vector<std::uint8_t> readBinaryFile(const std::string &path);
 bool writeBinaryFile(const std::string &path,
                      const std::vector<std::uint8_t> &data);
 
+// Address to name lookup loaded from a symbol map
+using SymbolMap = std::map<std::uint16_t, std::string>;
+
+// Write a symbol map: one "0xADDR name" line per label
+bool writeSymbolMap(
+    const std::string &path,
+    const std::vector<std::pair<std::string, std::uint16_t>> &labels);
+
+// Read a symbol map written by writeSymbolMap. When several labels share an
+// address the first one wins. Returns nullopt if the file cannot be read.
+std::optional<SymbolMap> readSymbolMap(const std::string &path);
+
+// Bytes destined for a physical address (e.g., a banked section)
+struct PhysicalBlock {
+  std::uint32_t address{0};
+  std::vector<std::uint8_t> bytes;
+};
+
+// Write blocks as a bank file: per block a little-endian 32-bit physical
+// address and 32-bit length, followed by the bytes
+bool writeBankFile(const std::string &path,
+                   const std::vector<PhysicalBlock> &blocks);
+
+// Read a bank file written by writeBankFile. Returns nullopt if the file
+// cannot be read or is truncated.
+std::optional<std::vector<PhysicalBlock>>
+readBankFile(const std::string &path);
+
 } // namespace softcpu::util
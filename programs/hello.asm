@@ -5,11 +5,10 @@
 start:
         LDI r0, #message
 next_char:
-        LOAD r1, [r0]
+        LOAD.B r1, [r0]+
         CMP r1, #0
         JZ done
         STORE r1, [IO_CONSOLE_DATA]
-        ADDI r0, #1
         JMP next_char
 
 done:
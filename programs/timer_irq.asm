@@ -0,0 +1,26 @@
+; Interrupt-driven LED counter: the CPU sleeps in WAIT between timer ticks
+.const IRQ_TIMER_BIT 0x01
+
+        .org 0x0000
+start:
+        LDI r0, #on_timer
+        STORE r0, [IO_IRQ_VECTORS]  ; vector for line 0 (timer)
+        LDI r0, #IRQ_TIMER_BIT
+        STORE r0, [IO_IRQ_MASK]
+        LDI r0, #0x1000             ; timer period (4096 cycles)
+        STORE r0, [IO_TIMER_PERIOD]
+        LDI r0, #0x0000             ; compare match when the counter reloads
+        STORE r0, [IO_TIMER_COMPARE]
+        LDI r0, #0x0007             ; enable | auto reload | compare interrupt
+        STORE r0, [IO_TIMER_CONTROL]
+        LDI r1, #0
+        EI
+
+idle:
+        WAIT                        ; sleep until the next timer interrupt
+        JMP idle
+
+on_timer:
+        ADDI r1, #1
+        STORE r1, [IO_LED]
+        RETI
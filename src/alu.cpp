@@ -1,9 +1,55 @@
 #include "softcpu/alu.hpp"
 
+#include <algorithm>
+#include <bit>
+
 namespace softcpu {
 
 namespace {
 
+// Zero and negative from `value`; carry as given, overflow clear
+FlagRegister logicFlags(std::uint16_t value, bool carry) {
+  FlagRegister flags;
+  flags.set(StatusFlag::kZero, value == 0);
+  flags.set(StatusFlag::kNegative, (value & 0x8000) != 0);
+  flags.set(StatusFlag::kCarry, carry);
+  flags.set(StatusFlag::kOverflow, false);
+  return flags;
+}
+
+// Flags of the bit-test family: C is the old bit, Z is set when it was clear
+FlagRegister bitFlags(bool old_bit) {
+  FlagRegister flags;
+  flags.set(StatusFlag::kZero, !old_bit);
+  flags.set(StatusFlag::kCarry, old_bit);
+  return flags;
+}
+
+// Applies `op(lhs_lane, rhs_lane, carry)` to both byte lanes; the op sets
+// `carry` when its lane carried or saturated
+template <typename LaneOp>
+ALUResult laneWise(std::uint16_t lhs, std::uint16_t rhs, LaneOp op) {
+  bool carry = false;
+  std::uint16_t result = 0;
+  for (const unsigned shift : {0u, 8u}) {
+    const std::uint8_t lane =
+        op(static_cast<std::uint8_t>(lhs >> shift),
+           static_cast<std::uint8_t>(rhs >> shift), carry);
+    result = static_cast<std::uint16_t>(result | (lane << shift));
+  }
+  return {result, logicFlags(result, carry)};
+}
+
+// Lane mask from a per-lane predicate; C is set when both lanes match
+template <typename LanePredicate>
+ALUResult laneMask(std::uint16_t lhs, std::uint16_t rhs, LanePredicate pred) {
+  auto result = laneWise(lhs, rhs, [&](std::uint8_t a, std::uint8_t b, bool &) {
+    return static_cast<std::uint8_t>(pred(a, b) ? 0xFF : 0x00);
+  });
+  result.flags.set(StatusFlag::kCarry, result.value == 0xFFFF);
+  return result;
+}
+
 // Helper function to update Zero, Negative, Carry, and Overflow flags
 FlagRegister updateCommonFlags(std::uint32_t result, bool carry,
                                bool overflow) {
@@ -32,11 +78,13 @@ ALUResult ALU::add(std::uint16_t lhs, std::uint16_t rhs,
           updateCommonFlags(wide, carry, overflow)};
 }
 
-ALUResult ALU::sub(std::uint16_t lhs, std::uint16_t rhs) const {
-  const std::uint32_t wide =
-      static_cast<std::uint32_t>(lhs) - static_cast<std::uint32_t>(rhs);
-  // Carry flag is set if no borrow occurred (lhs >= rhs)
-  const bool carry = lhs >= rhs;
+ALUResult ALU::sub(std::uint16_t lhs, std::uint16_t rhs,
+                   bool with_borrow) const {
+  const std::uint32_t borrow_in = with_borrow ? 1 : 0;
+  const std::uint32_t wide = static_cast<std::uint32_t>(lhs) -
+                             static_cast<std::uint32_t>(rhs) - borrow_in;
+  // Carry flag is set if no borrow occurred (lhs >= rhs + borrow)
+  const bool carry = std::uint32_t{lhs} >= std::uint32_t{rhs} + borrow_in;
   // Overflow occurs if operands have different signs and result has different
   // sign than lhs
   const bool overflow =
@@ -112,6 +160,122 @@ ALUResult ALU::shr(std::uint16_t value, std::uint8_t amount) const {
   return {result, flags};
 }
 
+ALUResult ALU::rol(std::uint16_t value, std::uint8_t amount) const {
+  amount %= 16;
+  const auto result = std::rotl(value, amount);
+  return {result, logicFlags(result, amount != 0 && (result & 0x1) != 0)};
+}
+
+ALUResult ALU::ror(std::uint16_t value, std::uint8_t amount) const {
+  amount %= 16;
+  const auto result = std::rotr(value, amount);
+  return {result, logicFlags(result, amount != 0 && (result & 0x8000) != 0)};
+}
+
+ALUResult ALU::sar(std::uint16_t value, std::uint8_t amount) const {
+  amount %= 16;
+  const auto result = static_cast<std::uint16_t>(
+      static_cast<std::int16_t>(value) >> amount);
+  const bool carry = amount != 0 && ((value >> (amount - 1)) & 0x1) != 0;
+  return {result, logicFlags(result, carry)};
+}
+
+ALUResult ALU::popcnt(std::uint16_t value) const {
+  const auto result = static_cast<std::uint16_t>(std::popcount(value));
+  return {result, logicFlags(result, false)};
+}
+
+ALUResult ALU::clz(std::uint16_t value) const {
+  const auto result = static_cast<std::uint16_t>(std::countl_zero(value));
+  return {result, logicFlags(result, value == 0)};
+}
+
+ALUResult ALU::ctz(std::uint16_t value) const {
+  const auto result = static_cast<std::uint16_t>(std::countr_zero(value));
+  return {result, logicFlags(result, value == 0)};
+}
+
+ALUResult ALU::bswap(std::uint16_t value) const {
+  const auto result = static_cast<std::uint16_t>((value << 8) | (value >> 8));
+  return {result, logicFlags(result, false)};
+}
+
+ALUResult ALU::bit_test(std::uint16_t value, std::uint8_t bit) const {
+  const auto mask = static_cast<std::uint16_t>(1u << (bit % 16));
+  return {value, bitFlags((value & mask) != 0)};
+}
+
+ALUResult ALU::bit_set(std::uint16_t value, std::uint8_t bit) const {
+  const auto mask = static_cast<std::uint16_t>(1u << (bit % 16));
+  return {static_cast<std::uint16_t>(value | mask),
+          bitFlags((value & mask) != 0)};
+}
+
+ALUResult ALU::bit_clear(std::uint16_t value, std::uint8_t bit) const {
+  const auto mask = static_cast<std::uint16_t>(1u << (bit % 16));
+  return {static_cast<std::uint16_t>(value & ~mask),
+          bitFlags((value & mask) != 0)};
+}
+
+ALUResult ALU::padd_b(std::uint16_t lhs, std::uint16_t rhs,
+                      bool saturate) const {
+  return laneWise(lhs, rhs, [&](std::uint8_t a, std::uint8_t b, bool &carry) {
+    const unsigned sum = unsigned{a} + unsigned{b};
+    if (sum > 0xFF) {
+      carry = true;
+      return static_cast<std::uint8_t>(saturate ? 0xFF : sum);
+    }
+    return static_cast<std::uint8_t>(sum);
+  });
+}
+
+ALUResult ALU::psub_b(std::uint16_t lhs, std::uint16_t rhs,
+                      bool saturate) const {
+  return laneWise(lhs, rhs, [&](std::uint8_t a, std::uint8_t b, bool &carry) {
+    if (b > a) {
+      carry = true;
+      return static_cast<std::uint8_t>(saturate ? 0 : a - b);
+    }
+    return static_cast<std::uint8_t>(a - b);
+  });
+}
+
+ALUResult ALU::pcmpeq_b(std::uint16_t lhs, std::uint16_t rhs) const {
+  return laneMask(lhs, rhs,
+                  [](std::uint8_t a, std::uint8_t b) { return a == b; });
+}
+
+ALUResult ALU::pcmphi_b(std::uint16_t lhs, std::uint16_t rhs) const {
+  return laneMask(lhs, rhs,
+                  [](std::uint8_t a, std::uint8_t b) { return a > b; });
+}
+
+ALUResult ALU::pmin_b(std::uint16_t lhs, std::uint16_t rhs) const {
+  return laneWise(lhs, rhs, [](std::uint8_t a, std::uint8_t b, bool &) {
+    return std::min(a, b);
+  });
+}
+
+ALUResult ALU::pmax_b(std::uint16_t lhs, std::uint16_t rhs) const {
+  return laneWise(lhs, rhs, [](std::uint8_t a, std::uint8_t b, bool &) {
+    return std::max(a, b);
+  });
+}
+
+ALUResult ALU::pack_b(std::uint16_t low, std::uint16_t high) const {
+  bool carry = false;
+  const auto clamp = [&](std::uint16_t word) {
+    const auto value = static_cast<std::int16_t>(word);
+    if (value < 0 || value > 0xFF) {
+      carry = true;
+    }
+    return static_cast<std::uint16_t>(std::clamp<std::int16_t>(value, 0, 0xFF));
+  };
+  const auto result =
+      static_cast<std::uint16_t>(clamp(low) | (clamp(high) << 8));
+  return {result, logicFlags(result, carry)};
+}
+
 ALUResult ALU::mul(std::uint16_t lhs, std::uint16_t rhs) const {
   const std::uint32_t wide =
       static_cast<std::uint32_t>(lhs) * static_cast<std::uint32_t>(rhs);
@@ -120,6 +284,69 @@ ALUResult ALU::mul(std::uint16_t lhs, std::uint16_t rhs) const {
   return {static_cast<std::uint16_t>(wide & 0xFFFF), flags};
 }
 
+ALUResult ALU::mul_high(std::uint16_t lhs, std::uint16_t rhs,
+                        bool is_signed) const {
+  std::uint32_t wide;
+  bool carry;
+  if (is_signed) {
+    const std::int32_t product = std::int32_t{static_cast<std::int16_t>(lhs)} *
+                                 std::int32_t{static_cast<std::int16_t>(rhs)};
+    wide = static_cast<std::uint32_t>(product);
+    // Set when the product does not fit in a signed 16-bit word
+    carry = product != static_cast<std::int16_t>(product);
+  } else {
+    wide = std::uint32_t{lhs} * std::uint32_t{rhs};
+    carry = (wide >> 16) != 0;
+  }
+  FlagRegister flags = updateCommonFlags(wide >> 16, carry, carry);
+  return {static_cast<std::uint16_t>(wide >> 16), flags};
+}
+
+ALUResult ALU::mul_fixed(std::uint16_t lhs, std::uint16_t rhs,
+                         std::uint8_t fraction_bits) const {
+  const std::int32_t product = std::int32_t{static_cast<std::int16_t>(lhs)} *
+                               std::int32_t{static_cast<std::int16_t>(rhs)};
+  // Round half up before dropping the fraction bits; the 32-bit product
+  // cannot overflow when the rounding constant is added
+  const std::int32_t rounded =
+      (product + (std::int32_t{1} << (fraction_bits - 1))) >> fraction_bits;
+  const bool saturated = rounded != static_cast<std::int16_t>(rounded);
+  const auto value = static_cast<std::uint16_t>(
+      std::clamp<std::int32_t>(rounded, -0x8000, 0x7FFF));
+  return {value, updateCommonFlags(value, saturated, saturated)};
+}
+
+ALUResult ALU::add_saturating(std::uint16_t lhs, std::uint16_t rhs) const {
+  auto result = add(lhs, rhs);
+  if (result.flags.test(StatusFlag::kOverflow)) {
+    // Both operands share the sign that the wrapped result lost
+    result.value = (lhs & 0x8000) != 0 ? 0x8000 : 0x7FFF;
+    result.flags.set(StatusFlag::kZero, false);
+    result.flags.set(StatusFlag::kNegative, (result.value & 0x8000) != 0);
+  }
+  return result;
+}
+
+ALUResult ALU::sub_saturating(std::uint16_t lhs, std::uint16_t rhs) const {
+  auto result = sub(lhs, rhs);
+  if (result.flags.test(StatusFlag::kOverflow)) {
+    // The true difference has the sign of lhs
+    result.value = (lhs & 0x8000) != 0 ? 0x8000 : 0x7FFF;
+    result.flags.set(StatusFlag::kZero, false);
+    result.flags.set(StatusFlag::kNegative, (result.value & 0x8000) != 0);
+  }
+  return result;
+}
+
+ALUResult ALU::abs(std::uint16_t value) const {
+  if (value == 0x8000) {
+    return {0x7FFF, updateCommonFlags(0x7FFF, false, true)};
+  }
+  const auto result = static_cast<std::uint16_t>(
+      (value & 0x8000) != 0 ? -static_cast<std::int16_t>(value) : value);
+  return {result, updateCommonFlags(result, false, false)};
+}
+
 ALUResult ALU::divide(std::uint16_t lhs, std::uint16_t rhs) const {
   if (rhs == 0) {
     FlagRegister flags;
@@ -138,4 +365,22 @@ ALUResult ALU::divide(std::uint16_t lhs, std::uint16_t rhs) const {
   return {result, flags};
 }
 
+ALUResult ALU::remainder(std::uint16_t lhs, std::uint16_t rhs) const {
+  if (rhs == 0) {
+    FlagRegister flags;
+    flags.set(StatusFlag::kZero, lhs == 0);
+    flags.set(StatusFlag::kNegative, (lhs & 0x8000) != 0);
+    flags.set(StatusFlag::kCarry, true);
+    flags.set(StatusFlag::kOverflow, true);
+    return {lhs, flags};
+  }
+  const std::uint16_t result = static_cast<std::uint16_t>(lhs % rhs);
+  FlagRegister flags;
+  flags.set(StatusFlag::kZero, result == 0);
+  flags.set(StatusFlag::kNegative, (result & 0x8000) != 0);
+  flags.set(StatusFlag::kCarry, false);
+  flags.set(StatusFlag::kOverflow, false);
+  return {result, flags};
+}
+
 } // namespace softcpu
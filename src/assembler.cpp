@@ -100,6 +100,17 @@ struct OpcodeInfo {
   std::size_t operands;
 };
 
+// Predicate suffixes (.ne, .lt, ...) including the usual aliases
+const std::unordered_map<std::string, Condition> kConditionTable{
+    {"Z", Condition::Z},   {"EQ", Condition::Z},   {"NZ", Condition::NZ},
+    {"NE", Condition::NZ}, {"N", Condition::N},    {"MI", Condition::N},
+    {"NN", Condition::NN}, {"PL", Condition::NN},  {"C", Condition::C},
+    {"HS", Condition::C},  {"NC", Condition::NC},  {"LO", Condition::NC},
+    {"V", Condition::V},   {"VS", Condition::V},   {"NV", Condition::NV},
+    {"VC", Condition::NV}, {"LT", Condition::LT},  {"GE", Condition::GE},
+    {"GT", Condition::GT}, {"LE", Condition::LE},  {"HI", Condition::HI},
+    {"LS", Condition::LS}};
+
 // Table of opcode mnemonics and their operand counts
 const std::unordered_map<std::string, OpcodeInfo> kOpcodeTable{
     {"NOP", {Opcode::NOP, 0}},     {"HALT", {Opcode::HALT, 0}},
@@ -117,7 +128,35 @@ const std::unordered_map<std::string, OpcodeInfo> kOpcodeTable{
     {"CALL", {Opcode::CALL, 1}},   {"RET", {Opcode::RET, 0}},
     {"PUSH", {Opcode::PUSH, 1}},   {"POP", {Opcode::POP, 1}},
     {"OUT", {Opcode::OUT, 2}},     {"IN", {Opcode::IN, 2}},
-    {"ADJSP", {Opcode::ADJSP, 1}}, {"SYS", {Opcode::SYS, 1}}};
+    {"ADJSP", {Opcode::ADJSP, 1}}, {"SYS", {Opcode::SYS, 1}},
+    {"MEMCPY", {Opcode::MEMCPY, 3}}, {"MEMSET", {Opcode::MEMSET, 3}},
+    {"MEMCMP", {Opcode::MEMCMP, 3}}, {"EI", {Opcode::EI, 0}},
+    {"DI", {Opcode::DI, 0}},         {"RETI", {Opcode::RETI, 0}},
+    {"WAIT", {Opcode::WAIT, 0}},     {"CAS", {Opcode::CAS, 3}},
+    {"FADD", {Opcode::FADD, 2}},     {"ADC", {Opcode::ADC, 2}},
+    {"SBC", {Opcode::SBC, 2}},       {"MULH", {Opcode::MULH, 2}},
+    {"MULHU", {Opcode::MULHU, 2}},   {"DIVMOD", {Opcode::DIVMOD, 3}},
+    {"JNC", {Opcode::JNC, 1}},       {"JNN", {Opcode::JNN, 1}},
+    {"JV", {Opcode::JV, 1}},         {"JNV", {Opcode::JNV, 1}},
+    {"JLT", {Opcode::JLT, 1}},       {"JGE", {Opcode::JGE, 1}},
+    {"JGT", {Opcode::JGT, 1}},       {"JLE", {Opcode::JLE, 1}},
+    {"JB", {Opcode::JB, 1}},         {"JAE", {Opcode::JAE, 1}},
+    {"JA", {Opcode::JA, 1}},         {"JBE", {Opcode::JBE, 1}},
+    {"BEQ", {Opcode::BEQ, 3}},       {"BNE", {Opcode::BNE, 3}},
+    {"BLT", {Opcode::BLT, 3}},       {"ROL", {Opcode::ROL, 2}},
+    {"ROR", {Opcode::ROR, 2}},       {"SAR", {Opcode::SAR, 2}},
+    {"POPCNT", {Opcode::POPCNT, 2}}, {"CLZ", {Opcode::CLZ, 2}},
+    {"CTZ", {Opcode::CTZ, 2}},       {"BSWAP", {Opcode::BSWAP, 1}},
+    {"BTST", {Opcode::BTST, 2}},     {"BSET", {Opcode::BSET, 2}},
+    {"BCLR", {Opcode::BCLR, 2}},     {"PADDB", {Opcode::PADDB, 2}},
+    {"PADDUSB", {Opcode::PADDUSB, 2}}, {"PSUBB", {Opcode::PSUBB, 2}},
+    {"PSUBUSB", {Opcode::PSUBUSB, 2}}, {"PCMPEQB", {Opcode::PCMPEQB, 2}},
+    {"PCMPHIB", {Opcode::PCMPHIB, 2}}, {"PMINUB", {Opcode::PMINUB, 2}},
+    {"PMAXUB", {Opcode::PMAXUB, 2}},   {"PACKUSB", {Opcode::PACKUSB, 2}},
+    {"UNPKB", {Opcode::UNPKB, 3}},     {"MULQ", {Opcode::MULQ, 2}},
+    {"MULQ8", {Opcode::MULQ8, 2}},     {"ADDS", {Opcode::ADDS, 2}},
+    {"SUBS", {Opcode::SUBS, 2}},       {"ABS", {Opcode::ABS, 1}},
+    {"NEG", {Opcode::NEG, 1}}};
 
 } // namespace
 
@@ -125,7 +164,7 @@ AssemblyResult Assembler::assembleFile(const std::string &path,
                                        const AssemblerOptions &options) {
   std::ifstream input(path);
   if (!input) {
-    return {false, {}, {"unable to open " + path}};
+    return {false, {}, {"unable to open " + path}, {}, {}};
   }
 
   std::vector<LineRecord> lines;
@@ -153,6 +192,9 @@ AssemblyResult Assembler::assemble(const std::vector<LineRecord> &lines,
                                    const AssemblerOptions &options) {
   symbols_.clear();
   errors_.clear();
+  labels_.clear();
+  banks_.clear();
+  current_bank_ = 0;
   origin_ = options.origin;
   std::uint16_t location_counter = origin_;
   std::vector<std::uint8_t> program;
@@ -163,12 +205,36 @@ AssemblyResult Assembler::assemble(const std::vector<LineRecord> &lines,
   symbols_["IO_CONSOLE_STATUS"] = {0xFF01, true};
   symbols_["IO_TIMER_COUNTER"] = {0xFF10, true};
   symbols_["IO_TIMER_CONTROL"] = {0xFF12, true};
+  symbols_["IO_TIMER_PERIOD"] = {0xFF13, true};
+  symbols_["IO_TIMER_COMPARE"] = {0xFF15, true};
   symbols_["IO_LED"] = {0xFF20, true};
+  symbols_["IO_DMA_SRC"] = {0xFF30, true};
+  symbols_["IO_DMA_DST"] = {0xFF32, true};
+  symbols_["IO_DMA_LEN"] = {0xFF34, true};
+  symbols_["IO_DMA_MODE"] = {0xFF36, true};
+  symbols_["IO_DMA_CONTROL"] = {0xFF37, true};
+  symbols_["IO_DMA_FILL"] = {0xFF38, true};
+  symbols_["IO_IRQ_PENDING"] = {0xFF40, true};
+  symbols_["IO_IRQ_MASK"] = {0xFF41, true};
+  symbols_["IO_IRQ_RAISE"] = {0xFF42, true};
+  symbols_["IO_IRQ_VECTORS"] = {0xFF50, true};
+  symbols_["IO_MMU_FRAMES"] = {0xFF60, true};
+  symbols_["IO_MMU_STATUS"] = {0xFF62, true};
+  symbols_["IO_MMU_BANKS"] = {0xFF70, true};
+  symbols_["IO_MAILBOX_CORES"] = {0xFF90, true};
+  symbols_["IO_MAILBOX_SLOTS"] = {0xFFA0, true};
 
   // First pass: parse lines, build symbol table, generate code with
   // placeholders
   for (const auto &line : lines) {
+    const auto first_new = pending.size();
     parseLine(line, location_counter, program, pending);
+    for (auto i = first_new; i < pending.size(); ++i) {
+      pending[i].section = current_bank_;
+    }
+  }
+  if (current_bank_ != 0) {
+    closeBank(location_counter, program);
   }
 
   // Second pass: resolve pending operands
@@ -178,21 +244,23 @@ AssemblyResult Assembler::assemble(const std::vector<LineRecord> &lines,
       errors_.push_back("unresolved symbol: " + entry.symbol);
       continue;
     }
+    auto &target =
+        entry.section == 0 ? program : banks_[entry.section - 1].bytes;
     auto value = it->second.value;
     if (entry.is_offset) {
       std::int32_t signed_value =
           static_cast<std::int32_t>(value) * entry.multiplier;
       value = static_cast<std::uint16_t>(signed_value & 0xFFFF);
     }
-    if (entry.location + entry.width - 1 >= program.size()) {
+    if (entry.location + entry.width - 1 >= target.size()) {
       errors_.push_back("invalid patch location for symbol: " + entry.symbol);
       continue;
     }
     if (entry.width == 1) {
-      program[entry.location] = static_cast<std::uint8_t>(value & 0xFF);
+      target[entry.location] = static_cast<std::uint8_t>(value & 0xFF);
     } else {
-      program[entry.location] = static_cast<std::uint8_t>(value & 0xFF);
-      program[entry.location + 1] =
+      target[entry.location] = static_cast<std::uint8_t>(value & 0xFF);
+      target[entry.location + 1] =
           static_cast<std::uint8_t>((value >> 8) & 0xFF);
     }
   }
@@ -201,9 +269,21 @@ AssemblyResult Assembler::assemble(const std::vector<LineRecord> &lines,
   result.ok = errors_.empty();
   result.bytes = program;
   result.messages = errors_;
+  result.labels = labels_;
+  result.banks = banks_;
   return result;
 }
 
+void Assembler::closeBank(std::uint16_t &location_counter,
+                          std::vector<std::uint8_t> &program) {
+  banks_[current_bank_ - 1].bytes = std::move(program);
+  program = std::move(main_program_);
+  main_program_.clear();
+  location_counter = main_counter_;
+  origin_ = main_origin_;
+  current_bank_ = 0;
+}
+
 bool Assembler::parseLine(const LineRecord &line,
                           std::uint16_t &location_counter,
                           std::vector<std::uint8_t> &program,
@@ -234,6 +314,7 @@ bool Assembler::parseLine(const LineRecord &line,
     auto label = util::trim(text.substr(0, colon_pos));
     if (!label.empty()) {
       symbols_[label] = {location_counter, false};
+      labels_.emplace_back(label, location_counter);
     }
     text = util::trim(text.substr(colon_pos + 1));
     if (text.empty()) {
@@ -421,6 +502,41 @@ bool Assembler::encodeDirective(const LineRecord &line,
                 static_cast<std::uint8_t>(*pattern & 0xFF));
     }
     return true;
+  } else if (name == ".bank") {
+    // .bank FRAME, ADDRESS: assemble for guest ADDRESS, store in FRAME
+    const auto parts = util::splitOperands(remainder);
+    const auto frame =
+        parts.size() == 2 ? parseValue(parts[0]) : std::nullopt;
+    const auto address =
+        parts.size() == 2 ? parseValue(parts[1]) : std::nullopt;
+    if (!frame || !address || *frame < 0 || *frame > 0xFFFF ||
+        *address < 0 || *address > 0xFFFF) {
+      errors_.push_back("line " + std::to_string(line.number) +
+                        ": .bank expects frame,address");
+      return false;
+    }
+    if (current_bank_ != 0) {
+      closeBank(location_counter, program);
+    }
+    main_program_ = std::move(program);
+    program.clear();
+    main_counter_ = location_counter;
+    main_origin_ = origin_;
+    const auto physical = static_cast<std::uint32_t>(
+        static_cast<std::size_t>(*frame) * kPageSize + *address % kPageSize);
+    banks_.push_back({physical, {}});
+    current_bank_ = banks_.size();
+    origin_ = static_cast<std::uint16_t>(*address);
+    location_counter = origin_;
+    return true;
+  } else if (name == ".endbank") {
+    if (current_bank_ == 0) {
+      errors_.push_back("line " + std::to_string(line.number) +
+                        ": .endbank without .bank");
+      return false;
+    }
+    closeBank(location_counter, program);
+    return true;
   } else if (name == ".const" || name == ".equ") {
     auto parts = util::splitOperands(remainder);
     if (parts.size() == 1) {
@@ -459,13 +575,42 @@ bool Assembler::encodeInstruction(const LineRecord &line,
                                   std::uint16_t &location_counter,
                                   std::vector<std::uint8_t> &program,
                                   std::vector<PendingOperand> &pending) {
-  const auto lookup = kOpcodeTable.find(toUpper(std::string(mnemonic)));
+  // Suffixes after the mnemonic select modifier bits: .B and .SB make
+  // LOAD/STORE byte accesses (zero- and sign-extended), and a condition
+  // such as .NE predicates the instruction
+  const auto full = toUpper(std::string(mnemonic));
+  const auto dot = full.find('.');
+  const auto lookup = kOpcodeTable.find(full.substr(0, dot));
   if (lookup == kOpcodeTable.end()) {
     errors_.push_back("line " + std::to_string(line.number) +
                       ": unknown mnemonic " + std::string(mnemonic));
     return false;
   }
   const auto opcode_info = lookup->second;
+  std::uint8_t suffix_bits = 0;
+  for (auto pos = dot; pos != std::string::npos;) {
+    const auto next = full.find('.', pos + 1);
+    const auto suffix = full.substr(pos + 1, next - pos - 1);
+    pos = next;
+    const bool memory_op = opcode_info.opcode == Opcode::LOAD ||
+                           opcode_info.opcode == Opcode::STORE;
+    if ((suffix == "B" && memory_op) ||
+        (suffix == "SB" && opcode_info.opcode == Opcode::LOAD)) {
+      suffix_bits |= kByteAccess;
+      suffix_bits |= suffix == "SB" ? kSignExtend : 0;
+      continue;
+    }
+    if (const auto condition = kConditionTable.find(suffix);
+        condition != kConditionTable.end() &&
+        (suffix_bits >> kConditionShift) == 0) {
+      suffix_bits |= static_cast<std::uint8_t>(
+          static_cast<std::uint8_t>(condition->second) << kConditionShift);
+      continue;
+    }
+    errors_.push_back("line " + std::to_string(line.number) + ": suffix ." +
+                      suffix + " is not valid for " + full.substr(0, dot));
+    return false;
+  }
   std::vector<std::string> operand_tokens = util::splitOperands(operands);
   operand_tokens.erase(
       std::remove_if(operand_tokens.begin(), operand_tokens.end(),
@@ -491,6 +636,74 @@ bool Assembler::encodeInstruction(const LineRecord &line,
   word.operand_a = encodeOperand(spec_a.type, spec_a.reg);
   word.operand_b = encodeOperand(spec_b.type, spec_b.reg);
 
+  // CAS and FADD update a memory word; the CPU faults on any other operand
+  if ((opcode_info.opcode == Opcode::CAS ||
+       opcode_info.opcode == Opcode::FADD) &&
+      spec_a.type != OperandType::RegisterIndirect &&
+      spec_a.type != OperandType::RegisterIndexed &&
+      spec_a.type != OperandType::Absolute) {
+    errors_.push_back("line " + std::to_string(line.number) +
+                      ": first operand must be a memory operand");
+    return false;
+  }
+
+  // The third operand of BEQ/BNE/BLT is a branch target in a trailing
+  // word; for other instructions (block count, CAS expected value, DIVMOD
+  // remainder, UNPKB high byte) it is a register carried in the modifier byte
+  OperandSpec spec_target;
+  if (isCompareBranch(opcode_info.opcode)) {
+    spec_target = parseOperand(operand_tokens[2]);
+    if (spec_target.type != OperandType::Immediate) {
+      errors_.push_back("line " + std::to_string(line.number) +
+                        ": branch target must be a label or address");
+      return false;
+    }
+  } else if (operand_tokens.size() > 2) {
+    const auto reg = parseRegister(util::trim(operand_tokens[2]));
+    if (!reg) {
+      errors_.push_back("line " + std::to_string(line.number) +
+                        ": third operand must be a register");
+      return false;
+    }
+    word.modifier = static_cast<std::uint8_t>(*reg & kModifierRegisterMask);
+  }
+
+  // Auto-indexing: the CPU applies the modifier's mode to operand B when it
+  // is register indirect, otherwise to A
+  if (spec_a.auto_index != AutoIndex::None ||
+      spec_b.auto_index != AutoIndex::None) {
+    const auto fail = [&](const char *message) {
+      errors_.push_back("line " + std::to_string(line.number) + ": " +
+                        message);
+      return false;
+    };
+    if (usesModifierRegister(opcode_info.opcode)) {
+      return fail("auto-indexing is not available for this instruction");
+    }
+    if (spec_a.auto_index != AutoIndex::None &&
+        spec_b.type == OperandType::RegisterIndirect) {
+      return fail("only the second of two [r] operands can be auto-indexed");
+    }
+    const auto &indexed =
+        spec_b.auto_index != AutoIndex::None ? spec_b : spec_a;
+    const auto &other = &indexed == &spec_a ? spec_b : spec_a;
+    if ((other.type == OperandType::Register ||
+         other.type == OperandType::RegisterIndexed) &&
+        other.reg == indexed.reg) {
+      return fail("auto-indexed register is also used by the other operand");
+    }
+    // Byte accesses always step by one byte and use bit 2 for sign
+    // extension
+    const bool byte_access = (suffix_bits & kByteAccess) != 0;
+    if (byte_access && indexed.step == 2) {
+      return fail("byte accesses auto-index by one byte");
+    }
+    word.modifier = static_cast<std::uint8_t>(
+        static_cast<std::uint8_t>(indexed.auto_index) |
+        (indexed.step == 1 && !byte_access ? kAutoIndexByteStep : 0));
+  }
+  word.modifier |= suffix_bits;
+
   writeByte(program, location_counter, origin_, word.opcode);
   writeByte(program, location_counter, origin_, word.operand_a);
   writeByte(program, location_counter, origin_, word.operand_b);
@@ -522,14 +735,17 @@ bool Assembler::encodeInstruction(const LineRecord &line,
     }
   };
 
+  // Extension words in the order the CPU reads them: operand A's word or
+  // offset, then operand B's, then a branch target
   emitExtended(spec_a, false);
-  emitExtended(spec_b, false);
   if (spec_a.type == OperandType::RegisterIndexed && spec_a.has_offset) {
     emitExtended(spec_a, true);
   }
+  emitExtended(spec_b, false);
   if (spec_b.type == OperandType::RegisterIndexed && spec_b.has_offset) {
     emitExtended(spec_b, true);
   }
+  emitExtended(spec_target, false);
 
   return true;
 }
@@ -549,6 +765,47 @@ Assembler::OperandSpec Assembler::parseOperand(std::string_view token) {
     return spec;
   }
 
+  // Auto-indexed register indirect: [r]+ and -[r], with an optional step
+  // of 1 or 2 bytes ([r]+1, -1[r])
+  const auto parseStep = [](std::string_view step) -> std::optional<int> {
+    if (step.empty()) {
+      return 0;
+    }
+    if (step == "1" || step == "2") {
+      return step.front() - '0';
+    }
+    return std::nullopt;
+  };
+  if (const auto open = text.find('[');
+      text.front() == '-' && text.back() == ']' &&
+      open != std::string_view::npos) {
+    const auto step = parseStep(util::trim(text.substr(1, open - 1)));
+    const auto reg = parseRegister(
+        util::trim(text.substr(open + 1, text.size() - open - 2)));
+    if (step && reg) {
+      spec.type = OperandType::RegisterIndirect;
+      spec.reg = *reg;
+      spec.auto_index = AutoIndex::PreDecrement;
+      spec.step = static_cast<std::uint8_t>(*step);
+      return spec;
+    }
+  }
+  if (text.front() == '[') {
+    const auto close = text.find(']');
+    if (close != std::string_view::npos && close + 1 < text.size() &&
+        text[close + 1] == '+') {
+      const auto step = parseStep(util::trim(text.substr(close + 2)));
+      const auto reg = parseRegister(util::trim(text.substr(1, close - 1)));
+      if (step && reg) {
+        spec.type = OperandType::RegisterIndirect;
+        spec.reg = *reg;
+        spec.auto_index = AutoIndex::PostIncrement;
+        spec.step = static_cast<std::uint8_t>(*step);
+        return spec;
+      }
+    }
+  }
+
   if (text.front() == '[' && text.back() == ']') {
     auto inner = util::trim(text.substr(1, text.size() - 2));
     auto plus_pos = inner.find_first_of("+-");
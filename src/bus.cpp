@@ -1,17 +1,39 @@
 #include "softcpu/bus.hpp"
 #include "softcpu/device.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstring>
 #include <stdexcept>
 
 namespace softcpu {
 
-Bus::Bus(Memory &memory) : memory_(memory) {}
+Bus::Bus(Memory &memory) : memory_(memory) {
+  for (std::size_t page = 0; page < kPageCount; ++page) {
+    mapPage(page, nullptr);
+  }
+}
 
 void Bus::attachDevice(std::shared_ptr<IODevice> device) {
+  if (device->size() > 0) {
+    const std::size_t first = device->base() >> 8;
+    const std::size_t last =
+        (static_cast<std::size_t>(device->base()) + device->size() - 1) >> 8;
+    for (std::size_t page = first; page <= last && page < 256; ++page) {
+      device_pages_.set(page);
+    }
+  }
+  slow_pages_ = device_pages_ | watch_pages_;
   devices_.push_back(std::move(device));
 }
 
 IODevice *Bus::findDevice(std::uint16_t address) const {
+  // Most accesses hit pages without devices; skip the scan for those
+  if (!device_pages_.test(address >> 8)) {
+    return nullptr;
+  }
   for (const auto &dev : devices_) {
     if (dev->handles(address)) {
       return dev.get();
@@ -20,48 +42,194 @@ IODevice *Bus::findDevice(std::uint16_t address) const {
   return nullptr;
 }
 
+void Bus::noteAccess(std::uint16_t address, std::size_t width,
+                     bool write) const {
+  if (watch_hit_) {
+    return; // Keep the first hit until it is collected
+  }
+  const auto &watched = write ? watch_write_ : watch_read_;
+  for (std::size_t i = 0; i < width; ++i) {
+    const auto byte = static_cast<std::uint16_t>(address + i);
+    if (watched.test(byte)) {
+      watch_hit_ = WatchHit{byte, write};
+      return;
+    }
+  }
+}
+
 std::uint8_t Bus::read8(std::uint16_t address) const {
-  // Check if address maps to an I/O device
-  if (auto *dev = findDevice(address)) {
-    return dev->read(dev->offset(address));
+  // Pages with device windows or watchpoints take the slow path
+  if (isSlow(address, 1)) {
+    noteAccess(address, 1, false);
+    // Check if address maps to an I/O device
+    if (auto *dev = findDevice(address)) {
+      const auto lock = lockDevices();
+      count(address, AccessKind::Read, true);
+      return dev->read(dev->offset(address));
+    }
   }
   // Otherwise read from memory
-  return memory_.read8(address);
+  count(address, AccessKind::Read, false);
+  return *host(address);
 }
 
 std::uint16_t Bus::read16(std::uint16_t address) const {
-  // Check if address maps to an I/O device
+  if (isSlow(address, 2)) {
+    noteAccess(address, 2, false);
+    // Check if address maps to an I/O device
+    if (auto *dev = findDevice(address)) {
+      const auto lock = lockDevices();
+      count(address, AccessKind::Read, true, 2);
+      const std::uint8_t low = dev->read(dev->offset(address));
+      const std::uint8_t high =
+          dev->read(dev->offset(static_cast<std::uint16_t>(address + 1)));
+      return static_cast<std::uint16_t>(
+          (static_cast<std::uint16_t>(high) << 8) | low);
+    }
+  }
+  // Otherwise read from memory
+  count(address, AccessKind::Read, false, 2);
+  return ramRead16(address);
+}
+
+std::uint8_t Bus::fetch8(std::uint16_t address) const {
+  if (auto *dev = findDevice(address)) {
+    const auto lock = lockDevices();
+    count(address, AccessKind::Fetch, true);
+    return dev->read(dev->offset(address));
+  }
+  count(address, AccessKind::Fetch, false);
+  return *host(address);
+}
+
+std::uint16_t Bus::fetch16(std::uint16_t address) const {
   if (auto *dev = findDevice(address)) {
+    const auto lock = lockDevices();
+    count(address, AccessKind::Fetch, true, 2);
     const std::uint8_t low = dev->read(dev->offset(address));
     const std::uint8_t high =
         dev->read(dev->offset(static_cast<std::uint16_t>(address + 1)));
     return static_cast<std::uint16_t>((static_cast<std::uint16_t>(high) << 8) |
                                       low);
   }
-  // Otherwise read from memory
-  return memory_.read16(address);
+  count(address, AccessKind::Fetch, false, 2);
+  return ramRead16(address);
 }
 
 void Bus::write8(std::uint16_t address, std::uint8_t value) {
-  // Check if address maps to an I/O device
-  if (auto *dev = findDevice(address)) {
-    dev->write(dev->offset(address), value);
-    return;
+  if (isSlow(address, 1)) {
+    noteAccess(address, 1, true);
+    // Check if address maps to an I/O device
+    if (auto *dev = findDevice(address)) {
+      const auto lock = lockDevices();
+      count(address, AccessKind::Write, true);
+      dev->write(dev->offset(address), value);
+      return;
+    }
   }
   // Otherwise write to memory
-  memory_.write8(address, value);
+  count(address, AccessKind::Write, false);
+  *host(address) = value;
 }
 
 void Bus::write16(std::uint16_t address, std::uint16_t value) {
-  // Check if address maps to an I/O device
-  if (auto *dev = findDevice(address)) {
-    dev->write(dev->offset(address), static_cast<std::uint8_t>(value & 0xFF));
-    dev->write(dev->offset(static_cast<std::uint16_t>(address + 1)),
-               static_cast<std::uint8_t>((value >> 8) & 0xFF));
-    return;
+  if (isSlow(address, 2)) {
+    noteAccess(address, 2, true);
+    // Check if address maps to an I/O device
+    if (auto *dev = findDevice(address)) {
+      const auto lock = lockDevices();
+      count(address, AccessKind::Write, true, 2);
+      dev->write(dev->offset(address),
+                 static_cast<std::uint8_t>(value & 0xFF));
+      dev->write(dev->offset(static_cast<std::uint16_t>(address + 1)),
+                 static_cast<std::uint8_t>((value >> 8) & 0xFF));
+      return;
+    }
   }
   // Otherwise write to memory
-  memory_.write16(address, value);
+  count(address, AccessKind::Write, false, 2);
+  ramWrite16(address, value);
+}
+
+namespace {
+// Host word for an atomic instruction, or nullptr if the guest word is not
+// naturally aligned in host memory
+std::uint16_t *atomicWord(std::uint8_t *host) {
+  if constexpr (std::endian::native != std::endian::little) {
+    return nullptr; // Guest words are little-endian
+  }
+  if (reinterpret_cast<std::uintptr_t>(host) %
+          std::atomic_ref<std::uint16_t>::required_alignment !=
+      0) {
+    return nullptr;
+  }
+  return reinterpret_cast<std::uint16_t *>(host);
+}
+} // namespace
+
+std::uint16_t Bus::compareExchange16(std::uint16_t address,
+                                     std::uint16_t expected,
+                                     std::uint16_t desired) {
+  if (!isSlow(address, 2)) {
+    if (auto *word = atomicWord(host(address))) {
+      count(address, AccessKind::Read, false, 2);
+      count(address, AccessKind::Write, false, 2);
+      std::atomic_ref<std::uint16_t>(*word).compare_exchange_strong(expected,
+                                                                    desired);
+      return expected;
+    }
+  }
+  const std::lock_guard<std::recursive_mutex> lock(device_mutex_);
+  const auto previous = read16(address);
+  if (previous == expected) {
+    write16(address, desired);
+  }
+  return previous;
+}
+
+std::uint16_t Bus::fetchAdd16(std::uint16_t address, std::uint16_t addend) {
+  if (!isSlow(address, 2)) {
+    if (auto *word = atomicWord(host(address))) {
+      count(address, AccessKind::Read, false, 2);
+      count(address, AccessKind::Write, false, 2);
+      return std::atomic_ref<std::uint16_t>(*word).fetch_add(addend);
+    }
+  }
+  const std::lock_guard<std::recursive_mutex> lock(device_mutex_);
+  const auto previous = read16(address);
+  write16(address, static_cast<std::uint16_t>(previous + addend));
+  return previous;
+}
+
+void Bus::addWatchpoint(std::uint16_t address, std::size_t length,
+                        WatchKind kind) {
+  const auto bits = static_cast<std::uint8_t>(kind);
+  for (std::size_t i = 0; i < length && i < kMemorySize; ++i) {
+    const auto byte = static_cast<std::uint16_t>(address + i);
+    if ((bits & static_cast<std::uint8_t>(WatchKind::Read)) != 0) {
+      watch_read_.set(byte);
+    }
+    if ((bits & static_cast<std::uint8_t>(WatchKind::Write)) != 0) {
+      watch_write_.set(byte);
+    }
+    watch_pages_.set(byte >> 8);
+  }
+  slow_pages_ = device_pages_ | watch_pages_;
+}
+
+void Bus::clearWatchpoints() {
+  watch_read_.reset();
+  watch_write_.reset();
+  watch_pages_.reset();
+  watch_hit_.reset();
+  slow_pages_ = device_pages_;
+}
+
+void Bus::resetDevices() {
+  for (auto &dev : devices_) {
+    dev->reset();
+  }
+  stall_cycles_.store(0, std::memory_order_relaxed);
 }
 
 void Bus::tickDevices() {
@@ -70,4 +238,125 @@ void Bus::tickDevices() {
   }
 }
 
+void Bus::advanceDevices(std::uint64_t cycles) {
+  for (auto &dev : devices_) {
+    dev->advance(cycles);
+  }
+}
+
+std::optional<std::uint64_t> Bus::cyclesUntilNextEvent() const {
+  std::optional<std::uint64_t> next;
+  for (const auto &dev : devices_) {
+    if (!dev->interruptUnmasked()) {
+      continue;
+    }
+    if (const auto cycles = dev->cyclesUntilEvent()) {
+      next = next ? std::min(*next, *cycles) : *cycles;
+    }
+  }
+  return next;
+}
+
+bool Bus::rangeIsRam(std::uint16_t address, std::size_t length) const {
+  if (static_cast<std::size_t>(address) + length > kMemorySize) {
+    return false;
+  }
+  if (length == 0) {
+    return true;
+  }
+  const std::size_t first = address >> 8;
+  const std::size_t last = (address + length - 1) >> 8;
+  for (std::size_t page = first; page <= last; ++page) {
+    if (slow_pages_.test(page)) {
+      return false;
+    }
+  }
+  // Banked pages only form one host span if their frames are consecutive
+  const std::size_t first_bank = address / kPageSize;
+  const std::size_t last_bank = (address + length - 1) / kPageSize;
+  for (std::size_t bank = first_bank + 1; bank <= last_bank; ++bank) {
+    if (tlb_[bank].load(std::memory_order_acquire) !=
+        tlb_[bank - 1].load(std::memory_order_acquire) + kPageSize) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::uint8_t *Bus::ramSpan(std::uint16_t address, std::size_t length) {
+  return rangeIsRam(address, length) ? host(address) : nullptr;
+}
+
+const std::uint8_t *Bus::ramSpan(std::uint16_t address,
+                                 std::size_t length) const {
+  return rangeIsRam(address, length) ? host(address) : nullptr;
+}
+
+const std::uint8_t *Bus::readSpan(std::uint16_t address, std::size_t length) {
+  const auto *span = ramSpan(address, length);
+  if (span != nullptr) {
+    countRange(address, length, AccessKind::Read);
+  }
+  return span;
+}
+
+void Bus::copyBlock(std::uint16_t destination, std::uint16_t source,
+                    std::size_t length) {
+  auto *dst = ramSpan(destination, length);
+  const auto *src = ramSpan(source, length);
+  if (dst != nullptr && src != nullptr) {
+    countRange(source, length, AccessKind::Read);
+    countRange(destination, length, AccessKind::Write);
+    std::memmove(dst, src, length);
+    return;
+  }
+  if (destination > source) {
+    // Copy backwards so overlapping ranges behave like memmove
+    for (std::size_t i = length; i-- > 0;) {
+      write8(static_cast<std::uint16_t>(destination + i),
+             read8(static_cast<std::uint16_t>(source + i)));
+    }
+    return;
+  }
+  for (std::size_t i = 0; i < length; ++i) {
+    write8(static_cast<std::uint16_t>(destination + i),
+           read8(static_cast<std::uint16_t>(source + i)));
+  }
+}
+
+void Bus::fillBlock(std::uint16_t destination, std::uint8_t value,
+                    std::size_t length) {
+  if (auto *dst = ramSpan(destination, length)) {
+    countRange(destination, length, AccessKind::Write);
+    std::memset(dst, value, length);
+    return;
+  }
+  for (std::size_t i = 0; i < length; ++i) {
+    write8(static_cast<std::uint16_t>(destination + i), value);
+  }
+}
+
+BlockMismatch Bus::compareBlock(std::uint16_t lhs, std::uint16_t rhs,
+                                std::size_t length) const {
+  const auto *left = ramSpan(lhs, length);
+  const auto *right = ramSpan(rhs, length);
+  if (left != nullptr && right != nullptr) {
+    countRange(lhs, length, AccessKind::Read);
+    countRange(rhs, length, AccessKind::Read);
+    const auto [first, second] = std::mismatch(left, left + length, right);
+    if (first == left + length) {
+      return {length};
+    }
+    return {static_cast<std::size_t>(first - left), *first, *second};
+  }
+  for (std::size_t i = 0; i < length; ++i) {
+    const auto a = read8(static_cast<std::uint16_t>(lhs + i));
+    const auto b = read8(static_cast<std::uint16_t>(rhs + i));
+    if (a != b) {
+      return {i, a, b};
+    }
+  }
+  return {length};
+}
+
 } // namespace softcpu
@@ -0,0 +1,205 @@
+#include "softcpu/softcpu.h"
+
+#include "softcpu/emulator.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <new>
+#include <thread>
+#include <vector>
+
+// Opaque handle behind the C API
+struct softcpu_machine {
+  softcpu::Emulator emulator;
+  std::shared_ptr<softcpu::CaptureSink> capture;
+};
+
+namespace {
+static_assert(SOFTCPU_MEMORY_SIZE == softcpu::kMemorySize);
+static_assert(SOFTCPU_REGISTER_COUNT == softcpu::kRegisterCount);
+static_assert(static_cast<int>(softcpu::StopReason::Watchpoint) ==
+              SOFTCPU_STOP_WATCHPOINT);
+
+// Index of the register that aliases SP
+constexpr unsigned kStackRegister = SOFTCPU_REGISTER_COUNT - 1;
+
+softcpu_stop_reason runMachine(softcpu_machine *machine, std::uint64_t cycles,
+                               softcpu_run_result *result) {
+  softcpu::RunOptions options;
+  options.cycle_limit = cycles;
+  machine->emulator.run(options);
+  const auto &stats = machine->emulator.lastRunStats();
+  const auto reason = static_cast<softcpu_stop_reason>(stats.stop_reason);
+  if (result != nullptr) {
+    result->reason = reason;
+    result->stop_address = stats.stop_address;
+    result->reserved = 0;
+    result->cycles = stats.cycles;
+    result->instructions = stats.instructions;
+  }
+  return reason;
+}
+} // namespace
+
+extern "C" {
+
+int softcpu_abi_version(void) { return SOFTCPU_ABI_VERSION; }
+
+softcpu_machine *softcpu_create(void) {
+  // Nothing may propagate into a C caller; any failure reports NULL
+  softcpu_machine *machine = nullptr;
+  try {
+    machine = new softcpu_machine;
+    machine->emulator.setConsoleSink(std::make_shared<softcpu::NullSink>());
+    machine->emulator.reset();
+  } catch (const std::exception &) {
+    delete machine;
+    return nullptr;
+  }
+  return machine;
+}
+
+void softcpu_destroy(softcpu_machine *machine) { delete machine; }
+
+void softcpu_reset(softcpu_machine *machine) { machine->emulator.reset(); }
+
+int softcpu_load(softcpu_machine *machine, const uint8_t *image, size_t size,
+                 uint16_t origin) {
+  if (static_cast<std::size_t>(origin) + size > softcpu::kMemorySize) {
+    return -1;
+  }
+  std::copy_n(image, size, machine->emulator.memory().data() + origin);
+  return 0;
+}
+
+uint8_t *softcpu_memory(softcpu_machine *machine) {
+  return machine->emulator.memory().data();
+}
+
+uint16_t softcpu_get_register(const softcpu_machine *machine,
+                              unsigned index) {
+  const auto &regs = machine->emulator.registers();
+  if (index == kStackRegister) {
+    return regs.sp;
+  }
+  return index < SOFTCPU_REGISTER_COUNT ? regs.gpr[index] : 0;
+}
+
+void softcpu_set_register(softcpu_machine *machine, unsigned index,
+                          uint16_t value) {
+  auto &regs = machine->emulator.registers();
+  if (index == kStackRegister) {
+    // R7 mirrors SP, as in the control unit's register writes
+    regs.sp = value;
+    regs.gpr[index] = value;
+  } else if (index < SOFTCPU_REGISTER_COUNT) {
+    regs.gpr[index] = value;
+  }
+}
+
+uint16_t softcpu_get_pc(const softcpu_machine *machine) {
+  return machine->emulator.registers().pc;
+}
+
+void softcpu_set_pc(softcpu_machine *machine, uint16_t value) {
+  machine->emulator.registers().pc = value;
+}
+
+uint16_t softcpu_get_sp(const softcpu_machine *machine) {
+  return machine->emulator.registers().sp;
+}
+
+void softcpu_set_sp(softcpu_machine *machine, uint16_t value) {
+  auto &regs = machine->emulator.registers();
+  regs.sp = value;
+  regs.gpr[kStackRegister] = value;
+}
+
+uint16_t softcpu_get_flags(const softcpu_machine *machine) {
+  return machine->emulator.registers().flags.value;
+}
+
+void softcpu_set_flags(softcpu_machine *machine, uint16_t value) {
+  machine->emulator.registers().flags.value = value;
+}
+
+uint64_t softcpu_cycles(const softcpu_machine *machine) {
+  return machine->emulator.cycles();
+}
+
+uint64_t softcpu_instructions(const softcpu_machine *machine) {
+  return machine->emulator.instructions();
+}
+
+softcpu_stop_reason softcpu_run(softcpu_machine *machine, uint64_t cycles,
+                                softcpu_run_result *result) {
+  return runMachine(machine, cycles, result);
+}
+
+void softcpu_run_batch(softcpu_machine *const *machines, size_t count,
+                       uint64_t cycles, unsigned threads,
+                       softcpu_run_result *results) {
+  const auto runRange = [&](std::size_t first, std::size_t last) {
+    for (std::size_t i = first; i < last; ++i) {
+      runMachine(machines[i], cycles,
+                 results != nullptr ? results + i : nullptr);
+    }
+  };
+  const std::size_t workers = std::min<std::size_t>(threads, count);
+  if (workers <= 1) {
+    runRange(0, count);
+    return;
+  }
+  // Contiguous slices; the calling thread takes the last one. If a thread
+  // cannot be started, the calling thread runs every slice not yet handed out.
+  std::vector<std::thread> pool;
+  const std::size_t slice = (count + workers - 1) / workers;
+  std::size_t first = 0;
+  try {
+    pool.reserve(workers - 1);
+    for (std::size_t w = 0; w + 1 < workers && first < count; ++w) {
+      const std::size_t last = std::min(count, first + slice);
+      pool.emplace_back(runRange, first, last);
+      first = last;
+    }
+  } catch (const std::exception &) {
+    // std::system_error or std::bad_alloc; fall back to running serially
+  }
+  runRange(first, count);
+  for (auto &thread : pool) {
+    thread.join();
+  }
+}
+
+void softcpu_capture_console(softcpu_machine *machine, size_t capacity) {
+  if (capacity == 0) {
+    machine->capture.reset();
+    machine->emulator.setConsoleSink(std::make_shared<softcpu::NullSink>());
+    return;
+  }
+  machine->capture = std::make_shared<softcpu::CaptureSink>(capacity);
+  machine->emulator.setConsoleSink(machine->capture);
+}
+
+const char *softcpu_console_output(const softcpu_machine *machine,
+                                   size_t *size) {
+  if (machine->capture == nullptr) {
+    if (size != nullptr) {
+      *size = 0;
+    }
+    return "";
+  }
+  const auto text = machine->capture->text();
+  if (size != nullptr) {
+    *size = text.size();
+  }
+  return text.data();
+}
+
+void softcpu_clear_console(softcpu_machine *machine) {
+  if (machine->capture != nullptr) {
+    machine->capture->clear();
+  }
+}
+
+} // extern "C"
@@ -0,0 +1,229 @@
+#include "softcpu/cache.hpp"
+
+#include "softcpu/common.hpp"
+#include "softcpu/profiler.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <iterator>
+#include <map>
+#include <string>
+
+namespace softcpu {
+
+bool CacheConfig::valid() const {
+  if (!std::has_single_bit(size_bytes) || !std::has_single_bit(ways) ||
+      !std::has_single_bit(line_bytes)) {
+    return false;
+  }
+  return line_bytes >= 2 && size_bytes <= kMemorySize &&
+         ways * line_bytes <= size_bytes;
+}
+
+Cache::Cache(const CacheConfig &config)
+    : config_(config),
+      line_shift_(static_cast<unsigned>(std::countr_zero(config.line_bytes))),
+      set_mask_(config.size_bytes / (config.line_bytes * config.ways) - 1),
+      lines_(config.size_bytes / config.line_bytes) {}
+
+std::uint32_t Cache::access(std::uint16_t address, bool write) {
+  const std::uint32_t line = lineOf(address);
+  Line *set = &lines_[(line & set_mask_) * config_.ways];
+  ++stats_.accesses;
+  ++clock_;
+  // Empty lines have never been used, so the LRU scan also prefers them
+  Line *victim = set;
+  for (std::size_t way = 0; way < config_.ways; ++way) {
+    if (set[way].tag == line) {
+      set[way].used = clock_;
+      set[way].dirty = set[way].dirty || write;
+      return 0;
+    }
+    if (set[way].used < victim->used) {
+      victim = &set[way];
+    }
+  }
+  ++stats_.misses;
+  std::uint32_t penalty = config_.miss_penalty;
+  if (victim->dirty) {
+    ++stats_.writebacks;
+    penalty += config_.miss_penalty;
+  }
+  *victim = Line{line, write, clock_};
+  stats_.penalty_cycles += penalty;
+  return penalty;
+}
+
+void Cache::clear() {
+  std::fill(lines_.begin(), lines_.end(), Line{});
+  clock_ = 0;
+  stats_ = {};
+}
+
+CacheModel::CacheModel(const CacheConfig &instruction,
+                       const CacheConfig &data)
+    : sites_(kMemorySize) {
+  if (instruction.size_bytes > 0) {
+    instruction_.emplace(instruction);
+  }
+  if (data.size_bytes > 0) {
+    data_.emplace(data);
+  }
+}
+
+void CacheModel::charge(Cache &cache, std::uint16_t address, bool fetch,
+                        bool write) {
+  auto &site = sites_[pc_];
+  const auto penalty = cache.access(address, write);
+  ++(fetch ? site.fetches : site.data);
+  if (penalty > 0) {
+    ++(fetch ? site.fetch_misses : site.data_misses);
+    site.penalty_cycles += penalty;
+    penalty_ += penalty;
+  }
+}
+
+void CacheModel::access(std::uint16_t address, std::size_t width,
+                        AccessKind kind) {
+  const bool fetch = kind == AccessKind::Fetch;
+  auto &cache = fetch ? instruction_ : data_;
+  if (!cache) {
+    return;
+  }
+  const bool write = kind == AccessKind::Write;
+  charge(*cache, address, fetch, write);
+  const auto last = static_cast<std::uint16_t>(address + width - 1);
+  if (cache->lineOf(last) != cache->lineOf(address)) {
+    charge(*cache, last, fetch, write);
+  }
+}
+
+void CacheModel::accessRange(std::uint16_t address, std::size_t length,
+                             AccessKind kind) {
+  const bool fetch = kind == AccessKind::Fetch;
+  auto &cache = fetch ? instruction_ : data_;
+  if (!cache || length == 0) {
+    return;
+  }
+  const bool write = kind == AccessKind::Write;
+  const std::size_t line = cache->config().line_bytes;
+  const std::size_t end = static_cast<std::size_t>(address) + length;
+  for (std::size_t at = address & ~(line - 1); at < end; at += line) {
+    charge(*cache, static_cast<std::uint16_t>(at), fetch, write);
+  }
+}
+
+void CacheModel::clear() {
+  if (instruction_) {
+    instruction_->clear();
+  }
+  if (data_) {
+    data_->clear();
+  }
+  std::fill(sites_.begin(), sites_.end(), SiteCounts{});
+  penalty_ = 0;
+}
+
+namespace {
+// "12.34%" of `part` in `total`, or "-" when nothing was counted
+std::string percent(std::uint64_t part, std::uint64_t total) {
+  if (total == 0) {
+    return "-";
+  }
+  char text[16];
+  std::snprintf(text, sizeof(text), "%.2f%%",
+                100.0 * static_cast<double>(part) / static_cast<double>(total));
+  return text;
+}
+} // namespace
+
+void CacheModel::writeReport(std::ostream &out,
+                             const util::SymbolMap &symbols,
+                             const CallProfiler *profiler) const {
+  char line[160];
+  const std::pair<const char *, const Cache *> caches[] = {
+      {"icache", instructionCache()}, {"dcache", dataCache()}};
+  for (const auto &[name, cache] : caches) {
+    if (cache == nullptr) {
+      continue;
+    }
+    const auto &config = cache->config();
+    const auto &stats = cache->stats();
+    std::snprintf(line, sizeof(line),
+                  "%s %zu B %zu-way %zu B lines: %llu accesses, %llu misses "
+                  "(%s), %llu write-backs, %llu penalty cycles\n",
+                  name, config.size_bytes, config.ways, config.line_bytes,
+                  static_cast<unsigned long long>(stats.accesses),
+                  static_cast<unsigned long long>(stats.misses),
+                  percent(stats.misses, stats.accesses).c_str(),
+                  static_cast<unsigned long long>(stats.writebacks),
+                  static_cast<unsigned long long>(stats.penalty_cycles));
+    out << line;
+  }
+
+  // Fold per-PC counters into the function containing each PC
+  std::map<std::uint16_t, SiteCounts> functions;
+  if (profiler != nullptr) {
+    for (const auto &function : profiler->functions()) {
+      functions[function.entry];
+    }
+  } else {
+    for (const auto &[address, name] : symbols) {
+      functions[address];
+    }
+  }
+  functions[0]; // Catch-all below the first entry
+  for (std::size_t pc = 0; pc < sites_.size(); ++pc) {
+    const auto &site = sites_[pc];
+    if (site.fetches == 0 && site.data == 0) {
+      continue;
+    }
+    auto &total = std::prev(functions.upper_bound(
+                                static_cast<std::uint16_t>(pc)))->second;
+    total.fetches += site.fetches;
+    total.fetch_misses += site.fetch_misses;
+    total.data += site.data;
+    total.data_misses += site.data_misses;
+    total.penalty_cycles += site.penalty_cycles;
+  }
+  std::vector<std::pair<std::uint16_t, SiteCounts>> rows;
+  for (const auto &[entry, total] : functions) {
+    if (total.fetches > 0 || total.data > 0) {
+      rows.emplace_back(entry, total);
+    }
+  }
+  std::sort(rows.begin(), rows.end(), [](const auto &lhs, const auto &rhs) {
+    if (lhs.second.penalty_cycles != rhs.second.penalty_cycles) {
+      return lhs.second.penalty_cycles > rhs.second.penalty_cycles;
+    }
+    return lhs.first < rhs.first;
+  });
+
+  std::snprintf(line, sizeof(line), "%-20s %10s %8s %8s %10s %8s %8s %10s\n",
+                "function", "fetches", "i_miss", "i_rate", "data", "d_miss",
+                "d_rate", "penalty");
+  out << line;
+  for (const auto &[entry, total] : rows) {
+    std::string name;
+    if (auto it = symbols.find(entry); it != symbols.end()) {
+      name = it->second;
+    } else {
+      char address[8];
+      std::snprintf(address, sizeof(address), "0x%04X", entry);
+      name = address;
+    }
+    std::snprintf(line, sizeof(line),
+                  "%-20s %10llu %8llu %8s %10llu %8llu %8s %10llu\n",
+                  name.c_str(), static_cast<unsigned long long>(total.fetches),
+                  static_cast<unsigned long long>(total.fetch_misses),
+                  percent(total.fetch_misses, total.fetches).c_str(),
+                  static_cast<unsigned long long>(total.data),
+                  static_cast<unsigned long long>(total.data_misses),
+                  percent(total.data_misses, total.data).c_str(),
+                  static_cast<unsigned long long>(total.penalty_cycles));
+    out << line;
+  }
+}
+
+} // namespace softcpu
@@ -0,0 +1,95 @@
+#include "softcpu/console.hpp"
+
+#include <algorithm>
+
+namespace softcpu {
+
+namespace {
+// Host buffer size used for file output
+constexpr std::size_t kFileBufferSize = 64 * 1024;
+} // namespace
+
+// StdoutSink implementation
+void StdoutSink::put(char ch) { std::putc(ch, stdout); }
+
+void StdoutSink::write(std::string_view text) {
+  std::fwrite(text.data(), 1, text.size(), stdout);
+}
+
+void StdoutSink::flush() { std::fflush(stdout); }
+
+// CaptureSink implementation
+CaptureSink::CaptureSink(std::size_t capacity) : data_(capacity) {}
+
+void CaptureSink::put(char ch) {
+  if (size_ < data_.size()) {
+    data_[size_++] = ch;
+  } else {
+    ++dropped_;
+  }
+}
+
+void CaptureSink::write(std::string_view text) {
+  const auto room = std::min(text.size(), data_.size() - size_);
+  std::copy_n(text.data(), room, data_.data() + size_);
+  size_ += room;
+  dropped_ += text.size() - room;
+}
+
+void CaptureSink::clear() {
+  size_ = 0;
+  dropped_ = 0;
+}
+
+// FileSink implementation
+FileSink::FileSink(const std::string &path)
+    : file_(std::fopen(path.c_str(), "wb")) {
+  if (file_ != nullptr) {
+    std::setvbuf(file_, nullptr, _IOFBF, kFileBufferSize);
+  }
+}
+
+FileSink::~FileSink() {
+  if (file_ != nullptr) {
+    std::fclose(file_);
+  }
+}
+
+void FileSink::put(char ch) {
+  if (file_ != nullptr) {
+    std::putc(ch, file_);
+  }
+}
+
+void FileSink::write(std::string_view text) {
+  if (file_ != nullptr) {
+    std::fwrite(text.data(), 1, text.size(), file_);
+  }
+}
+
+void FileSink::flush() {
+  if (file_ != nullptr) {
+    std::fflush(file_);
+  }
+}
+
+std::shared_ptr<ConsoleSink> makeConsoleSink(const ConsoleOptions &options) {
+  switch (options.mode) {
+  case ConsoleMode::Stdout:
+    return std::make_shared<StdoutSink>();
+  case ConsoleMode::Capture:
+    return std::make_shared<CaptureSink>(options.capacity);
+  case ConsoleMode::File: {
+    auto sink = std::make_shared<FileSink>(options.path);
+    if (!sink->ok()) {
+      return nullptr;
+    }
+    return sink;
+  }
+  case ConsoleMode::Null:
+    return std::make_shared<NullSink>();
+  }
+  return nullptr;
+}
+
+} // namespace softcpu
@@ -4,7 +4,8 @@
 #include "softcpu/bus.hpp"
 
 #include <cstdio>
-#include <iostream>
+#include <optional>
+#include <string_view>
 
 namespace softcpu {
 namespace {
@@ -59,6 +60,14 @@ std::uint16_t portToAddress(std::uint16_t port_id) {
   }
 }
 
+// Write text through the console data port so it shares the console sink
+void writeConsole(Bus &bus, std::string_view text) {
+  const auto address = portToAddress(kPortConsoleData);
+  for (char ch : text) {
+    bus.write8(address, static_cast<std::uint8_t>(ch));
+  }
+}
+
 // Update Zero and Negative flags based on result
 void updateZN(FlagRegister &flags, std::uint16_t value) {
   flags.set(StatusFlag::kZero, value == 0);
@@ -72,7 +81,10 @@ void updateZN(FlagRegister &flags, std::uint16_t value) {
 ControlUnit::ControlUnit(Bus &bus, RegisterFile &registers, ALU &alu)
     : bus_(bus), registers_(registers), alu_(alu) {}
 
-void ControlUnit::reset() { registers_.reset(); }
+void ControlUnit::reset() {
+  registers_.reset();
+  fault_address_.reset();
+}
 
 bool ControlUnit::step(bool trace) {
   const auto instruction = fetchInstruction();
@@ -80,7 +92,41 @@ bool ControlUnit::step(bool trace) {
     std::printf("%04X %-5s\n", instruction.address,
                 opcodeName(instruction.opcode));
   }
-  return execute(instruction, trace);
+  // A predicated instruction whose condition fails still costs its cycle
+  const auto condition = conditionOf(instruction.modifier);
+  if (condition != Condition::Always &&
+      !conditionHolds(condition, registers_.flags)) {
+    if (pipeline_ != nullptr) {
+      bus_.addStallCycles(pipeline_->retire(instruction, registers_.pc));
+    }
+    return true;
+  }
+  const bool running = execute(instruction, trace);
+  if ((instruction.modifier & kAutoIndexMask) != 0 && !faulted()) {
+    updateAutoIndex(instruction.operand_a);
+    updateAutoIndex(instruction.operand_b);
+  }
+  if (pipeline_ != nullptr) {
+    bus_.addStallCycles(pipeline_->retire(instruction, registers_.pc));
+  }
+  return running;
+}
+
+void ControlUnit::updateAutoIndex(const Operand &operand) {
+  switch (operand.auto_index) {
+  case AutoIndex::PostIncrement:
+    writeRegister(registers_, operand.reg,
+                  static_cast<std::uint16_t>(
+                      readRegister(registers_, operand.reg) + operand.step));
+    break;
+  case AutoIndex::PreDecrement:
+    writeRegister(registers_, operand.reg,
+                  static_cast<std::uint16_t>(
+                      readRegister(registers_, operand.reg) - operand.step));
+    break;
+  case AutoIndex::None:
+    break;
+  }
 }
 
 DecodedInstruction ControlUnit::fetchInstruction() {
@@ -90,10 +136,10 @@ DecodedInstruction ControlUnit::fetchInstruction() {
   InstructionWord word{};
 
   // Fetch opcode and operands
-  word.opcode = bus_.read8(pc++);
-  word.operand_a = bus_.read8(pc++);
-  word.operand_b = bus_.read8(pc++);
-  word.modifier = bus_.read8(pc++);
+  word.opcode = bus_.fetch8(pc++);
+  word.operand_a = bus_.fetch8(pc++);
+  word.operand_b = bus_.fetch8(pc++);
+  word.modifier = bus_.fetch8(pc++);
   decoded.opcode = static_cast<Opcode>(word.opcode);
   decoded.modifier = word.modifier;
 
@@ -106,6 +152,11 @@ DecodedInstruction ControlUnit::fetchInstruction() {
   if (descriptor_b.type != OperandType::None) {
     decoded.operand_b = resolveOperand(descriptor_b, pc);
   }
+  if (isCompareBranch(decoded.opcode)) {
+    decoded.branch_target = bus_.fetch16(pc);
+    pc = static_cast<std::uint16_t>(pc + 2);
+  }
+  decodeAutoIndex(decoded);
 
   decoded.size_bytes = static_cast<std::uint16_t>(pc - decoded.address);
   registers_.pc = pc;
@@ -124,13 +175,13 @@ Operand ControlUnit::resolveOperand(const OperandDescriptor &descriptor,
     break;
   case OperandType::RegisterIndexed:
     operand.reg &= 0x07;
-    operand.offset = static_cast<std::int16_t>(bus_.read16(pc));
+    operand.offset = static_cast<std::int16_t>(bus_.fetch16(pc));
     operand.has_offset = true;
     pc = static_cast<std::uint16_t>(pc + 2);
     break;
   case OperandType::Immediate:
   case OperandType::Absolute:
-    operand.value = bus_.read16(pc);
+    operand.value = bus_.fetch16(pc);
     pc = static_cast<std::uint16_t>(pc + 2);
     break;
   case OperandType::Port:
@@ -143,6 +194,16 @@ Operand ControlUnit::resolveOperand(const OperandDescriptor &descriptor,
   return operand;
 }
 
+// Address of a register-indirect operand. A pre-decrement is applied here
+// and written back to the register once the instruction completes.
+std::uint16_t indirectAddress(const RegisterFile &regs,
+                              const Operand &operand) {
+  const auto base = readRegister(regs, operand.reg);
+  return operand.auto_index == AutoIndex::PreDecrement
+             ? static_cast<std::uint16_t>(base - operand.step)
+             : base;
+}
+
 // Helper to read the value of an operand
 std::uint16_t readOperandValue(Bus &bus, const RegisterFile &regs,
                                const Operand &operand) {
@@ -153,10 +214,8 @@ std::uint16_t readOperandValue(Bus &bus, const RegisterFile &regs,
     return operand.value;
   case OperandType::Absolute:
     return bus.read16(operand.value);
-  case OperandType::RegisterIndirect: {
-    const auto address = readRegister(regs, operand.reg);
-    return bus.read16(address);
-  }
+  case OperandType::RegisterIndirect:
+    return bus.read16(indirectAddress(regs, operand));
   case OperandType::RegisterIndexed: {
     const auto base = readRegister(regs, operand.reg);
     const auto address = static_cast<std::uint16_t>(base + operand.offset);
@@ -177,11 +236,9 @@ void writeOperandValue(Bus &bus, RegisterFile &regs, const Operand &operand,
   case OperandType::Absolute:
     bus.write16(operand.value, value);
     break;
-  case OperandType::RegisterIndirect: {
-    const auto address = readRegister(regs, operand.reg);
-    bus.write16(address, value);
+  case OperandType::RegisterIndirect:
+    bus.write16(indirectAddress(regs, operand), value);
     break;
-  }
   case OperandType::RegisterIndexed: {
     const auto base = readRegister(regs, operand.reg);
     const auto address = static_cast<std::uint16_t>(base + operand.offset);
@@ -193,6 +250,41 @@ void writeOperandValue(Bus &bus, RegisterFile &regs, const Operand &operand,
   }
 }
 
+// Address named by a memory operand, or nullopt for registers/immediates
+std::optional<std::uint16_t> operandAddress(const RegisterFile &regs,
+                                            const Operand &operand) {
+  switch (operand.type) {
+  case OperandType::Absolute:
+    return operand.value;
+  case OperandType::RegisterIndirect:
+    return indirectAddress(regs, operand);
+  case OperandType::RegisterIndexed:
+    return static_cast<std::uint16_t>(readRegister(regs, operand.reg) +
+                                      operand.offset);
+  default:
+    return std::nullopt;
+  }
+}
+
+// Byte forms of readOperandValue/writeOperandValue: memory operands move
+// one byte, register and immediate operands use the low byte
+std::uint8_t readOperandByte(Bus &bus, const RegisterFile &regs,
+                             const Operand &operand) {
+  if (const auto address = operandAddress(regs, operand)) {
+    return bus.read8(*address);
+  }
+  return static_cast<std::uint8_t>(readOperandValue(bus, regs, operand));
+}
+
+void writeOperandByte(Bus &bus, RegisterFile &regs, const Operand &operand,
+                      std::uint8_t value) {
+  if (const auto address = operandAddress(regs, operand)) {
+    bus.write8(*address, value);
+  } else {
+    writeOperandValue(bus, regs, operand, value);
+  }
+}
+
 // Helper to push a value onto the stack
 void push(Bus &bus, RegisterFile &regs, std::uint16_t value) {
   const auto new_sp = static_cast<std::uint16_t>(regs.sp - 2);
@@ -208,6 +300,24 @@ std::uint16_t pop(Bus &bus, RegisterFile &regs) {
   return value;
 }
 
+void ControlUnit::enterInterrupt(std::uint16_t vector) {
+  if (profiler_ != nullptr) {
+    profiler_->onCall(vector, registers_.pc);
+  }
+  push(bus_, registers_, registers_.pc);
+  push(bus_, registers_, registers_.flags.value);
+  registers_.interrupts_enabled = false;
+  registers_.pc = vector;
+}
+
+void ControlUnit::takeBranch(const DecodedInstruction &inst,
+                             std::uint16_t target) {
+  if (coverage_ != nullptr) {
+    coverage_->record(inst.address, target);
+  }
+  registers_.pc = target;
+}
+
 bool ControlUnit::execute(const DecodedInstruction &inst, bool) {
   switch (inst.opcode) {
   case Opcode::NOP:
@@ -226,11 +336,26 @@ bool ControlUnit::execute(const DecodedInstruction &inst, bool) {
     return true;
   }
   case Opcode::LOAD: {
+    if (isByteAccess(inst)) {
+      const auto byte = readOperandByte(bus_, registers_, inst.operand_b);
+      const auto value =
+          (inst.modifier & kSignExtend) != 0
+              ? static_cast<std::uint16_t>(static_cast<std::int8_t>(byte))
+              : std::uint16_t{byte};
+      writeOperandValue(bus_, registers_, inst.operand_a, value);
+      return true;
+    }
     const auto value = readOperandValue(bus_, registers_, inst.operand_b);
     writeOperandValue(bus_, registers_, inst.operand_a, value);
     return true;
   }
   case Opcode::STORE: {
+    if (isByteAccess(inst)) {
+      const auto value = readOperandValue(bus_, registers_, inst.operand_a);
+      writeOperandByte(bus_, registers_, inst.operand_b,
+                       static_cast<std::uint8_t>(value));
+      return true;
+    }
     const auto value = readOperandValue(bus_, registers_, inst.operand_a);
     writeOperandValue(bus_, registers_, inst.operand_b, value);
     return true;
@@ -253,6 +378,25 @@ bool ControlUnit::execute(const DecodedInstruction &inst, bool) {
     registers_.flags = result.flags;
     return true;
   }
+  case Opcode::ADC: {
+    const auto lhs = readOperandValue(bus_, registers_, inst.operand_a);
+    const auto rhs = readOperandValue(bus_, registers_, inst.operand_b);
+    const auto result =
+        alu_.add(lhs, rhs, registers_.flags.test(StatusFlag::kCarry));
+    writeOperandValue(bus_, registers_, inst.operand_a, result.value);
+    registers_.flags = result.flags;
+    return true;
+  }
+  case Opcode::SBC: {
+    // Carry set means no borrow, as left by SUB and CMP
+    const auto lhs = readOperandValue(bus_, registers_, inst.operand_a);
+    const auto rhs = readOperandValue(bus_, registers_, inst.operand_b);
+    const auto result =
+        alu_.sub(lhs, rhs, !registers_.flags.test(StatusFlag::kCarry));
+    writeOperandValue(bus_, registers_, inst.operand_a, result.value);
+    registers_.flags = result.flags;
+    return true;
+  }
   case Opcode::MUL: {
     const auto lhs = readOperandValue(bus_, registers_, inst.operand_a);
     const auto rhs = readOperandValue(bus_, registers_, inst.operand_b);
@@ -269,6 +413,31 @@ bool ControlUnit::execute(const DecodedInstruction &inst, bool) {
     registers_.flags = result.flags;
     return true;
   }
+  case Opcode::MULH:
+  case Opcode::MULHU: {
+    const auto lhs = readOperandValue(bus_, registers_, inst.operand_a);
+    const auto rhs = readOperandValue(bus_, registers_, inst.operand_b);
+    const auto result =
+        alu_.mul_high(lhs, rhs, inst.opcode == Opcode::MULH);
+    writeOperandValue(bus_, registers_, inst.operand_a, result.value);
+    registers_.flags = result.flags;
+    return true;
+  }
+  case Opcode::DIVMOD: {
+    // DIVMOD dst, src, rr: dst = dst / src, rr = dst % src. Flags follow
+    // the quotient; rr is written last, so it wins if it names dst.
+    const auto lhs = readOperandValue(bus_, registers_, inst.operand_a);
+    const auto rhs = readOperandValue(bus_, registers_, inst.operand_b);
+    const auto quotient = alu_.divide(lhs, rhs);
+    const auto remainder = alu_.remainder(lhs, rhs);
+    writeOperandValue(bus_, registers_, inst.operand_a, quotient.value);
+    writeRegister(registers_,
+                  static_cast<std::uint8_t>(inst.modifier &
+                                            kModifierRegisterMask),
+                  remainder.value);
+    registers_.flags = quotient.flags;
+    return true;
+  }
   case Opcode::AND: {
     const auto lhs = readOperandValue(bus_, registers_, inst.operand_a);
     const auto rhs = readOperandValue(bus_, registers_, inst.operand_b);
@@ -318,49 +487,202 @@ bool ControlUnit::execute(const DecodedInstruction &inst, bool) {
     registers_.flags = result.flags;
     return true;
   }
-  case Opcode::CMP: {
+  case Opcode::ROL:
+  case Opcode::ROR:
+  case Opcode::SAR: {
+    const auto value = readOperandValue(bus_, registers_, inst.operand_a);
+    const auto amount = static_cast<std::uint8_t>(
+        readOperandValue(bus_, registers_, inst.operand_b) & 0xFF);
+    const auto result = inst.opcode == Opcode::ROL ? alu_.rol(value, amount)
+                        : inst.opcode == Opcode::ROR
+                            ? alu_.ror(value, amount)
+                            : alu_.sar(value, amount);
+    writeOperandValue(bus_, registers_, inst.operand_a, result.value);
+    registers_.flags = result.flags;
+    return true;
+  }
+  case Opcode::POPCNT:
+  case Opcode::CLZ:
+  case Opcode::CTZ: {
+    // dst = count(src)
+    const auto value = readOperandValue(bus_, registers_, inst.operand_b);
+    const auto result = inst.opcode == Opcode::POPCNT ? alu_.popcnt(value)
+                        : inst.opcode == Opcode::CLZ  ? alu_.clz(value)
+                                                      : alu_.ctz(value);
+    writeOperandValue(bus_, registers_, inst.operand_a, result.value);
+    registers_.flags = result.flags;
+    return true;
+  }
+  case Opcode::BSWAP: {
+    const auto value = readOperandValue(bus_, registers_, inst.operand_a);
+    const auto result = alu_.bswap(value);
+    writeOperandValue(bus_, registers_, inst.operand_a, result.value);
+    registers_.flags = result.flags;
+    return true;
+  }
+  case Opcode::BTST: {
+    const auto value = readOperandValue(bus_, registers_, inst.operand_a);
+    const auto bit = static_cast<std::uint8_t>(
+        readOperandValue(bus_, registers_, inst.operand_b) & 0xFF);
+    registers_.flags = alu_.bit_test(value, bit).flags;
+    return true;
+  }
+  case Opcode::BSET:
+  case Opcode::BCLR: {
+    const auto value = readOperandValue(bus_, registers_, inst.operand_a);
+    const auto bit = static_cast<std::uint8_t>(
+        readOperandValue(bus_, registers_, inst.operand_b) & 0xFF);
+    const auto result = inst.opcode == Opcode::BSET
+                            ? alu_.bit_set(value, bit)
+                            : alu_.bit_clear(value, bit);
+    writeOperandValue(bus_, registers_, inst.operand_a, result.value);
+    registers_.flags = result.flags;
+    return true;
+  }
+  case Opcode::PADDB:
+  case Opcode::PADDUSB:
+  case Opcode::PSUBB:
+  case Opcode::PSUBUSB:
+  case Opcode::PCMPEQB:
+  case Opcode::PCMPHIB:
+  case Opcode::PMINUB:
+  case Opcode::PMAXUB:
+  case Opcode::PACKUSB: {
     const auto lhs = readOperandValue(bus_, registers_, inst.operand_a);
     const auto rhs = readOperandValue(bus_, registers_, inst.operand_b);
-    registers_.flags = alu_.sub(lhs, rhs).flags;
+    ALUResult result;
+    switch (inst.opcode) {
+    case Opcode::PADDB:
+    case Opcode::PADDUSB:
+      result = alu_.padd_b(lhs, rhs, inst.opcode == Opcode::PADDUSB);
+      break;
+    case Opcode::PSUBB:
+    case Opcode::PSUBUSB:
+      result = alu_.psub_b(lhs, rhs, inst.opcode == Opcode::PSUBUSB);
+      break;
+    case Opcode::PCMPEQB:
+      result = alu_.pcmpeq_b(lhs, rhs);
+      break;
+    case Opcode::PCMPHIB:
+      result = alu_.pcmphi_b(lhs, rhs);
+      break;
+    case Opcode::PMINUB:
+      result = alu_.pmin_b(lhs, rhs);
+      break;
+    case Opcode::PMAXUB:
+      result = alu_.pmax_b(lhs, rhs);
+      break;
+    default:
+      result = alu_.pack_b(lhs, rhs);
+      break;
+    }
+    writeOperandValue(bus_, registers_, inst.operand_a, result.value);
+    registers_.flags = result.flags;
     return true;
   }
-  case Opcode::JMP: {
-    const auto target = readOperandValue(bus_, registers_, inst.operand_a);
-    registers_.pc = target;
+  case Opcode::MULQ:
+  case Opcode::MULQ8: {
+    const auto lhs = readOperandValue(bus_, registers_, inst.operand_a);
+    const auto rhs = readOperandValue(bus_, registers_, inst.operand_b);
+    const auto result =
+        alu_.mul_fixed(lhs, rhs, inst.opcode == Opcode::MULQ ? 15 : 8);
+    writeOperandValue(bus_, registers_, inst.operand_a, result.value);
+    registers_.flags = result.flags;
     return true;
   }
-  case Opcode::JZ: {
-    if (registers_.flags.test(StatusFlag::kZero)) {
-      registers_.pc = readOperandValue(bus_, registers_, inst.operand_a);
-    }
+  case Opcode::ADDS:
+  case Opcode::SUBS: {
+    const auto lhs = readOperandValue(bus_, registers_, inst.operand_a);
+    const auto rhs = readOperandValue(bus_, registers_, inst.operand_b);
+    const auto result = inst.opcode == Opcode::ADDS
+                            ? alu_.add_saturating(lhs, rhs)
+                            : alu_.sub_saturating(lhs, rhs);
+    writeOperandValue(bus_, registers_, inst.operand_a, result.value);
+    registers_.flags = result.flags;
     return true;
   }
-  case Opcode::JNZ: {
-    if (!registers_.flags.test(StatusFlag::kZero)) {
-      registers_.pc = readOperandValue(bus_, registers_, inst.operand_a);
-    }
+  case Opcode::ABS:
+  case Opcode::NEG: {
+    const auto value = readOperandValue(bus_, registers_, inst.operand_a);
+    const auto result =
+        inst.opcode == Opcode::ABS ? alu_.abs(value) : alu_.sub(0, value);
+    writeOperandValue(bus_, registers_, inst.operand_a, result.value);
+    registers_.flags = result.flags;
     return true;
   }
-  case Opcode::JN: {
-    if (registers_.flags.test(StatusFlag::kNegative)) {
-      registers_.pc = readOperandValue(bus_, registers_, inst.operand_a);
+  case Opcode::UNPKB: {
+    // UNPKB dst, src, rh: dst = low byte of src, rh = high byte; flags are
+    // left alone, as for MOV
+    const auto value = readOperandValue(bus_, registers_, inst.operand_b);
+    writeOperandValue(bus_, registers_, inst.operand_a,
+                      static_cast<std::uint16_t>(value & 0xFF));
+    writeRegister(registers_,
+                  static_cast<std::uint8_t>(inst.modifier &
+                                            kModifierRegisterMask),
+                  static_cast<std::uint16_t>(value >> 8));
+    return true;
+  }
+  case Opcode::CMP: {
+    const auto lhs = readOperandValue(bus_, registers_, inst.operand_a);
+    const auto rhs = readOperandValue(bus_, registers_, inst.operand_b);
+    registers_.flags = alu_.sub(lhs, rhs).flags;
+    return true;
+  }
+  case Opcode::JMP: {
+    takeBranch(inst, readOperandValue(bus_, registers_, inst.operand_a));
+    return true;
+  }
+  case Opcode::JZ:
+  case Opcode::JNZ:
+  case Opcode::JN:
+  case Opcode::JNN:
+  case Opcode::JC:
+  case Opcode::JNC:
+  case Opcode::JV:
+  case Opcode::JNV:
+  case Opcode::JLT:
+  case Opcode::JGE:
+  case Opcode::JGT:
+  case Opcode::JLE:
+  case Opcode::JB:
+  case Opcode::JAE:
+  case Opcode::JA:
+  case Opcode::JBE: {
+    if (conditionHolds(branchCondition(inst.opcode), registers_.flags)) {
+      takeBranch(inst, readOperandValue(bus_, registers_, inst.operand_a));
     }
     return true;
   }
-  case Opcode::JC: {
-    if (registers_.flags.test(StatusFlag::kCarry)) {
-      registers_.pc = readOperandValue(bus_, registers_, inst.operand_a);
+  case Opcode::BEQ:
+  case Opcode::BNE:
+  case Opcode::BLT: {
+    // Compare-and-branch leaves the flags alone
+    const auto lhs = readOperandValue(bus_, registers_, inst.operand_a);
+    const auto rhs = readOperandValue(bus_, registers_, inst.operand_b);
+    const bool taken =
+        inst.opcode == Opcode::BEQ   ? lhs == rhs
+        : inst.opcode == Opcode::BNE ? lhs != rhs
+                                     : static_cast<std::int16_t>(lhs) <
+                                           static_cast<std::int16_t>(rhs);
+    if (taken) {
+      takeBranch(inst, inst.branch_target);
     }
     return true;
   }
   case Opcode::CALL: {
     const auto target = readOperandValue(bus_, registers_, inst.operand_a);
+    if (profiler_ != nullptr) {
+      profiler_->onCall(target, registers_.pc);
+    }
     push(bus_, registers_, registers_.pc);
-    registers_.pc = target;
+    takeBranch(inst, target);
     return true;
   }
   case Opcode::RET: {
-    registers_.pc = pop(bus_, registers_);
+    takeBranch(inst, pop(bus_, registers_));
+    if (profiler_ != nullptr) {
+      profiler_->onReturn(registers_.pc);
+    }
     return true;
   }
   case Opcode::PUSH: {
@@ -399,19 +721,111 @@ bool ControlUnit::execute(const DecodedInstruction &inst, bool) {
     case 0:
       break;
     case 1:
-      std::cout << "\n";
+      writeConsole(bus_, "\n");
       break;
-    case 2:
-      std::cout << "[R0=" << readRegister(registers_, 0) << "]" << std::endl;
+    case 2: {
+      char text[16];
+      const int length = std::snprintf(
+          text, sizeof(text), "[R0=%u]\n",
+          static_cast<unsigned>(readRegister(registers_, 0)));
+      writeConsole(bus_,
+                   std::string_view(text, static_cast<std::size_t>(length)));
       break;
+    }
     default:
       break;
     }
     return true;
   }
+  case Opcode::MEMCPY: {
+    const auto destination = readOperandValue(bus_, registers_, inst.operand_a);
+    const auto source = readOperandValue(bus_, registers_, inst.operand_b);
+    const auto count = readRegister(
+        registers_, inst.modifier & kModifierRegisterMask);
+    bus_.copyBlock(destination, source, count);
+    // One read and one write bus cycle per word moved
+    bus_.addStallCycles(2 * ((count + 1u) / 2));
+    return true;
+  }
+  case Opcode::MEMSET: {
+    const auto destination = readOperandValue(bus_, registers_, inst.operand_a);
+    const auto value = static_cast<std::uint8_t>(
+        readOperandValue(bus_, registers_, inst.operand_b) & 0xFF);
+    const auto count = readRegister(
+        registers_, inst.modifier & kModifierRegisterMask);
+    bus_.fillBlock(destination, value, count);
+    bus_.addStallCycles((count + 1u) / 2);
+    return true;
+  }
+  case Opcode::MEMCMP: {
+    const auto lhs = readOperandValue(bus_, registers_, inst.operand_a);
+    const auto rhs = readOperandValue(bus_, registers_, inst.operand_b);
+    const auto count = readRegister(
+        registers_, inst.modifier & kModifierRegisterMask);
+    const auto mismatch = bus_.compareBlock(lhs, rhs, count);
+    // Flags as if CMP was applied to the first differing bytes (both zero
+    // when the blocks are equal)
+    registers_.flags = alu_.sub(mismatch.lhs, mismatch.rhs).flags;
+    const auto compared =
+        mismatch.index == count ? mismatch.index : mismatch.index + 1;
+    bus_.addStallCycles(2 * ((compared + 1) / 2));
+    return true;
+  }
+  case Opcode::EI:
+    registers_.interrupts_enabled = true;
+    return true;
+  case Opcode::DI:
+    registers_.interrupts_enabled = false;
+    return true;
+  case Opcode::RETI: {
+    registers_.flags.value = pop(bus_, registers_);
+    takeBranch(inst, pop(bus_, registers_));
+    registers_.interrupts_enabled = true;
+    if (profiler_ != nullptr) {
+      profiler_->onReturn(registers_.pc);
+    }
+    return true;
+  }
+  case Opcode::WAIT:
+    registers_.waiting = true;
+    return true;
+  case Opcode::CAS: {
+    // CAS [addr], rn, re: store rn if the word equals re; re receives the
+    // old word and Z is set iff the swap happened
+    const auto address = operandAddress(registers_, inst.operand_a);
+    if (!address) {
+      fault_address_ = inst.address;
+      return false;
+    }
+    const auto expected_reg =
+        static_cast<std::uint8_t>(inst.modifier & kModifierRegisterMask);
+    const auto expected = readRegister(registers_, expected_reg);
+    const auto desired = readOperandValue(bus_, registers_, inst.operand_b);
+    const auto previous = bus_.compareExchange16(*address, expected, desired);
+    writeRegister(registers_, expected_reg, previous);
+    registers_.flags = alu_.sub(previous, expected).flags;
+    return true;
+  }
+  case Opcode::FADD: {
+    // FADD [addr], rn: add rn to the word; a register operand receives the
+    // old word. Flags describe the sum written back.
+    const auto address = operandAddress(registers_, inst.operand_a);
+    if (!address) {
+      fault_address_ = inst.address;
+      return false;
+    }
+    const auto addend = readOperandValue(bus_, registers_, inst.operand_b);
+    const auto previous = bus_.fetchAdd16(*address, addend);
+    registers_.flags = alu_.add(previous, addend).flags;
+    if (inst.operand_b.type == OperandType::Register) {
+      writeRegister(registers_, inst.operand_b.reg, previous);
+    }
+    return true;
+  }
   default:
-    std::fprintf(stderr, "Unknown opcode %02X at %04X\n",
-                 static_cast<int>(inst.opcode), inst.address);
+    // Reported by the caller (see CPU::faultAddress) so batch users such as
+    // the fuzzer stay quiet
+    fault_address_ = inst.address;
     return false;
   }
 }
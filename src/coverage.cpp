@@ -0,0 +1,33 @@
+#include "softcpu/coverage.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/shm.h>
+#endif
+
+namespace softcpu {
+
+std::size_t EdgeCoverage::edgesHit() const {
+  return static_cast<std::size_t>(
+      std::count_if(map_, map_ + size(), [](std::uint8_t v) { return v; }));
+}
+
+std::uint8_t *attachAflSharedMemory() {
+#if defined(__unix__) || defined(__APPLE__)
+  const char *id = std::getenv("__AFL_SHM_ID");
+  if (id == nullptr) {
+    return nullptr;
+  }
+  void *memory = shmat(std::atoi(id), nullptr, 0);
+  if (memory == reinterpret_cast<void *>(-1)) {
+    return nullptr;
+  }
+  return static_cast<std::uint8_t *>(memory);
+#else
+  return nullptr;
+#endif
+}
+
+} // namespace softcpu
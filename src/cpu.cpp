@@ -2,7 +2,10 @@
 
 #include "softcpu/alu.hpp"
 #include "softcpu/bus.hpp"
+#include "softcpu/cache.hpp"
 #include "softcpu/control_unit.hpp"
+#include "softcpu/device.hpp"
+#include "softcpu/profiler.hpp"
 
 namespace softcpu {
 
@@ -17,14 +20,96 @@ CPU::~CPU() = default;
 void CPU::reset() {
   registers_.reset();
   control_->reset();
+  bus_.takeStallCycles();
+  cycles_ = 0;
+  instructions_ = 0;
 }
 
 bool CPU::step(bool trace) {
   // Update I/O devices (e.g., timers)
-  bus_.tickDevices();
+  if (drives_devices_) {
+    bus_.tickDevices();
+  }
+
+  // Any unmasked pending interrupt wakes WAIT; it is taken only if enabled
+  if (interrupts_ != nullptr && interrupts_->hasPending()) {
+    registers_.waiting = false;
+    if (registers_.interrupts_enabled) {
+      const auto lock = bus_.lockDevices();
+      if (const auto vector = interrupts_->acknowledge()) {
+        control_->enterInterrupt(*vector);
+        const auto cycles = 1 + bus_.takeStallCycles();
+        cycles_ += cycles;
+        if (profiler_ != nullptr) {
+          profiler_->retire(cycles, false, registers_.sp);
+        }
+        return true;
+      }
+    }
+  }
+  if (registers_.waiting && doorbell_ != nullptr &&
+      doorbell_->exchange(false)) {
+    registers_.waiting = false;
+  }
+  if (registers_.waiting) {
+    ++cycles_;
+    if (profiler_ != nullptr) {
+      profiler_->retire(1, false, registers_.sp);
+    }
+    return true;
+  }
 
   // Execute one instruction
-  return control_->step(trace);
+  if (cache_ != nullptr) {
+    cache_->setPc(registers_.pc);
+  }
+  const bool running = control_->step(trace);
+
+  // Devices keep running while the CPU is stalled on the bus
+  const auto stall = bus_.takeStallCycles();
+  if (stall > 0 && drives_devices_) {
+    bus_.advanceDevices(stall);
+  }
+  cycles_ += 1 + stall;
+  ++instructions_;
+  if (profiler_ != nullptr) {
+    profiler_->retire(1 + stall, true, registers_.sp);
+  }
+  return running;
+}
+
+void CPU::attachCoverage(EdgeCoverage *coverage) {
+  control_->setCoverage(coverage);
+}
+
+void CPU::attachPipeline(PipelineModel *pipeline) {
+  control_->setPipeline(pipeline);
+}
+
+void CPU::attachProfiler(CallProfiler *profiler) {
+  profiler_ = profiler;
+  control_->setProfiler(profiler);
+}
+
+bool CPU::faulted() const { return control_->faulted(); }
+
+std::optional<std::uint16_t> CPU::faultAddress() const {
+  return control_->faultAddress();
+}
+
+bool CPU::wakePending() const {
+  return (interrupts_ != nullptr && interrupts_->hasPending()) ||
+         (doorbell_ != nullptr && doorbell_->load());
+}
+
+void CPU::idle(std::uint64_t cycles) {
+  if (drives_devices_) {
+    bus_.advanceDevices(cycles);
+  }
+  cycles_ += cycles;
+  if (profiler_ != nullptr) {
+    profiler_->retire(cycles, false, registers_.sp);
+  }
 }
 
 } // namespace softcpu
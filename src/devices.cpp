@@ -1,6 +1,10 @@
 #include "softcpu/device.hpp"
 
-#include <iostream>
+#include "softcpu/bus.hpp"
+#include "softcpu/memory.hpp"
+
+#include <algorithm>
+#include <utility>
 
 namespace softcpu {
 
@@ -15,13 +19,83 @@ constexpr std::uint8_t kTimerCounterHi = 0x01;
 constexpr std::uint8_t kTimerControl = 0x02;
 constexpr std::uint8_t kTimerPeriodLo = 0x03;
 constexpr std::uint8_t kTimerPeriodHi = 0x04;
+constexpr std::uint8_t kTimerCompareLo = 0x05;
+constexpr std::uint8_t kTimerCompareHi = 0x06;
+
+// Timer control bits
+constexpr std::uint8_t kTimerEnable = 0x01;
+constexpr std::uint8_t kTimerAutoReload = 0x02;
+constexpr std::uint8_t kTimerCompareIrq = 0x04;
+constexpr std::uint8_t kTimerExpired = 0x80;
 
 // LED device offsets
 constexpr std::uint8_t kLedValue = 0x00;
+
+// DMA device offsets
+constexpr std::uint8_t kDmaSourceLo = 0x00;
+constexpr std::uint8_t kDmaSourceHi = 0x01;
+constexpr std::uint8_t kDmaDestLo = 0x02;
+constexpr std::uint8_t kDmaDestHi = 0x03;
+constexpr std::uint8_t kDmaLengthLo = 0x04;
+constexpr std::uint8_t kDmaLengthHi = 0x05;
+constexpr std::uint8_t kDmaMode = 0x06;
+constexpr std::uint8_t kDmaControl = 0x07;
+constexpr std::uint8_t kDmaFill = 0x08;
+
+// Interrupt controller offsets
+constexpr std::uint8_t kIrqPending = 0x00;
+constexpr std::uint8_t kIrqMask = 0x01;
+constexpr std::uint8_t kIrqRaise = 0x02;
+constexpr std::uint8_t kIrqVectors = 0x10;
+
+// MMU offsets
+constexpr std::uint8_t kMmuFramesLo = 0x00;
+constexpr std::uint8_t kMmuFramesHi = 0x01;
+constexpr std::uint8_t kMmuStatus = 0x02;
+constexpr std::uint8_t kMmuBanks = 0x10;
+
+// MMU status bits
+constexpr std::uint8_t kMmuError = 0x40;
+
+// Mailbox offsets: a core count, then one 4-byte slot per core holding the
+// message word and a status byte
+constexpr std::uint8_t kMailboxCores = 0x00;
+constexpr std::uint8_t kMailboxSlots = 0x10;
+constexpr std::uint8_t kMailboxSlotSize = 4;
+constexpr std::uint8_t kMailboxStatus = 2;
+
+// Mailbox status bits
+constexpr std::uint8_t kMailboxPending = 0x80;
+
+// DMA control/status bits
+constexpr std::uint8_t kDmaStart = 0x01;
+constexpr std::uint8_t kDmaError = 0x40;
+constexpr std::uint8_t kDmaDone = 0x80;
+
+// DMA cost model: fixed setup, then 16-bit bus transfers
+constexpr std::uint64_t kDmaSetupCycles = 4;
+
+// Console data register used by memory-to-console transfers
+constexpr std::uint16_t kConsoleDataAddress = 0xFF00;
+
+std::uint8_t lowByte(std::uint16_t value) {
+  return static_cast<std::uint8_t>(value & 0xFF);
+}
+std::uint8_t highByte(std::uint16_t value) {
+  return static_cast<std::uint8_t>((value >> 8) & 0xFF);
+}
+std::uint16_t withLow(std::uint16_t value, std::uint8_t low) {
+  return static_cast<std::uint16_t>((value & 0xFF00) | low);
+}
+std::uint16_t withHigh(std::uint16_t value, std::uint8_t high) {
+  return static_cast<std::uint16_t>((value & 0x00FF) |
+                                    (static_cast<std::uint16_t>(high) << 8));
+}
 } // namespace
 
 // ConsoleDevice implementation
-ConsoleDevice::ConsoleDevice() : IODevice("console", 0xFF00, 0x0010) {}
+ConsoleDevice::ConsoleDevice(std::shared_ptr<ConsoleSink> sink)
+    : IODevice("console", 0xFF00, 0x0010), sink_(std::move(sink)) {}
 
 std::uint8_t ConsoleDevice::read(std::uint16_t offset) {
   switch (offset) {
@@ -34,14 +108,23 @@ std::uint8_t ConsoleDevice::read(std::uint16_t offset) {
 
 void ConsoleDevice::write(std::uint16_t offset, std::uint8_t value) {
   if (offset == kConsoleData) {
-    buffer_.push_back(static_cast<char>(value));
-    std::cout << static_cast<char>(value) << std::flush;
+    sink_->put(static_cast<char>(value));
   }
 }
 
 // TimerDevice implementation
 TimerDevice::TimerDevice() : IODevice("timer", 0xFF10, 0x0010) {}
 
+void TimerDevice::reset() {
+  divider_ = 0;
+  period_ = 1000;
+  counter_ = 0;
+  compare_ = 0;
+  enabled_ = false;
+  auto_reload_ = true;
+  compare_irq_ = false;
+}
+
 std::uint8_t TimerDevice::read(std::uint16_t offset) {
   switch (offset) {
   case kTimerCounterLo:
@@ -50,15 +133,20 @@ std::uint8_t TimerDevice::read(std::uint16_t offset) {
     return static_cast<std::uint8_t>((counter_ >> 8) & 0xFF);
   case kTimerControl: {
     std::uint8_t control = 0;
-    control |= enabled_ ? 0x01 : 0x00;
-    control |= auto_reload_ ? 0x02 : 0x00;
-    control |= (divider_ >= period_) ? 0x80 : 0x00;
+    control |= enabled_ ? kTimerEnable : 0x00;
+    control |= auto_reload_ ? kTimerAutoReload : 0x00;
+    control |= compare_irq_ ? kTimerCompareIrq : 0x00;
+    control |= (divider_ >= period_) ? kTimerExpired : 0x00;
     return control;
   }
   case kTimerPeriodLo:
     return static_cast<std::uint8_t>(period_ & 0xFF);
   case kTimerPeriodHi:
     return static_cast<std::uint8_t>((period_ >> 8) & 0xFF);
+  case kTimerCompareLo:
+    return lowByte(compare_);
+  case kTimerCompareHi:
+    return highByte(compare_);
   default:
     return 0;
   }
@@ -67,9 +155,10 @@ std::uint8_t TimerDevice::read(std::uint16_t offset) {
 void TimerDevice::write(std::uint16_t offset, std::uint8_t value) {
   switch (offset) {
   case kTimerControl:
-    enabled_ = (value & 0x01) != 0;
-    auto_reload_ = (value & 0x02) != 0;
-    if ((value & 0x80) != 0) {
+    enabled_ = (value & kTimerEnable) != 0;
+    auto_reload_ = (value & kTimerAutoReload) != 0;
+    compare_irq_ = (value & kTimerCompareIrq) != 0;
+    if ((value & kTimerExpired) != 0) {
       divider_ = 0;
       counter_ = 0;
     }
@@ -81,6 +170,12 @@ void TimerDevice::write(std::uint16_t offset, std::uint8_t value) {
     period_ = static_cast<std::uint16_t>(
         (period_ & 0x00FF) | (static_cast<std::uint16_t>(value) << 8));
     break;
+  case kTimerCompareLo:
+    compare_ = withLow(compare_, value);
+    break;
+  case kTimerCompareHi:
+    compare_ = withHigh(compare_, value);
+    break;
   default:
     break;
   }
@@ -101,6 +196,72 @@ void TimerDevice::tick() {
       enabled_ = false;
     }
   }
+  if (compare_irq_ && counter_ == compare_) {
+    raiseInterrupt();
+  }
+}
+
+void TimerDevice::advance(std::uint64_t cycles) {
+  if (!enabled_ || cycles == 0) {
+    return;
+  }
+  if (const auto match = cyclesUntilMatch(); match && *match <= cycles) {
+    raiseInterrupt();
+  }
+
+  // Closed form of `cycles` calls to tick()
+  const std::uint64_t divider = divider_;
+  const std::uint64_t period = period_;
+  if (divider + cycles < period) {
+    divider_ = static_cast<std::uint32_t>(divider + cycles);
+    counter_ = static_cast<std::uint16_t>(counter_ + cycles);
+    return;
+  }
+  if (!auto_reload_) {
+    divider_ = static_cast<std::uint32_t>(std::max(divider + 1, period));
+    counter_ = static_cast<std::uint16_t>(counter_ + (divider_ - divider));
+    enabled_ = false;
+    return;
+  }
+  const std::uint64_t first_wrap = divider < period ? period - divider : 1;
+  const std::uint64_t remaining = cycles - first_wrap;
+  // Counter and divider restart together on every reload
+  divider_ =
+      period == 0 ? 0 : static_cast<std::uint32_t>(remaining % period);
+  counter_ = static_cast<std::uint16_t>(divider_);
+}
+
+std::optional<std::uint64_t> TimerDevice::cyclesUntilEvent() const {
+  return cyclesUntilMatch();
+}
+
+std::optional<std::uint64_t> TimerDevice::cyclesUntilMatch() const {
+  if (!enabled_ || !compare_irq_) {
+    return std::nullopt;
+  }
+  // The counter restarts with the divider, so the two always agree
+  const std::uint64_t divider = divider_;
+  const std::uint64_t period = period_;
+  const std::uint64_t compare = compare_;
+  if (!auto_reload_) {
+    // Counts up to the period once, then stops
+    const std::uint64_t last = std::max(divider + 1, period);
+    if (compare > divider && compare <= last) {
+      return compare - divider;
+    }
+    return std::nullopt;
+  }
+  if (period == 0) {
+    return compare == 0 ? std::optional<std::uint64_t>(1) : std::nullopt;
+  }
+  if (compare >= period) {
+    return std::nullopt; // Reload happens before the counter gets there
+  }
+  if (compare > divider) {
+    return compare - divider;
+  }
+  const std::uint64_t to_reload = divider < period ? period - divider : 1;
+  return to_reload + compare;
 }
 
 // LedPanel implementation
@@ -119,4 +280,330 @@ void LedPanel::write(std::uint16_t offset, std::uint8_t value) {
   }
 }
 
+// DmaController implementation
+DmaController::DmaController(Bus &bus, ConsoleDevice &console)
+    : IODevice("dma", 0xFF30, 0x0010), bus_(bus), console_(console) {}
+
+void DmaController::reset() {
+  source_ = 0;
+  destination_ = 0;
+  length_ = 0;
+  mode_ = 0;
+  fill_ = 0;
+  done_ = false;
+  error_ = false;
+}
+
+std::uint8_t DmaController::read(std::uint16_t offset) {
+  switch (offset) {
+  case kDmaSourceLo:
+    return lowByte(source_);
+  case kDmaSourceHi:
+    return highByte(source_);
+  case kDmaDestLo:
+    return lowByte(destination_);
+  case kDmaDestHi:
+    return highByte(destination_);
+  case kDmaLengthLo:
+    return lowByte(length_);
+  case kDmaLengthHi:
+    return highByte(length_);
+  case kDmaMode:
+    return mode_;
+  case kDmaControl: {
+    std::uint8_t status = 0;
+    status |= error_ ? kDmaError : 0x00;
+    status |= done_ ? kDmaDone : 0x00;
+    return status;
+  }
+  case kDmaFill:
+    return fill_;
+  default:
+    return 0;
+  }
+}
+
+void DmaController::write(std::uint16_t offset, std::uint8_t value) {
+  switch (offset) {
+  case kDmaSourceLo:
+    source_ = withLow(source_, value);
+    break;
+  case kDmaSourceHi:
+    source_ = withHigh(source_, value);
+    break;
+  case kDmaDestLo:
+    destination_ = withLow(destination_, value);
+    break;
+  case kDmaDestHi:
+    destination_ = withHigh(destination_, value);
+    break;
+  case kDmaLengthLo:
+    length_ = withLow(length_, value);
+    break;
+  case kDmaLengthHi:
+    length_ = withHigh(length_, value);
+    break;
+  case kDmaMode:
+    mode_ = value;
+    break;
+  case kDmaControl:
+    if ((value & kDmaStart) != 0) {
+      done_ = false;
+      error_ = false;
+      bus_.addStallCycles(transfer());
+      // An invalid mode only reports the error; nothing completed
+      if (!error_) {
+        done_ = true;
+        raiseInterrupt();
+      }
+    }
+    break;
+  case kDmaFill:
+    fill_ = value;
+    break;
+  default:
+    break;
+  }
+}
+
+std::uint64_t DmaController::transfer() {
+  const std::size_t count = length_;
+  const std::uint64_t words = (count + 1) / 2;
+  switch (static_cast<Mode>(mode_)) {
+  case Mode::Copy:
+    bus_.copyBlock(destination_, source_, count);
+    // One read and one write bus cycle per word
+    return kDmaSetupCycles + 2 * words;
+  case Mode::Fill:
+    bus_.fillBlock(destination_, fill_, count);
+    return kDmaSetupCycles + words;
+  case Mode::ToConsole: {
+    // A RAM source goes to the console back end in one write
+    if (const auto *source = bus_.readSpan(source_, count)) {
+      console_.emit(std::string_view(
+          reinterpret_cast<const char *>(source), count));
+      return kDmaSetupCycles + 2 * count;
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+      bus_.write8(kConsoleDataAddress,
+                  bus_.read8(static_cast<std::uint16_t>(source_ + i)));
+    }
+    // Byte-wide port: one read and one write per byte
+    return kDmaSetupCycles + 2 * count;
+  }
+  }
+  error_ = true;
+  return kDmaSetupCycles;
+}
+
+// MmuDevice implementation
+MmuDevice::MmuDevice(Bus &bus, Memory &memory)
+    : IODevice("mmu", 0xFF60, 0x0030), bus_(bus), memory_(memory) {
+  reset();
+}
+
+void MmuDevice::reset() {
+  for (std::size_t page = 0; page < kPageCount; ++page) {
+    map(page, static_cast<std::uint16_t>(page));
+  }
+  latch_ = 0;
+  error_ = false;
+}
+
+void MmuDevice::setPhysicalSize(std::size_t bytes) {
+  const auto frames =
+      std::clamp((bytes + kPageSize - 1) / kPageSize, kPageCount, kMaxFrames);
+  extended_.assign((frames - kPageCount) * kPageSize, 0);
+  // The old extended store is gone; drop any mapping into it
+  reset();
+}
+
+std::uint8_t *MmuDevice::frame(std::size_t index) {
+  if (index < kPageCount) {
+    return memory_.data() + index * kPageSize;
+  }
+  if (index < frameCount()) {
+    return extended_.data() + (index - kPageCount) * kPageSize;
+  }
+  return nullptr;
+}
+
+void MmuDevice::clearExtended() {
+  std::fill(extended_.begin(), extended_.end(), 0);
+}
+
+void MmuDevice::restoreExtended(const std::vector<std::uint8_t> &bytes) {
+  if (bytes.size() == extended_.size()) {
+    std::copy(bytes.begin(), bytes.end(), extended_.begin());
+  }
+}
+
+void MmuDevice::map(std::size_t page, std::uint16_t frame_index) {
+  banks_[page] = frame_index;
+  bus_.mapPage(page, frame(frame_index));
+}
+
+std::uint8_t MmuDevice::read(std::uint16_t offset) {
+  if (offset >= kMmuBanks && offset < kMmuBanks + 2 * kPageCount) {
+    const auto bank = banks_[(offset - kMmuBanks) / 2];
+    return (offset & 0x01) == 0 ? lowByte(bank) : highByte(bank);
+  }
+  switch (offset) {
+  case kMmuFramesLo:
+    return lowByte(static_cast<std::uint16_t>(frameCount()));
+  case kMmuFramesHi:
+    return highByte(static_cast<std::uint16_t>(frameCount()));
+  case kMmuStatus:
+    return error_ ? kMmuError : 0x00;
+  default:
+    return 0;
+  }
+}
+
+void MmuDevice::write(std::uint16_t offset, std::uint8_t value) {
+  if (offset >= kMmuBanks && offset < kMmuBanks + 2 * kPageCount) {
+    if ((offset & 0x01) == 0) {
+      latch_ = value;
+      return;
+    }
+    const auto frame_index = withHigh(latch_, value);
+    if (frame_index >= frameCount()) {
+      error_ = true; // Keep the old mapping
+      return;
+    }
+    map(static_cast<std::size_t>(offset - kMmuBanks) / 2, frame_index);
+    return;
+  }
+  if (offset == kMmuStatus) {
+    error_ = false; // Any write clears the error flag
+  }
+}
+
+// Mailbox implementation
+Mailbox::Mailbox() : IODevice("mailbox", 0xFF90, 0x0030) {}
+
+void Mailbox::reset() {
+  messages_.fill(0);
+  latches_.fill(0);
+  pending_.fill(false);
+  for (auto &doorbell : doorbells_) {
+    doorbell = false;
+  }
+}
+
+std::uint8_t Mailbox::read(std::uint16_t offset) {
+  if (offset == kMailboxCores) {
+    return static_cast<std::uint8_t>(cores_);
+  }
+  if (offset < kMailboxSlots ||
+      offset >= kMailboxSlots + kMailboxSlotSize * kMaxCores) {
+    return 0;
+  }
+  const std::size_t core = (offset - kMailboxSlots) / kMailboxSlotSize;
+  switch ((offset - kMailboxSlots) % kMailboxSlotSize) {
+  case 0:
+    return lowByte(messages_[core]);
+  case 1:
+    return highByte(messages_[core]);
+  case kMailboxStatus:
+    return pending_[core] ? kMailboxPending : 0x00;
+  default:
+    return 0;
+  }
+}
+
+void Mailbox::write(std::uint16_t offset, std::uint8_t value) {
+  if (offset < kMailboxSlots ||
+      offset >= kMailboxSlots + kMailboxSlotSize * kMaxCores) {
+    return;
+  }
+  const std::size_t core = (offset - kMailboxSlots) / kMailboxSlotSize;
+  switch ((offset - kMailboxSlots) % kMailboxSlotSize) {
+  case 0:
+    latches_[core] = value;
+    break;
+  case 1:
+    messages_[core] = withHigh(latches_[core], value);
+    pending_[core] = true;
+    doorbells_[core] = true;
+    break;
+  case kMailboxStatus:
+    pending_[core] = false; // Any write acknowledges the message
+    break;
+  default:
+    break;
+  }
+}
+
+// InterruptLine implementation
+void InterruptLine::raise() const {
+  if (controller != nullptr) {
+    controller->raise(line);
+  }
+}
+
+bool IODevice::interruptUnmasked() const {
+  return irq_.controller != nullptr && irq_.controller->unmasked(irq_.line);
+}
+
+// InterruptController implementation
+InterruptController::InterruptController()
+    : IODevice("irq", 0xFF40, 0x0020) {}
+
+void InterruptController::reset() {
+  vectors_.fill(0);
+  pending_ = 0;
+  mask_ = 0;
+}
+
+std::uint8_t InterruptController::read(std::uint16_t offset) {
+  if (offset >= kIrqVectors && offset < kIrqVectors + 2 * kLineCount) {
+    const auto vector = vectors_[(offset - kIrqVectors) / 2];
+    return (offset & 0x01) == 0 ? lowByte(vector) : highByte(vector);
+  }
+  switch (offset) {
+  case kIrqPending:
+    return pending_;
+  case kIrqMask:
+    return mask_;
+  default:
+    return 0;
+  }
+}
+
+void InterruptController::write(std::uint16_t offset, std::uint8_t value) {
+  if (offset >= kIrqVectors && offset < kIrqVectors + 2 * kLineCount) {
+    auto &vector = vectors_[(offset - kIrqVectors) / 2];
+    vector = (offset & 0x01) == 0 ? withLow(vector, value)
+                                  : withHigh(vector, value);
+    return;
+  }
+  switch (offset) {
+  case kIrqPending:
+    // Write one to clear
+    pending_ &= static_cast<std::uint8_t>(~value);
+    break;
+  case kIrqMask:
+    mask_ = value;
+    break;
+  case kIrqRaise:
+    pending_ |= value;
+    break;
+  default:
+    break;
+  }
+}
+
+std::optional<std::uint16_t> InterruptController::acknowledge() {
+  const std::uint8_t active = pending_ & mask_;
+  for (std::size_t line = 0; line < kLineCount; ++line) {
+    const auto bit = static_cast<std::uint8_t>(1u << line);
+    if ((active & bit) != 0) {
+      pending_ &= static_cast<std::uint8_t>(~bit);
+      return vectors_[line];
+    }
+  }
+  return std::nullopt;
+}
+
 } // namespace softcpu
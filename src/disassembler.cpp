@@ -0,0 +1,658 @@
+#include "softcpu/disassembler.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <set>
+
+namespace softcpu {
+
+namespace {
+// How an instruction passes control on
+enum class Flow : std::uint8_t {
+  Next,   // Falls through
+  Branch, // Conditional: target or fallthrough
+  Jump,   // Unconditional jump
+  Call,   // Returns to the fallthrough
+  Stop    // RET, RETI, HALT
+};
+
+Flow flowOf(const DecodedInstruction &inst) {
+  if (isConditionalBranch(inst.opcode)) {
+    return Flow::Branch;
+  }
+  // A predicated jump, return or HALT may fall through
+  const bool predicated = conditionOf(inst.modifier) != Condition::Always;
+  switch (inst.opcode) {
+  case Opcode::JMP:
+    return predicated ? Flow::Branch : Flow::Jump;
+  case Opcode::CALL:
+    return Flow::Call;
+  case Opcode::RET:
+  case Opcode::RETI:
+  case Opcode::HALT:
+    return predicated ? Flow::Branch : Flow::Stop;
+  default:
+    return Flow::Next;
+  }
+}
+
+// Instructions whose cycle count depends on data or devices
+bool hasVariableCost(Opcode opcode) {
+  return opcode == Opcode::MEMCPY || opcode == Opcode::MEMSET ||
+         opcode == Opcode::MEMCMP || opcode == Opcode::WAIT;
+}
+
+std::string hex16(std::uint16_t value) {
+  char text[8];
+  std::snprintf(text, sizeof(text), "0x%04X", value);
+  return text;
+}
+
+std::string registerName(std::uint8_t index) {
+  if (index == kRegisterCount - 1) {
+    return "SP";
+  }
+  char text[8];
+  std::snprintf(text, sizeof(text), "R%u", static_cast<unsigned>(index));
+  return text;
+}
+
+// Symbol name for an address, or the address in hex
+std::string addressName(std::uint16_t address, const util::SymbolMap &symbols) {
+  const auto it = symbols.find(address);
+  return it != symbols.end() ? it->second : hex16(address);
+}
+
+// `byte_step` is the default auto-index step (byte accesses)
+std::string formatOperand(const Operand &operand, bool code_target,
+                          bool byte_step, const util::SymbolMap &symbols) {
+  char text[64];
+  switch (operand.type) {
+  case OperandType::Register:
+    return registerName(operand.reg);
+  case OperandType::RegisterIndirect: {
+    // A byte step on a word access is spelled out: [R0]+1, -1[R0]
+    const char *step = operand.step == 1 && !byte_step ? "1" : "";
+    switch (operand.auto_index) {
+    case AutoIndex::PostIncrement:
+      std::snprintf(text, sizeof(text), "[%s]+%s",
+                    registerName(operand.reg).c_str(), step);
+      break;
+    case AutoIndex::PreDecrement:
+      std::snprintf(text, sizeof(text), "-%s[%s]", step,
+                    registerName(operand.reg).c_str());
+      break;
+    case AutoIndex::None:
+      std::snprintf(text, sizeof(text), "[%s]",
+                    registerName(operand.reg).c_str());
+      break;
+    }
+    return text;
+  }
+  case OperandType::RegisterIndexed: {
+    const int offset = operand.offset;
+    std::snprintf(text, sizeof(text), "[%s %c %d]",
+                  registerName(operand.reg).c_str(), offset < 0 ? '-' : '+',
+                  offset < 0 ? -offset : offset);
+    return text;
+  }
+  case OperandType::Immediate:
+    if (code_target) {
+      return addressName(operand.value, symbols);
+    }
+    std::snprintf(text, sizeof(text), operand.value < 10 ? "#%u" : "#0x%04X",
+                  static_cast<unsigned>(operand.value));
+    return text;
+  case OperandType::Absolute: {
+    std::string name = "[";
+    name += addressName(operand.value, symbols);
+    name += ']';
+    return name;
+  }
+  case OperandType::Port:
+    std::snprintf(text, sizeof(text), "port:%u",
+                  static_cast<unsigned>(operand.value));
+    return text;
+  default:
+    return "?";
+  }
+}
+
+// Graphviz string literal contents
+std::string escapeDot(const std::string &text) {
+  std::string escaped;
+  for (const char ch : text) {
+    if (ch == '"' || ch == '\\') {
+      escaped += '\\';
+    }
+    escaped += ch;
+  }
+  return escaped;
+}
+
+// Listing prefix for an edge: T taken, F fallthrough, C call
+const char *edgeTag(EdgeKind kind) {
+  switch (kind) {
+  case EdgeKind::Taken:
+    return "T";
+  case EdgeKind::Fallthrough:
+    return "F";
+  case EdgeKind::Call:
+    return "C";
+  }
+  return "?";
+}
+
+// Mark loop headers and nesting depth from the dominator tree
+void annotateLoops(ControlFlowGraph &cfg) {
+  // Dominators over intra-procedural edges (Cooper, Harvey and Kennedy),
+  // with a virtual root entering every function
+  const std::size_t count = cfg.blocks.size();
+  const std::size_t root = count;
+  std::vector<std::vector<std::size_t>> successors(count + 1);
+  std::vector<std::vector<std::size_t>> predecessors(count + 1);
+  const auto connect = [&](std::size_t from, std::size_t to) {
+    successors[from].push_back(to);
+    predecessors[to].push_back(from);
+  };
+  for (const auto entry : cfg.functions) {
+    if (const auto index = cfg.blockAt(entry)) {
+      connect(root, *index);
+    }
+  }
+  for (const auto &edge : cfg.edges) {
+    if (edge.kind != EdgeKind::Call) {
+      connect(*cfg.blockAt(edge.from), *cfg.blockAt(edge.to));
+    }
+  }
+  // Code entered only through a cycle (a root that loops back to itself)
+  // still needs a path from the virtual root
+  {
+    std::vector<bool> seen(count + 1);
+    std::vector<std::size_t> pending{root};
+    const auto mark = [&]() {
+      while (!pending.empty()) {
+        const auto node = pending.back();
+        pending.pop_back();
+        if (!seen[node]) {
+          seen[node] = true;
+          pending.insert(pending.end(), successors[node].begin(),
+                         successors[node].end());
+        }
+      }
+    };
+    mark();
+    for (std::size_t i = 0; i < count; ++i) {
+      if (!seen[i]) {
+        connect(root, i);
+        pending.push_back(i);
+        mark();
+      }
+    }
+  }
+
+  // Reverse postorder from the virtual root
+  std::vector<std::size_t> order;
+  std::vector<std::size_t> rank(count + 1, 0);
+  {
+    std::vector<bool> seen(count + 1);
+    std::vector<std::pair<std::size_t, std::size_t>> stack{{root, 0}};
+    seen[root] = true;
+    while (!stack.empty()) {
+      auto &[node, child] = stack.back();
+      if (child < successors[node].size()) {
+        const auto next = successors[node][child++];
+        if (!seen[next]) {
+          seen[next] = true;
+          stack.emplace_back(next, 0);
+        }
+      } else {
+        order.push_back(node);
+        stack.pop_back();
+      }
+    }
+    std::reverse(order.begin(), order.end());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+      rank[order[i]] = i;
+    }
+  }
+  constexpr std::size_t kNone = static_cast<std::size_t>(-1);
+  std::vector<std::size_t> idom(count + 1, kNone);
+  idom[root] = root;
+  const auto intersect = [&](std::size_t a, std::size_t b) {
+    while (a != b) {
+      while (rank[a] > rank[b]) {
+        a = idom[a];
+      }
+      while (rank[b] > rank[a]) {
+        b = idom[b];
+      }
+    }
+    return a;
+  };
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (const auto node : order) {
+      if (node == root) {
+        continue;
+      }
+      std::size_t dominator = kNone;
+      for (const auto pred : predecessors[node]) {
+        if (idom[pred] != kNone) {
+          dominator = dominator == kNone ? pred : intersect(pred, dominator);
+        }
+      }
+      if (dominator != kNone && idom[node] != dominator) {
+        idom[node] = dominator;
+        changed = true;
+      }
+    }
+  }
+  const auto dominates = [&](std::size_t a, std::size_t b) {
+    for (; idom[b] != kNone; b = idom[b]) {
+      if (b == a) {
+        return true;
+      }
+      if (b == root) {
+        return false;
+      }
+    }
+    return false;
+  };
+
+  // Natural loops: each back edge (tail -> dominating header) pulls in the
+  // blocks that reach the tail without passing the header
+  std::vector<std::vector<bool>> bodies(count);
+  for (std::size_t tail = 0; tail < count; ++tail) {
+    for (const auto header : successors[tail]) {
+      if (!dominates(header, tail)) {
+        continue;
+      }
+      auto &body = bodies[header];
+      if (body.empty()) {
+        body.assign(count, false);
+        body[header] = true;
+        ++cfg.loops;
+        cfg.blocks[header].loop_header = true;
+      }
+      std::vector<std::size_t> pending{tail};
+      while (!pending.empty()) {
+        const auto node = pending.back();
+        pending.pop_back();
+        if (body[node]) {
+          continue;
+        }
+        body[node] = true;
+        for (const auto pred : predecessors[node]) {
+          if (pred != root) {
+            pending.push_back(pred);
+          }
+        }
+      }
+    }
+  }
+  for (const auto &body : bodies) {
+    for (std::size_t i = 0; i < body.size(); ++i) {
+      cfg.blocks[i].loop_depth += body[i] ? 1 : 0;
+    }
+  }
+}
+} // namespace
+
+std::optional<std::size_t>
+ControlFlowGraph::blockAt(std::uint16_t address) const {
+  const auto it = std::lower_bound(
+      blocks.begin(), blocks.end(), address,
+      [](const BasicBlock &block, std::uint16_t start) {
+        return block.start < start;
+      });
+  if (it == blocks.end() || it->start != address) {
+    return std::nullopt;
+  }
+  return static_cast<std::size_t>(it - blocks.begin());
+}
+
+Disassembler::Disassembler(const std::uint8_t *memory, std::uint16_t begin,
+                           std::size_t end)
+    : memory_(memory), begin_(begin), end_(std::min(end, kMemorySize)) {}
+
+std::optional<DecodedInstruction>
+Disassembler::decode(std::uint16_t address) const {
+  if (!inRange(address) ||
+      std::size_t{address} + kInstructionHeaderSize > end_ ||
+      !isKnownOpcode(memory_[address])) {
+    return std::nullopt;
+  }
+  DecodedInstruction inst;
+  inst.address = address;
+  inst.opcode = static_cast<Opcode>(memory_[address]);
+  inst.modifier = memory_[address + 3];
+  std::size_t pc = address + kInstructionHeaderSize;
+  // Same operand order and extension words as ControlUnit::resolveOperand
+  const std::pair<std::uint8_t, Operand *> operands[] = {
+      {memory_[address + 1], &inst.operand_a},
+      {memory_[address + 2], &inst.operand_b}};
+  for (const auto &[raw, operand] : operands) {
+    const auto descriptor = decodeOperand(raw);
+    if (descriptor.type == OperandType::None) {
+      continue;
+    }
+    operand->type = descriptor.type;
+    operand->reg = descriptor.payload;
+    if (descriptor.type == OperandType::Register ||
+        descriptor.type == OperandType::RegisterIndirect ||
+        descriptor.type == OperandType::RegisterIndexed) {
+      operand->reg &= 0x07;
+    }
+    if (descriptor.type == OperandType::Port) {
+      operand->value = descriptor.payload;
+    }
+    if (operandNeedsWord(descriptor.type)) {
+      if (pc + 2 > end_) {
+        return std::nullopt;
+      }
+      const auto word = static_cast<std::uint16_t>(
+          memory_[pc] | (memory_[pc + 1] << 8));
+      pc += 2;
+      if (descriptor.type == OperandType::RegisterIndexed) {
+        operand->offset = static_cast<std::int16_t>(word);
+        operand->has_offset = true;
+      } else {
+        operand->value = word;
+      }
+    }
+  }
+  if (isCompareBranch(inst.opcode)) {
+    if (pc + 2 > end_) {
+      return std::nullopt;
+    }
+    inst.branch_target =
+        static_cast<std::uint16_t>(memory_[pc] | (memory_[pc + 1] << 8));
+    pc += 2;
+  }
+  inst.size_bytes = static_cast<std::uint16_t>(pc - address);
+  decodeAutoIndex(inst);
+  return inst;
+}
+
+std::string Disassembler::format(const DecodedInstruction &inst,
+                                 const util::SymbolMap &symbols) {
+  std::string text = opcodeName(inst.opcode);
+  const bool byte_access = isByteAccess(inst);
+  if (byte_access) {
+    text += (inst.modifier & kSignExtend) != 0 ? ".SB" : ".B";
+  }
+  if (const auto condition = conditionOf(inst.modifier);
+      condition != Condition::Always) {
+    text += '.';
+    text += conditionName(condition);
+  }
+  // Operand A names the target of jumps and calls, but not of BEQ/BNE/BLT
+  const bool control =
+      flowOf(inst) != Flow::Next && !isCompareBranch(inst.opcode);
+  const Operand *operands[] = {&inst.operand_a, &inst.operand_b};
+  const char *separator = " ";
+  for (const auto *operand : operands) {
+    if (operand->type == OperandType::None) {
+      continue;
+    }
+    text += separator;
+    text += formatOperand(*operand, control && operand == &inst.operand_a,
+                          byte_access, symbols);
+    separator = ", ";
+  }
+  if (usesModifierRegister(inst.opcode)) {
+    text += separator;
+    text += registerName(inst.modifier & kModifierRegisterMask);
+  }
+  if (isCompareBranch(inst.opcode)) {
+    text += separator;
+    text += addressName(inst.branch_target, symbols);
+  }
+  return text;
+}
+
+ControlFlowGraph
+Disassembler::recover(const std::vector<std::uint16_t> &roots) const {
+  ControlFlowGraph cfg;
+  for (const auto root : roots) {
+    if (inRange(root)) {
+      cfg.roots.push_back(root);
+    }
+  }
+  std::sort(cfg.roots.begin(), cfg.roots.end());
+  cfg.roots.erase(std::unique(cfg.roots.begin(), cfg.roots.end()),
+                  cfg.roots.end());
+
+  // Pass 1: decode every reachable instruction and mark block leaders
+  std::vector<std::int32_t> decoded_at(kMemorySize, -1);
+  std::vector<DecodedInstruction> decoded;
+  std::vector<bool> leader(kMemorySize);
+  std::vector<bool> undecodable(kMemorySize);
+  std::set<std::uint16_t> functions;
+  std::vector<std::uint16_t> work(cfg.roots.rbegin(), cfg.roots.rend());
+  const auto follow = [&](std::uint16_t target) {
+    leader[target] = true;
+    work.push_back(target);
+  };
+  for (const auto root : cfg.roots) {
+    leader[root] = true;
+  }
+  while (!work.empty()) {
+    std::size_t address = work.back();
+    work.pop_back();
+    while (inRange(address)) {
+      if (decoded_at[address] >= 0) {
+        leader[address] = true; // Joins code decoded earlier
+        break;
+      }
+      if (undecodable[address]) {
+        break;
+      }
+      const auto inst = decode(static_cast<std::uint16_t>(address));
+      if (!inst) {
+        undecodable[address] = true;
+        break;
+      }
+      decoded_at[address] = static_cast<std::int32_t>(decoded.size());
+      decoded.push_back(*inst);
+      const std::size_t next = address + inst->size_bytes;
+      const auto target = directTarget(*inst);
+      const auto flow = flowOf(*inst);
+      if (flow == Flow::Stop || (flow == Flow::Jump && !target)) {
+        break;
+      }
+      if (target) {
+        follow(*target);
+        if (flow == Flow::Call) {
+          functions.insert(*target);
+        }
+      }
+      if (flow == Flow::Jump) {
+        break;
+      }
+      if (flow == Flow::Branch && next < kMemorySize) {
+        leader[next] = true;
+      }
+      address = next;
+    }
+  }
+
+  // Pass 2: cut the decoded instructions into blocks in address order
+  std::size_t expected = kMemorySize + 1;
+  bool open = false;
+  for (std::size_t address = begin_; address < end_; ++address) {
+    if (decoded_at[address] < 0) {
+      continue;
+    }
+    const auto &inst = decoded[static_cast<std::size_t>(decoded_at[address])];
+    if (!open || leader[address] || address != expected) {
+      cfg.blocks.emplace_back();
+      cfg.blocks.back().start = inst.address;
+    }
+    auto &block = cfg.blocks.back();
+    block.instructions.push_back(inst);
+    ++block.cycles;
+    block.variable_cost = block.variable_cost || hasVariableCost(inst.opcode);
+    expected = address + inst.size_bytes;
+    const auto flow = flowOf(inst);
+    open = flow == Flow::Next || flow == Flow::Call;
+  }
+
+  // Edges; a successor that could not be decoded makes the block invalid
+  for (auto &block : cfg.blocks) {
+    const auto &last = block.instructions.back();
+    const std::size_t next = last.address + last.size_bytes;
+    const auto flow = flowOf(last);
+    const auto link = [&](std::size_t to, EdgeKind kind) {
+      if (to < kMemorySize &&
+          cfg.blockAt(static_cast<std::uint16_t>(to))) {
+        cfg.edges.push_back(
+            {block.start, static_cast<std::uint16_t>(to), kind});
+      } else {
+        block.invalid = true;
+      }
+    };
+    for (const auto &inst : block.instructions) {
+      if (flowOf(inst) == Flow::Call) {
+        if (const auto target = directTarget(inst);
+            target && cfg.blockAt(*target)) {
+          cfg.edges.push_back({block.start, *target, EdgeKind::Call});
+        }
+      }
+    }
+    if (flow == Flow::Branch || flow == Flow::Jump) {
+      if (const auto target = directTarget(last)) {
+        link(*target, EdgeKind::Taken);
+      }
+    }
+    if (flow == Flow::Next || flow == Flow::Call || flow == Flow::Branch) {
+      link(next, EdgeKind::Fallthrough);
+    }
+  }
+
+  // Roots that no branch or fallthrough reaches start functions of their
+  // own; the rest are labels inside code already found
+  std::set<std::uint16_t> reached;
+  for (const auto &edge : cfg.edges) {
+    if (edge.kind != EdgeKind::Call) {
+      reached.insert(edge.to);
+    }
+  }
+  for (const auto root : cfg.roots) {
+    if (!reached.count(root) && cfg.blockAt(root)) {
+      functions.insert(root);
+    }
+  }
+  cfg.functions.assign(functions.begin(), functions.end());
+
+  annotateLoops(cfg);
+  return cfg;
+}
+
+void Disassembler::writeListing(std::ostream &out, const ControlFlowGraph &cfg,
+                                const util::SymbolMap &symbols) const {
+  std::size_t instructions = 0;
+  for (const auto &block : cfg.blocks) {
+    instructions += block.instructions.size();
+  }
+  out << "; " << cfg.blocks.size() << " blocks, " << instructions
+      << " instructions, " << cfg.functions.size() << " functions, "
+      << cfg.loops << " loops\n"
+      << "; edges: T taken, F fallthrough, C call\n";
+
+  // Incoming and outgoing edges per block
+  std::vector<std::string> from(cfg.blocks.size());
+  std::vector<std::string> to(cfg.blocks.size());
+  for (const auto &edge : cfg.edges) {
+    const auto source = *cfg.blockAt(edge.from);
+    const auto target = *cfg.blockAt(edge.to);
+    char text[16];
+    std::snprintf(text, sizeof(text), " %s:0x%04X", edgeTag(edge.kind),
+                  edge.from);
+    from[target] += text;
+    std::snprintf(text, sizeof(text), " %s:0x%04X", edgeTag(edge.kind),
+                  edge.to);
+    to[source] += text;
+  }
+  char line[160];
+  for (std::size_t i = 0; i < cfg.blocks.size(); ++i) {
+    const auto &block = cfg.blocks[i];
+    out << '\n';
+    std::snprintf(line, sizeof(line),
+                  "; block 0x%04X: %zu instructions, %llu%s cycles, loop "
+                  "depth %u%s%s\n",
+                  block.start, block.instructions.size(),
+                  static_cast<unsigned long long>(block.cycles),
+                  block.variable_cost ? "+" : "", block.loop_depth,
+                  block.loop_header ? ", loop header" : "",
+                  block.invalid ? ", INVALID successor" : "");
+    out << line;
+    if (!from[i].empty()) {
+      out << ";   from" << from[i] << '\n';
+    }
+    if (!to[i].empty()) {
+      out << ";   to" << to[i] << '\n';
+    }
+    for (const auto &inst : block.instructions) {
+      if (const auto it = symbols.find(inst.address); it != symbols.end()) {
+        out << it->second << ":\n";
+      }
+      std::string bytes;
+      for (std::size_t b = 0; b < inst.size_bytes; ++b) {
+        char hex[4];
+        std::snprintf(hex, sizeof(hex), "%02X ", memory_[inst.address + b]);
+        bytes += hex;
+      }
+      std::snprintf(line, sizeof(line), "  %04X  %-24s %s\n", inst.address,
+                    bytes.c_str(), format(inst, symbols).c_str());
+      out << line;
+    }
+  }
+}
+
+void Disassembler::writeDot(std::ostream &out, const ControlFlowGraph &cfg,
+                            const util::SymbolMap &symbols) {
+  out << "digraph cfg {\n"
+      << "  node [shape=box fontname=\"monospace\"];\n";
+  char line[96];
+  for (const auto &block : cfg.blocks) {
+    std::string label;
+    if (const auto it = symbols.find(block.start); it != symbols.end()) {
+      label += escapeDot(it->second);
+      label += ":\\l";
+    }
+    for (const auto &inst : block.instructions) {
+      std::snprintf(line, sizeof(line), "%04X  ", inst.address);
+      label += line;
+      label += escapeDot(format(inst, symbols));
+      label += "\\l";
+    }
+    std::snprintf(line, sizeof(line), "%llu%s cycles, depth %u\\l",
+                  static_cast<unsigned long long>(block.cycles),
+                  block.variable_cost ? "+" : "", block.loop_depth);
+    label += line;
+    std::snprintf(line, sizeof(line), "  b%04X [label=\"", block.start);
+    out << line << label << '"';
+    if (block.loop_header) {
+      out << " penwidth=2";
+    }
+    if (block.invalid) {
+      out << " color=red";
+    }
+    out << "];\n";
+  }
+  for (const auto &edge : cfg.edges) {
+    std::snprintf(line, sizeof(line), "  b%04X -> b%04X", edge.from, edge.to);
+    out << line;
+    if (edge.kind == EdgeKind::Fallthrough) {
+      out << " [style=dashed]";
+    } else if (edge.kind == EdgeKind::Call) {
+      out << " [style=dotted]";
+    }
+    out << ";\n";
+  }
+  out << "}\n";
+}
+
+} // namespace softcpu
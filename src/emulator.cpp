@@ -3,13 +3,58 @@
 #include "softcpu/device.hpp"
 #include "softcpu/utils.hpp"
 
+#include <algorithm>
+#include <barrier>
+#include <chrono>
+#include <cstring>
+#include <ctime>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <iterator>
+#include <limits>
+#include <thread>
+#include <utility>
 
 namespace softcpu {
 
+namespace {
+// Interrupt controller lines of the default devices
+constexpr std::uint8_t kTimerIrqLine = 0;
+constexpr std::uint8_t kDmaIrqLine = 1;
+
+// Paced runs sleep between slices of roughly one millisecond of guest time
+constexpr std::uint64_t kPacingSlicesPerSecond = 1000;
+
+// Run loop policies: the plain loop compiles without any debug checks
+struct FastPolicy {
+  static constexpr bool kDebug = false;
+};
+struct DebugPolicy {
+  static constexpr bool kDebug = true;
+};
+} // namespace
+
+const char *stopReasonName(StopReason reason) {
+  switch (reason) {
+  case StopReason::Halted:
+    return "halted";
+  case StopReason::CycleLimit:
+    return "cycle limit";
+  case StopReason::Idle:
+    return "idle";
+  case StopReason::Fault:
+    return "fault";
+  case StopReason::StackEscape:
+    return "stack escape";
+  case StopReason::Breakpoint:
+    return "breakpoint";
+  case StopReason::Watchpoint:
+    return "watchpoint";
+  }
+  return "?";
+}
+
 Emulator::Emulator() : memory_(), bus_(memory_) {
   cpu_ = std::make_unique<CPU>(bus_);
   attachDefaultDevices();
@@ -17,7 +62,48 @@ Emulator::Emulator() : memory_(), bus_(memory_) {
 
 void Emulator::reset() {
   memory_ = Memory();
+  mmu_->clearExtended();
+  for (std::size_t i = 0; i < coreCount(); ++i) {
+    resetCore(i);
+  }
+  bus_.resetDevices();
+}
+
+void Emulator::resetCore(std::size_t index) {
+  auto &cpu = core(index);
+  cpu.reset();
+  auto &regs = cpu.registers();
+  regs.gpr[0] = static_cast<std::uint16_t>(index);
+  regs.sp = static_cast<std::uint16_t>(kStackReset - index * kCoreStackSpacing);
+  regs.gpr[kRegisterCount - 1] = regs.sp;
+}
+
+void Emulator::setCoreCount(std::size_t count) {
+  count = std::clamp<std::size_t>(count, 1, kMaxCores);
+  secondary_.resize(count - 1);
+  for (std::size_t i = 1; i < count; ++i) {
+    if (!secondary_[i - 1]) {
+      secondary_[i - 1] = std::make_unique<CPU>(bus_);
+      secondary_[i - 1]->attachDoorbell(&mailbox_->doorbell(i));
+      resetCore(i);
+    }
+  }
+  mailbox_->setCoreCount(count);
+}
+
+void Emulator::saveSnapshot(Snapshot &snapshot) const {
+  snapshot.memory = memory_.bytes();
+  snapshot.extended = mmu_->extended();
+  snapshot.registers = cpu_->registers();
+}
+
+void Emulator::restoreSnapshot(const Snapshot &snapshot) {
+  std::memcpy(memory_.data(), snapshot.memory.data(), kMemorySize);
+  mmu_->restoreExtended(snapshot.extended);
   cpu_->reset();
+  cpu_->registers() = snapshot.registers;
+  bus_.resetDevices();
+  bus_.takeWatchHit();
 }
 
 void Emulator::attachDefaultDevices() {
@@ -25,12 +111,26 @@ void Emulator::attachDefaultDevices() {
     return;
   }
   // Attach standard I/O devices
-  devices_.push_back(std::make_shared<ConsoleDevice>());
-  devices_.push_back(std::make_shared<TimerDevice>());
+  console_ = std::make_shared<ConsoleDevice>();
+  interrupts_ = std::make_shared<InterruptController>();
+  auto timer = std::make_shared<TimerDevice>();
+  auto dma = std::make_shared<DmaController>(bus_, *console_);
+  mmu_ = std::make_shared<MmuDevice>(bus_, memory_);
+  mailbox_ = std::make_shared<Mailbox>();
+  timer->connectInterrupt({interrupts_.get(), kTimerIrqLine});
+  dma->connectInterrupt({interrupts_.get(), kDmaIrqLine});
+  devices_.push_back(console_);
+  devices_.push_back(timer);
   devices_.push_back(std::make_shared<LedPanel>());
+  devices_.push_back(dma);
+  devices_.push_back(interrupts_);
+  devices_.push_back(mmu_);
+  devices_.push_back(mailbox_);
   for (auto &dev : devices_) {
     bus_.attachDevice(dev);
   }
+  cpu_->attachInterruptController(interrupts_.get());
+  cpu_->attachDoorbell(&mailbox_->doorbell(0));
 }
 
 void Emulator::loadImage(const std::vector<std::uint8_t> &image,
@@ -38,6 +138,29 @@ void Emulator::loadImage(const std::vector<std::uint8_t> &image,
   memory_.loadBlock(image, origin);
 }
 
+void Emulator::setPhysicalMemory(std::size_t bytes) {
+  mmu_->setPhysicalSize(bytes);
+}
+
+bool Emulator::loadPhysical(std::uint32_t address,
+                            const std::vector<std::uint8_t> &bytes) {
+  if (static_cast<std::size_t>(address) + bytes.size() >
+      mmu_->physicalSize()) {
+    return false;
+  }
+  // Frames 0-15 and the extended store are separate host blocks
+  std::size_t done = 0;
+  while (done < bytes.size()) {
+    const std::size_t at = address + done;
+    const std::size_t offset = at % kPageSize;
+    const std::size_t chunk = std::min(kPageSize - offset, bytes.size() - done);
+    std::memcpy(mmu_->frame(at / kPageSize) + offset, bytes.data() + done,
+                chunk);
+    done += chunk;
+  }
+  return true;
+}
+
 bool Emulator::loadBinaryFile(const std::string &path, std::uint16_t origin) {
   std::ifstream input(path, std::ios::binary);
   if (!input) {
@@ -73,20 +196,324 @@ bool Emulator::dumpToStdout(std::uint16_t start, std::size_t count) const {
 }
 
 bool Emulator::run(const RunOptions &options) {
-  std::uint64_t cycles = 0;
-  while (options.cycle_limit == 0 || cycles < options.cycle_limit) {
+  if (options.console) {
+    setConsoleSink(options.console);
+  }
+  const auto wall_start = std::chrono::steady_clock::now();
+  const std::clock_t cpu_start = std::clock();
+  const std::uint64_t start = cpu_->cycles();
+  const std::uint64_t start_instructions = cpu_->instructions();
+  const std::uint64_t end = options.cycle_limit == 0
+                                ? std::numeric_limits<std::uint64_t>::max()
+                                : start + options.cycle_limit;
+
+  // Resuming from a breakpoint executes the instruction under it first
+  resume_at_breakpoint_ = stats_.stop_reason == StopReason::Breakpoint &&
+                          stats_.stop_address == cpu_->registers().pc;
+  stats_ = RunStats{};
+  const bool stack_checks =
+      options.stack_floor != 0 || options.stack_ceiling != 0xFFFF;
+  const bool debug =
+      breakpoints_.any() || bus_.hasWatchpoints() || stack_checks;
+  StopReason reason;
+  if (coreCount() > 1) {
+    reason = runMulticore(options, end - start);
+  } else if (options.clock_hz == 0) {
+    reason = debug ? runUntil<DebugPolicy>(options, end)
+                   : runUntil<FastPolicy>(options, end);
+  } else {
+    reason = debug ? runPaced<DebugPolicy>(options, end)
+                   : runPaced<FastPolicy>(options, end);
+  }
+
+  // Console output is buffered; make it visible once the run stops
+  console_->sink()->flush();
+
+  stats_.stop_reason = reason;
+  if (coreCount() == 1) {
+    stats_.cycles = cpu_->cycles() - start;
+    stats_.instructions = cpu_->instructions() - start_instructions;
+  }
+  stats_.wall_seconds = std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() - wall_start)
+                            .count();
+  stats_.cpu_seconds =
+      static_cast<double>(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+  return reason != StopReason::Fault;
+}
+
+template <typename Policy>
+StopReason Emulator::runUntil(const RunOptions &options, std::uint64_t end) {
+  while (cpu_->cycles() < end) {
+    if constexpr (Policy::kDebug) {
+      const auto pc = cpu_->registers().pc;
+      const bool armed = !std::exchange(resume_at_breakpoint_, false);
+      if (armed && breakpoints_.test(pc) && !cpu_->waiting()) {
+        stats_.stop_address = pc;
+        return StopReason::Breakpoint;
+      }
+    }
     if (!cpu_->step(options.trace)) {
-      return true;
+      if (const auto address = cpu_->faultAddress()) {
+        stats_.stop_address = *address;
+        return StopReason::Fault;
+      }
+      return StopReason::Halted;
+    }
+    if constexpr (Policy::kDebug) {
+      const auto sp = cpu_->registers().sp;
+      if (sp < options.stack_floor || sp > options.stack_ceiling) {
+        stats_.stop_address = sp;
+        return StopReason::StackEscape;
+      }
+      if (const auto hit = bus_.takeWatchHit()) {
+        stats_.stop_address = hit->address;
+        stats_.stop_on_write = hit->write;
+        return StopReason::Watchpoint;
+      }
+    }
+    if (cpu_->waiting() && !skipToNextEvent(end)) {
+      return StopReason::Idle; // Nothing left that could wake the CPU
+    }
+  }
+  return StopReason::CycleLimit;
+}
+
+template <typename Policy>
+StopReason Emulator::runPaced(const RunOptions &options, std::uint64_t end) {
+  using Clock = std::chrono::steady_clock;
+  const std::uint64_t slice =
+      std::max<std::uint64_t>(1, options.clock_hz / kPacingSlicesPerSecond);
+  const double seconds_per_cycle = 1.0 / static_cast<double>(options.clock_hz);
+  const auto origin = Clock::now();
+  const std::uint64_t first = cpu_->cycles();
+
+  while (cpu_->cycles() < end) {
+    const auto slice_end =
+        cpu_->cycles() + std::min(slice, end - cpu_->cycles());
+    const auto reason = runUntil<Policy>(options, slice_end);
+    if (reason != StopReason::CycleLimit) {
+      return reason;
+    }
+    // Deadlines are measured from the start of the run rather than the end of
+    // the previous slice, so oversleeping in one slice shortens the next
+    const auto guest_time = std::chrono::duration<double>(
+        static_cast<double>(cpu_->cycles() - first) * seconds_per_cycle);
+    std::this_thread::sleep_until(
+        origin + std::chrono::duration_cast<Clock::duration>(guest_time));
+  }
+  return StopReason::CycleLimit;
+}
+
+StopReason Emulator::runMulticore(const RunOptions &options,
+                                  std::uint64_t budget) {
+  const std::size_t count = coreCount();
+  const std::uint64_t quantum = std::max<std::uint64_t>(1, options.quantum);
+  // Per-core state, written by the core's own thread and read by the
+  // barrier completion (the barrier orders the two)
+  enum class CoreState : std::uint8_t { Running, Halted, Faulted };
+  std::vector<CoreState> states(count, CoreState::Running);
+  std::vector<std::uint64_t> starts(count);
+  std::vector<std::uint64_t> first_instructions(count);
+  std::vector<std::uint64_t> targets(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    starts[i] = core(i).cycles();
+    first_instructions[i] = core(i).instructions();
+    core(i).setDrivesDevices(false);
+  }
+  std::uint64_t elapsed = 0;
+  std::uint64_t slice = std::min(quantum, budget);
+  for (std::size_t i = 0; i < count; ++i) {
+    targets[i] = starts[i] + slice;
+  }
+  bool done = false;
+  StopReason reason = StopReason::CycleLimit;
+  const bool trace = options.trace && options.deterministic;
+
+  // Run one core up to its target for this quantum
+  auto runSlice = [&](std::size_t index) {
+    auto &cpu = core(index);
+    if (states[index] != CoreState::Running) {
+      return;
+    }
+    while (cpu.cycles() < targets[index]) {
+      if (cpu.waiting() && !cpu.wakePending()) {
+        cpu.idle(targets[index] - cpu.cycles());
+        return;
+      }
+      if (!cpu.step(trace)) {
+        states[index] =
+            cpu.faulted() ? CoreState::Faulted : CoreState::Halted;
+        return;
+      }
     }
-    ++cycles;
+  };
+
+  // Between quanta, with every core parked: advance devices, decide whether
+  // to stop, and set the next targets
+  auto synchronize = [&]() noexcept {
+    bus_.advanceDevices(slice);
+    elapsed += slice;
+    bool all_halted = true;
+    bool all_asleep = true;
+    for (std::size_t i = 0; i < count; ++i) {
+      if (states[i] == CoreState::Faulted) {
+        stats_.stop_core = static_cast<std::uint8_t>(i);
+        stats_.stop_address = core(i).faultAddress().value_or(0);
+        reason = StopReason::Fault;
+        done = true;
+        return;
+      }
+      if (states[i] == CoreState::Running) {
+        all_halted = false;
+        all_asleep =
+            all_asleep && core(i).waiting() && !core(i).wakePending();
+      }
+    }
+    if (all_halted) {
+      reason = StopReason::Halted;
+      done = true;
+    } else if (elapsed >= budget) {
+      reason = StopReason::CycleLimit;
+      done = true;
+    } else if (all_asleep && !bus_.cyclesUntilNextEvent()) {
+      reason = StopReason::Idle;
+      done = true;
+    }
+    slice = std::min(quantum, budget - elapsed);
+    for (std::size_t i = 0; i < count; ++i) {
+      targets[i] = starts[i] + elapsed + slice;
+    }
+  };
+
+  if (options.deterministic) {
+    while (!done) {
+      for (std::size_t i = 0; i < count; ++i) {
+        runSlice(i);
+      }
+      synchronize();
+    }
+  } else {
+    bus_.setConcurrent(true);
+    std::barrier sync(static_cast<std::ptrdiff_t>(count), synchronize);
+    auto serve = [&](std::size_t index) {
+      while (!done) {
+        runSlice(index);
+        sync.arrive_and_wait();
+      }
+    };
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < count; ++i) {
+      threads.emplace_back(serve, i);
+    }
+    serve(0);
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    bus_.setConcurrent(false);
+  }
+
+  for (std::size_t i = 0; i < count; ++i) {
+    core(i).setDrivesDevices(true);
+    stats_.instructions += core(i).instructions() - first_instructions[i];
   }
+  stats_.cycles = elapsed;
+  return reason;
+}
+
+bool Emulator::skipToNextEvent(std::uint64_t end) {
+  const auto next = bus_.cyclesUntilNextEvent();
+  if (!next) {
+    return false;
+  }
+  // Stop one cycle short: the next step's device tick fires the event
+  const auto left = end > cpu_->cycles() ? end - cpu_->cycles() : 0;
+  cpu_->idle(std::min(*next - 1, left));
   return true;
 }
 
+void Emulator::setBreakpoint(std::uint16_t address, bool enabled) {
+  breakpoints_.set(address, enabled);
+}
+
+void Emulator::clearBreakpoints() { breakpoints_.reset(); }
+
+void Emulator::addWatchpoint(std::uint16_t address, std::size_t length,
+                             WatchKind kind) {
+  bus_.addWatchpoint(address, length, kind);
+}
+
+void Emulator::clearWatchpoints() { bus_.clearWatchpoints(); }
+
+void Emulator::enableHeatmap(bool enabled) {
+  heatmap_ = enabled ? std::make_unique<MemoryHeatmap>() : nullptr;
+  bus_.setHeatmap(heatmap_.get());
+}
+
+bool Emulator::enableCache(const CacheConfig &instruction,
+                           const CacheConfig &data) {
+  if ((instruction.size_bytes > 0 && !instruction.valid()) ||
+      (data.size_bytes > 0 && !data.valid())) {
+    return false;
+  }
+  cache_ = std::make_unique<CacheModel>(instruction, data);
+  bus_.setCache(cache_.get());
+  cpu_->attachCache(cache_.get());
+  return true;
+}
+
+void Emulator::disableCache() {
+  bus_.setCache(nullptr);
+  cpu_->attachCache(nullptr);
+  cache_.reset();
+}
+
+bool Emulator::enablePipeline(const PipelineConfig &config) {
+  if (!PipelineModel::valid(config)) {
+    return false;
+  }
+  pipeline_ = std::make_unique<PipelineModel>(config);
+  cpu_->attachPipeline(pipeline_.get());
+  return true;
+}
+
+void Emulator::disablePipeline() {
+  cpu_->attachPipeline(nullptr);
+  pipeline_.reset();
+}
+
+void Emulator::setCoverage(EdgeCoverage *coverage) {
+  cpu_->attachCoverage(coverage);
+}
+
+void Emulator::enableProfiler(bool enabled) {
+  profiler_ = enabled ? std::make_unique<CallProfiler>() : nullptr;
+  if (profiler_) {
+    profiler_->reset(cpu_->registers().pc, cpu_->registers().sp);
+  }
+  cpu_->attachProfiler(profiler_.get());
+}
+
+void Emulator::setConsoleSink(std::shared_ptr<ConsoleSink> sink) {
+  console_->setSink(std::move(sink));
+}
+
+const std::shared_ptr<ConsoleSink> &Emulator::consoleSink() const {
+  return console_->sink();
+}
+
 RegisterFile &Emulator::registers() { return cpu_->registers(); }
 
+RegisterFile &Emulator::registers(std::size_t core_index) {
+  return core(core_index).registers();
+}
+
 const RegisterFile &Emulator::registers() const { return cpu_->registers(); }
 
+std::uint8_t Emulator::fetch8(std::uint16_t address) const {
+  return bus_.fetch8(address);
+}
+
 Memory &Emulator::memory() { return memory_; }
 
 const Memory &Emulator::memory() const { return memory_; }
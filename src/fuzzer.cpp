@@ -0,0 +1,444 @@
+#include "softcpu/fuzzer.hpp"
+
+#include "softcpu/coverage.hpp"
+#include "softcpu/emulator.hpp"
+#include "softcpu/utils.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <thread>
+
+namespace softcpu {
+
+namespace {
+// Crash kinds, also used in reproducer file names
+constexpr std::uint8_t kCrashFault = 1;
+constexpr std::uint8_t kCrashStack = 2;
+
+// Executions a worker batches before publishing its exec count
+constexpr std::uint64_t kExecBatch = 64;
+
+// Size of the default seed when none is given
+constexpr std::size_t kDefaultSeedLength = 16;
+
+// AFL hit-count buckets: 1, 2, 3, 4-7, 8-15, 16-31, 32-127, 128+
+const std::array<std::uint8_t, 256> kCountClass = [] {
+  std::array<std::uint8_t, 256> table{};
+  for (std::size_t count = 1; count < table.size(); ++count) {
+    std::uint8_t bucket = 128;
+    if (count <= 3) {
+      bucket = static_cast<std::uint8_t>(1u << (count - 1));
+    } else if (count <= 7) {
+      bucket = 8;
+    } else if (count <= 15) {
+      bucket = 16;
+    } else if (count <= 31) {
+      bucket = 32;
+    } else if (count <= 127) {
+      bucket = 64;
+    }
+    table[count] = bucket;
+  }
+  return table;
+}();
+
+// Boundary values that tend to trip length and sign checks
+constexpr std::array<std::uint16_t, 10> kInteresting{
+    0x0000, 0x0001, 0x007F, 0x0080, 0x00FF,
+    0x0100, 0x7FFF, 0x8000, 0xFFFE, 0xFFFF};
+
+// xorshift64* generator; one per worker
+class Random {
+public:
+  explicit Random(std::uint64_t seed) : state_(seed ? seed : 1) {}
+
+  std::uint64_t next() {
+    state_ ^= state_ >> 12;
+    state_ ^= state_ << 25;
+    state_ ^= state_ >> 27;
+    return state_ * 0x2545F4914F6CDD1DULL;
+  }
+
+  // Uniform value in [0, bound)
+  std::size_t below(std::size_t bound) {
+    return bound == 0 ? 0 : static_cast<std::size_t>(next() % bound);
+  }
+
+private:
+  std::uint64_t state_;
+};
+} // namespace
+
+// One fuzzing thread with its own emulator, coverage map, and corpus view
+class Fuzzer::Worker {
+public:
+  Worker(Fuzzer &fuzzer, unsigned index)
+      : fuzzer_(fuzzer), options_(fuzzer.options_),
+        random_(options_.seed * 0x9E3779B97F4A7C15ULL + index),
+        map_(kAflMapSize), known_(kAflMapSize),
+        coverage_(map_.data(), map_.size()) {
+    emulator_.setConsoleSink(std::make_shared<NullSink>());
+    emulator_.reset();
+    emulator_.loadImage(options_.image, options_.origin);
+    emulator_.registers().pc = options_.entry;
+    emulator_.saveSnapshot(snapshot_);
+    emulator_.setCoverage(&coverage_);
+    run_options_.cycle_limit = options_.cycle_budget;
+    run_options_.stack_floor = options_.stack_floor;
+    run_options_.stack_ceiling = options_.stack_ceiling;
+  }
+
+  // Execute the initial corpus unmutated so its coverage is known
+  void calibrate() {
+    refreshCorpus();
+    for (const auto &input : corpus_) {
+      execute(input);
+      if (hasNewCoverage()) {
+        fuzzer_.mergeCoverage(map_.data());
+      }
+    }
+  }
+
+  void run() {
+    std::uint64_t pending = 0;
+    std::vector<std::uint8_t> input;
+    while (!fuzzer_.stop_.load(std::memory_order_relaxed)) {
+      refreshCorpus();
+      mutate(corpus_[random_.below(corpus_.size())], input);
+      const auto crash = execute(input);
+
+      if (hasNewCoverage() && fuzzer_.mergeCoverage(map_.data())) {
+        fuzzer_.addToCorpus(input);
+      }
+      if (crash.found && fuzzer_.claimCrash(crash)) {
+        fuzzer_.saveCrash(crash, minimize(input, crash));
+      }
+
+      if (++pending == kExecBatch) {
+        const auto total = fuzzer_.execs_.fetch_add(pending) + pending;
+        pending = 0;
+        if (options_.max_execs != 0 && total >= options_.max_execs) {
+          fuzzer_.stop_ = true;
+        }
+      }
+    }
+    fuzzer_.execs_ += pending;
+  }
+
+private:
+  // Pick up inputs other workers added since the last look
+  void refreshCorpus() {
+    const auto generation =
+        fuzzer_.corpus_generation_.load(std::memory_order_acquire);
+    if (generation == generation_ && !corpus_.empty()) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(fuzzer_.mutex_);
+    corpus_ = fuzzer_.corpus_;
+    generation_ = fuzzer_.corpus_generation_.load();
+  }
+
+  // Restore the snapshot, load `input`, and run it. Leaves the bucketed
+  // coverage of the run in map_.
+  Crash execute(const std::vector<std::uint8_t> &input) {
+    std::fill(map_.begin(), map_.end(), 0);
+    emulator_.restoreSnapshot(snapshot_);
+    auto *region = emulator_.memory().data() + options_.input_address;
+    const auto length = std::min(input.size(), options_.input_length);
+    std::memcpy(region, input.data(), length);
+    std::memset(region + length, 0, options_.input_length - length);
+
+    emulator_.run(run_options_);
+    classifyCounts();
+    const auto &stats = emulator_.lastRunStats();
+    switch (stats.stop_reason) {
+    case StopReason::Fault:
+      return Crash{true, kCrashFault, stats.stop_address};
+    case StopReason::StackEscape:
+      return Crash{true, kCrashStack, emulator_.registers().pc};
+    default:
+      return Crash{};
+    }
+  }
+
+  // Replace raw hit counts with their bucket. The map is mostly zero, so it
+  // is scanned a word at a time and empty words are skipped.
+  void classifyCounts() {
+    for (std::size_t i = 0; i < map_.size(); i += sizeof(std::uint64_t)) {
+      std::uint64_t word;
+      std::memcpy(&word, map_.data() + i, sizeof(word));
+      if (word == 0) {
+        continue;
+      }
+      for (std::size_t j = i; j < i + sizeof(word); ++j) {
+        map_[j] = kCountClass[map_[j]];
+      }
+    }
+  }
+
+  // Cheap pre-check against this worker's view of global coverage so the
+  // shared lock is only taken when something might be new
+  bool hasNewCoverage() {
+    bool fresh = false;
+    for (std::size_t i = 0; i < map_.size(); i += sizeof(std::uint64_t)) {
+      std::uint64_t hits;
+      std::uint64_t known;
+      std::memcpy(&hits, map_.data() + i, sizeof(hits));
+      std::memcpy(&known, known_.data() + i, sizeof(known));
+      if ((hits & ~known) != 0) {
+        known |= hits;
+        std::memcpy(known_.data() + i, &known, sizeof(known));
+        fresh = true;
+      }
+    }
+    return fresh;
+  }
+
+  // Stacked havoc mutations within [1, input_length] bytes
+  void mutate(const std::vector<std::uint8_t> &parent,
+              std::vector<std::uint8_t> &child) {
+    child = parent;
+    if (child.empty()) {
+      child.push_back(0);
+    }
+    const std::size_t limit = options_.input_length;
+    const auto rounds = 1u << (1 + random_.below(4));
+    for (unsigned round = 0; round < rounds; ++round) {
+      const auto at = random_.below(child.size());
+      switch (random_.below(8)) {
+      case 0: // Flip a bit
+        child[at] ^= static_cast<std::uint8_t>(1u << random_.below(8));
+        break;
+      case 1: // Random byte
+        child[at] = static_cast<std::uint8_t>(random_.next());
+        break;
+      case 2: { // Interesting value, byte or little-endian word
+        const auto value = kInteresting[random_.below(kInteresting.size())];
+        child[at] = static_cast<std::uint8_t>(value & 0xFF);
+        if (at + 1 < child.size() && (random_.next() & 1) != 0) {
+          child[at + 1] = static_cast<std::uint8_t>(value >> 8);
+        }
+        break;
+      }
+      case 3: // Small add or subtract
+        child[at] = static_cast<std::uint8_t>(
+            child[at] + static_cast<std::uint8_t>(random_.below(35)) - 17);
+        break;
+      case 4: { // Overwrite with a copy of another chunk
+        const auto from = random_.below(child.size());
+        const auto room =
+            std::min(child.size() - std::max(at, from), std::size_t{16});
+        const auto length = 1 + random_.below(room);
+        std::memmove(child.data() + at, child.data() + from, length);
+        break;
+      }
+      case 5: // Delete a chunk
+        if (child.size() > 1) {
+          const auto length =
+              1 + random_.below(std::min(child.size() - at, std::size_t{16}));
+          child.erase(child.begin() + static_cast<std::ptrdiff_t>(at),
+                      child.begin() + static_cast<std::ptrdiff_t>(
+                                          std::min(at + length, child.size())));
+          if (child.empty()) {
+            child.push_back(0);
+          }
+        }
+        break;
+      case 6: // Insert random bytes
+        if (child.size() < limit) {
+          const auto room = std::min(limit - child.size(), std::size_t{16});
+          const auto length = 1 + random_.below(room);
+          child.insert(child.begin() + static_cast<std::ptrdiff_t>(at), length,
+                       static_cast<std::uint8_t>(random_.next()));
+        }
+        break;
+      default: { // Splice the tail of another corpus entry
+        const auto &other = corpus_[random_.below(corpus_.size())];
+        if (other.size() > at) {
+          child.resize(at);
+          child.insert(child.end(),
+                       other.begin() + static_cast<std::ptrdiff_t>(at),
+                       other.end());
+        }
+        break;
+      }
+      }
+    }
+    if (child.size() > limit) {
+      child.resize(limit);
+    }
+  }
+
+  bool reproduces(const std::vector<std::uint8_t> &input, const Crash &crash) {
+    const auto result = execute(input);
+    return result.found && result.kind == crash.kind &&
+           result.address == crash.address;
+  }
+
+  // Shrink the input from the end, then zero bytes, keeping the signature
+  std::vector<std::uint8_t> minimize(std::vector<std::uint8_t> input,
+                                     const Crash &crash) {
+    for (auto step = input.size() / 2; step > 0; step /= 2) {
+      while (input.size() > step) {
+        auto shorter = input;
+        shorter.resize(input.size() - step);
+        if (!reproduces(shorter, crash)) {
+          break;
+        }
+        input = std::move(shorter);
+      }
+    }
+    for (auto &byte : input) {
+      if (byte == 0) {
+        continue;
+      }
+      const auto saved = byte;
+      byte = 0;
+      if (!reproduces(input, crash)) {
+        byte = saved;
+      }
+    }
+    return input;
+  }
+
+  Fuzzer &fuzzer_;
+  const FuzzOptions &options_;
+  Random random_;
+  Emulator emulator_;
+  Snapshot snapshot_;
+  RunOptions run_options_;
+  std::vector<std::uint8_t> map_;
+  std::vector<std::uint8_t> known_;
+  EdgeCoverage coverage_;
+  std::vector<std::vector<std::uint8_t>> corpus_;
+  std::uint64_t generation_{0};
+};
+
+Fuzzer::Fuzzer(FuzzOptions options)
+    : options_(std::move(options)), virgin_(kAflMapSize) {
+  options_.jobs = std::max(1u, options_.jobs);
+  options_.input_length =
+      std::min(options_.input_length, kMemorySize - options_.input_address);
+  corpus_ = options_.seeds;
+  if (corpus_.empty()) {
+    corpus_.emplace_back(std::min(kDefaultSeedLength, options_.input_length));
+  }
+  for (auto &seed : corpus_) {
+    if (seed.size() > options_.input_length) {
+      seed.resize(options_.input_length);
+    }
+  }
+  if (!options_.output_dir.empty()) {
+    std::error_code error;
+    std::filesystem::create_directories(options_.output_dir + "/queue", error);
+    std::filesystem::create_directories(options_.output_dir + "/crashes",
+                                        error);
+  }
+}
+
+FuzzStats Fuzzer::run(const std::function<void(const FuzzStats &)> &progress) {
+  using Clock = std::chrono::steady_clock;
+  const auto start = Clock::now();
+  std::vector<std::unique_ptr<Worker>> workers;
+  for (unsigned i = 0; i < options_.jobs; ++i) {
+    workers.push_back(std::make_unique<Worker>(*this, i));
+  }
+  workers.front()->calibrate();
+
+  std::vector<std::thread> threads;
+  for (auto &worker : workers) {
+    threads.emplace_back([&worker] { worker->run(); });
+  }
+
+  auto next_report = start + std::chrono::seconds(1);
+  while (!stop_) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const auto now = Clock::now();
+    const double elapsed = std::chrono::duration<double>(now - start).count();
+    if (options_.max_seconds > 0.0 && elapsed >= options_.max_seconds) {
+      stop_ = true;
+    }
+    if (progress && now >= next_report) {
+      auto stats = snapshotStats();
+      stats.seconds = elapsed;
+      progress(stats);
+      next_report += std::chrono::seconds(1);
+    }
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  auto stats = snapshotStats();
+  stats.seconds =
+      std::chrono::duration<double>(Clock::now() - start).count();
+  return stats;
+}
+
+bool Fuzzer::mergeCoverage(const std::uint8_t *map) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  bool fresh = false;
+  for (std::size_t i = 0; i < virgin_.size(); ++i) {
+    const auto added = static_cast<std::uint8_t>(map[i] & ~virgin_[i]);
+    if (added != 0) {
+      edges_ += virgin_[i] == 0 ? 1 : 0;
+      virgin_[i] |= added;
+      fresh = true;
+    }
+  }
+  return fresh;
+}
+
+void Fuzzer::addToCorpus(const std::vector<std::uint8_t> &input) {
+  std::size_t id;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    id = corpus_.size();
+    corpus_.push_back(input);
+  }
+  corpus_generation_.fetch_add(1, std::memory_order_release);
+  if (!options_.output_dir.empty()) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "/queue/id-%06zu.bin", id);
+    util::writeBinaryFile(options_.output_dir + name, input);
+  }
+}
+
+bool Fuzzer::claimCrash(const Crash &crash) {
+  const auto signature =
+      static_cast<std::uint32_t>(crash.kind) << 16 | crash.address;
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (std::find(crash_signatures_.begin(), crash_signatures_.end(),
+                signature) != crash_signatures_.end()) {
+    return false;
+  }
+  crash_signatures_.push_back(signature);
+  return true;
+}
+
+void Fuzzer::saveCrash(const Crash &crash,
+                       const std::vector<std::uint8_t> &input) {
+  if (options_.output_dir.empty()) {
+    return;
+  }
+  char name[40];
+  std::snprintf(name, sizeof(name), "/crashes/%s-%04X.bin",
+                crash.kind == kCrashFault ? "fault" : "stack", crash.address);
+  util::writeBinaryFile(options_.output_dir + name, input);
+}
+
+FuzzStats Fuzzer::snapshotStats() const {
+  FuzzStats stats;
+  stats.execs = execs_.load();
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats.crashes = crash_signatures_.size();
+  stats.corpus_size = corpus_.size();
+  stats.edges = edges_;
+  return stats;
+}
+
+} // namespace softcpu
@@ -0,0 +1,111 @@
+#include "softcpu/heatmap.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+namespace softcpu {
+
+namespace {
+// Scale a count to 0..255 on a log scale relative to the largest count
+std::uint8_t intensity(std::uint64_t count, double log_max) {
+  if (count == 0 || log_max <= 0.0) {
+    return 0;
+  }
+  const double scaled = std::log1p(static_cast<double>(count)) / log_max;
+  return static_cast<std::uint8_t>(std::lround(32.0 + 223.0 * scaled));
+}
+} // namespace
+
+MemoryHeatmap::MemoryHeatmap() : words_(kWords) {}
+
+void MemoryHeatmap::recordRange(std::uint16_t address, std::size_t length,
+                                AccessKind kind) {
+  if (length == 0) {
+    return;
+  }
+  const auto k = static_cast<std::size_t>(kind);
+  const std::size_t first = address >> 1;
+  const std::size_t last =
+      std::min(kMemorySize - 1, address + length - 1) >> 1;
+  for (std::size_t word = first; word <= last; ++word) {
+    ++words_[word][k];
+    ++pages_[word >> 7].ram[k];
+  }
+}
+
+void MemoryHeatmap::clear() {
+  pages_.fill(PageCounts{});
+  std::fill(words_.begin(), words_.end(),
+            std::array<std::uint64_t, kAccessKinds>{});
+}
+
+bool MemoryHeatmap::writePageCsv(const std::string &path) const {
+  std::ofstream out(path);
+  if (!out) {
+    return false;
+  }
+  out << "page,base,ram_fetch,ram_read,ram_write,"
+         "device_fetch,device_read,device_write\n";
+  char base[8];
+  for (std::size_t i = 0; i < kPages; ++i) {
+    const auto &p = pages_[i];
+    std::snprintf(base, sizeof(base), "0x%04zX", i << 8);
+    out << i << ',' << base;
+    for (const auto count : p.ram) {
+      out << ',' << count;
+    }
+    for (const auto count : p.device) {
+      out << ',' << count;
+    }
+    out << '\n';
+  }
+  return static_cast<bool>(out);
+}
+
+bool MemoryHeatmap::writeWordCsv(const std::string &path) const {
+  std::ofstream out(path);
+  if (!out) {
+    return false;
+  }
+  out << "address,fetch,read,write\n";
+  char address[8];
+  for (std::size_t i = 0; i < kWords; ++i) {
+    const auto &w = words_[i];
+    if (w[0] == 0 && w[1] == 0 && w[2] == 0) {
+      continue;
+    }
+    std::snprintf(address, sizeof(address), "0x%04zX", i << 1);
+    out << address << ',' << w[0] << ',' << w[1] << ',' << w[2] << '\n';
+  }
+  return static_cast<bool>(out);
+}
+
+bool MemoryHeatmap::writePpm(const std::string &path) const {
+  constexpr std::size_t kWidth = 128; // Words per page
+  constexpr std::size_t kHeight = kPages;
+  std::ofstream out(path, std::ios::binary);
+  if (!out) {
+    return false;
+  }
+  std::uint64_t max = 0;
+  for (const auto &w : words_) {
+    max = std::max({max, w[0], w[1], w[2]});
+  }
+  const double log_max = std::log1p(static_cast<double>(max));
+
+  out << "P6\n" << kWidth << ' ' << kHeight << "\n255\n";
+  std::vector<std::uint8_t> pixels(kWidth * kHeight * 3);
+  for (std::size_t i = 0; i < kWords; ++i) {
+    const auto &w = words_[i];
+    pixels[i * 3 + 0] = intensity(w[2], log_max); // Writes
+    pixels[i * 3 + 1] = intensity(w[1], log_max); // Reads
+    pixels[i * 3 + 2] = intensity(w[0], log_max); // Fetches
+  }
+  out.write(reinterpret_cast<const char *>(pixels.data()),
+            static_cast<std::streamsize>(pixels.size()));
+  return static_cast<bool>(out);
+}
+
+} // namespace softcpu
@@ -1,11 +1,20 @@
 #include "softcpu/assembler.hpp"
+#include "softcpu/disassembler.hpp"
 #include "softcpu/emulator.hpp"
+#include "softcpu/fuzzer.hpp"
+#include "softcpu/server.hpp"
 #include "softcpu/utils.hpp"
 
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
 #include <cstdlib>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <optional>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace {
@@ -15,9 +24,32 @@ void printUsage() {
   std::cout
       << "SoftCPU-16 Software CPU\n"
       << "Usage:\n"
-      << "  softcpu assemble <source.asm> -o <program.bin> [--origin 0x0000]\n"
+      << "  softcpu assemble <source.asm> -o <program.bin> [--origin 0x0000] "
+         "[--map <program.map>]\n"
+      << "                [--banks <program.banks>]\n"
       << "  softcpu run <program.bin> [--origin 0x0000] [--entry 0x0000] "
          "[--cycles N] [--trace]\n"
+      << "                [--console stdout|null|capture[:BYTES]|file:PATH] "
+         "[--clock-hz HZ]\n"
+      << "                [--break ADDR]... [--watch ADDR[:LEN]]... "
+         "[--watch-read ADDR[:LEN]]...\n"
+      << "                [--watch-write ADDR[:LEN]]... [--heatmap PREFIX]\n"
+      << "                [--profile] [--symbols <program.map>] "
+         "[--coverage <edges.bin>]\n"
+      << "                [--banks <program.banks>] [--phys-mem BYTES]\n"
+      << "                [--cores N] [--quantum CYCLES] [--deterministic]\n"
+      << "                [--icache SIZE[:WAYS[:LINE[:PENALTY]]]] "
+         "[--dcache SIZE[:WAYS[:LINE[:PENALTY]]]]\n"
+      << "                [--pipeline static|2bit|gshare] [--no-forwarding]\n"
+      << "  softcpu fuzz <program.bin> --input-region ADDR:LEN [--jobs N] "
+         "[--origin 0x0000]\n"
+      << "                [--entry 0x0000] [--cycles N] [--execs N] "
+         "[--seconds S] [--seed N]\n"
+      << "                [--out DIR] [--corpus DIR] [--stack-floor ADDR]\n"
+      << "  softcpu serve --socket <path> [--workers N]\n"
+      << "  softcpu disasm <program.bin> [--origin 0x0000] [--entry 0x0000] "
+         "[--symbols <program.map>]\n"
+      << "                [--dot <cfg.dot>] [--no-labels]\n"
       << "  softcpu dump <program.bin> --start 0x0000 --length 64 [--origin "
          "0x0000]\n";
 }
@@ -30,6 +62,119 @@ std::optional<std::uint16_t> parseWord(const std::string &text) {
   return std::nullopt;
 }
 
+// Parse a console back end spec: stdout, null, capture[:BYTES] or file:PATH
+std::optional<softcpu::ConsoleOptions>
+parseConsoleSpec(const std::string &text) {
+  softcpu::ConsoleOptions options;
+  if (text == "stdout") {
+    options.mode = softcpu::ConsoleMode::Stdout;
+  } else if (text == "null") {
+    options.mode = softcpu::ConsoleMode::Null;
+  } else if (text.rfind("capture", 0) == 0) {
+    options.mode = softcpu::ConsoleMode::Capture;
+    if (text.size() > 7) {
+      if (text[7] != ':') {
+        return std::nullopt;
+      }
+      auto value = softcpu::util::parseNumber(text.substr(8));
+      if (!value || *value <= 0) {
+        return std::nullopt;
+      }
+      options.capacity = static_cast<std::size_t>(*value);
+    }
+  } else if (text.rfind("file:", 0) == 0 && text.size() > 5) {
+    options.mode = softcpu::ConsoleMode::File;
+    options.path = text.substr(5);
+  } else {
+    return std::nullopt;
+  }
+  return options;
+}
+
+// A watchpoint requested on the command line
+struct WatchSpec {
+  std::uint16_t address{0};
+  std::size_t length{1};
+  softcpu::WatchKind kind{softcpu::WatchKind::Access};
+};
+
+// Parse ADDR or ADDR:LEN
+std::optional<WatchSpec> parseWatchSpec(const std::string &text,
+                                        softcpu::WatchKind kind) {
+  WatchSpec spec;
+  spec.kind = kind;
+  const auto colon = text.find(':');
+  auto address = parseWord(text.substr(0, colon));
+  if (!address) {
+    return std::nullopt;
+  }
+  spec.address = *address;
+  if (colon != std::string::npos) {
+    auto length = softcpu::util::parseNumber(text.substr(colon + 1));
+    if (!length || *length <= 0) {
+      return std::nullopt;
+    }
+    spec.length = static_cast<std::size_t>(*length);
+  }
+  return spec;
+}
+
+// Parse "SIZE[:WAYS[:LINE[:PENALTY]]]" for --icache / --dcache
+std::optional<softcpu::CacheConfig> parseCacheSpec(const std::string &text) {
+  softcpu::CacheConfig config;
+  std::size_t *fields[] = {&config.size_bytes, &config.ways,
+                           &config.line_bytes};
+  std::size_t start = 0;
+  for (std::size_t field = 0; start <= text.size(); ++field) {
+    const auto colon = text.find(':', start);
+    const auto value = softcpu::util::parseNumber(
+        text.substr(start, colon == std::string::npos ? colon : colon - start));
+    if (!value || *value <= 0 || field > 3) {
+      return std::nullopt;
+    }
+    if (field < 3) {
+      *fields[field] = static_cast<std::size_t>(*value);
+    } else {
+      config.miss_penalty = static_cast<std::uint32_t>(*value);
+    }
+    if (colon == std::string::npos) {
+      break;
+    }
+    start = colon + 1;
+  }
+  if (!config.valid()) {
+    return std::nullopt;
+  }
+  return config;
+}
+
+// Report a breakpoint or watchpoint stop with the register state
+void printStop(const softcpu::Emulator &emulator) {
+  const auto &stats = emulator.lastRunStats();
+  const auto &regs = emulator.registers();
+  if (stats.stop_reason == softcpu::StopReason::Breakpoint) {
+    std::fprintf(stderr, "breakpoint at 0x%04X\n", stats.stop_address);
+  } else {
+    std::fprintf(stderr, "watchpoint: %s 0x%04X\n",
+                 stats.stop_on_write ? "write" : "read", stats.stop_address);
+  }
+  std::fprintf(stderr, "PC=0x%04X SP=0x%04X FLAGS=0x%02X\n", regs.pc, regs.sp,
+               static_cast<unsigned>(regs.flags.value));
+  for (std::size_t i = 0; i < regs.gpr.size(); ++i) {
+    std::fprintf(stderr, "R%zu=0x%04X%c", i, regs.gpr[i],
+                 i + 1 == regs.gpr.size() ? '\n' : ' ');
+  }
+}
+
+// Server stopped by SIGINT/SIGTERM
+softcpu::JobServer *active_server = nullptr;
+
+void stopServer(int) {
+  if (active_server != nullptr) {
+    active_server->stop();
+  }
+}
+
 } // namespace
 
 int main(int argc, char **argv) {
@@ -45,6 +190,8 @@ int main(int argc, char **argv) {
   if (command == "assemble") {
     std::string input;
     std::string output = "a.bin";
+    std::string map_path;
+    std::string banks_path;
     std::uint16_t origin = softcpu::kResetVector;
 
     // Parse arguments for assemble command
@@ -56,6 +203,18 @@ int main(int argc, char **argv) {
           return 1;
         }
         output = argv[++i];
+      } else if (arg == "--map") {
+        if (i + 1 >= argc) {
+          std::cerr << "missing map path\n";
+          return 1;
+        }
+        map_path = argv[++i];
+      } else if (arg == "--banks") {
+        if (i + 1 >= argc) {
+          std::cerr << "missing bank file path\n";
+          return 1;
+        }
+        banks_path = argv[++i];
       } else if (arg == "--origin") {
         if (i + 1 >= argc) {
           std::cerr << "missing origin value\n";
@@ -105,6 +264,22 @@ int main(int argc, char **argv) {
     }
     std::cout << "Wrote " << result.bytes.size() << " bytes to " << output
               << '\n';
+    if (!result.banks.empty()) {
+      if (banks_path.empty()) {
+        banks_path = output + ".banks";
+      }
+      if (!softcpu::util::writeBankFile(banks_path, result.banks)) {
+        std::cerr << "failed to write " << banks_path << '\n';
+        return 1;
+      }
+      std::cout << "Wrote " << result.banks.size() << " banked sections to "
+                << banks_path << '\n';
+    }
+    if (!map_path.empty() &&
+        !softcpu::util::writeSymbolMap(map_path, result.labels)) {
+      std::cerr << "failed to write " << map_path << '\n';
+      return 1;
+    }
     return 0;
   }
 
@@ -115,6 +290,23 @@ int main(int argc, char **argv) {
     std::uint16_t entry = softcpu::kResetVector;
     std::uint64_t cycles = 0;
     bool trace = false;
+    softcpu::ConsoleOptions console;
+    std::uint64_t clock_hz = 0;
+    std::vector<std::uint16_t> breakpoints;
+    std::vector<WatchSpec> watchpoints;
+    std::string heatmap_prefix;
+    bool profile = false;
+    std::size_t cores = 1;
+    std::uint64_t quantum = softcpu::RunOptions{}.quantum;
+    bool deterministic = false;
+    std::string coverage_path;
+    softcpu::util::SymbolMap symbols;
+    softcpu::CacheConfig icache;
+    softcpu::CacheConfig dcache;
+    std::optional<softcpu::PipelineConfig> pipeline;
+    bool forwarding = true;
+    std::vector<softcpu::util::PhysicalBlock> banks;
+    std::size_t physical_memory = 0;
 
     // Parse arguments for run command
     for (int i = 2; i < argc; ++i) {
@@ -152,6 +344,152 @@ int main(int argc, char **argv) {
         cycles = std::strtoull(argv[++i], nullptr, 0);
       } else if (arg == "--trace") {
         trace = true;
+      } else if (arg == "--clock-hz") {
+        if (i + 1 >= argc) {
+          std::cerr << "missing clock frequency\n";
+          return 1;
+        }
+        clock_hz = std::strtoull(argv[++i], nullptr, 0);
+        if (clock_hz == 0) {
+          std::cerr << "invalid clock frequency\n";
+          return 1;
+        }
+      } else if (arg == "--console") {
+        if (i + 1 >= argc) {
+          std::cerr << "missing console mode\n";
+          return 1;
+        }
+        auto value = parseConsoleSpec(argv[++i]);
+        if (!value) {
+          std::cerr << "invalid console mode\n";
+          return 1;
+        }
+        console = *value;
+      } else if (arg == "--heatmap") {
+        if (i + 1 >= argc) {
+          std::cerr << "missing heatmap prefix\n";
+          return 1;
+        }
+        heatmap_prefix = argv[++i];
+      } else if (arg == "--coverage") {
+        if (i + 1 >= argc) {
+          std::cerr << "missing coverage path\n";
+          return 1;
+        }
+        coverage_path = argv[++i];
+      } else if (arg == "--cores") {
+        if (i + 1 >= argc) {
+          std::cerr << "missing core count\n";
+          return 1;
+        }
+        cores = std::strtoull(argv[++i], nullptr, 0);
+        if (cores == 0 || cores > softcpu::kMaxCores) {
+          std::cerr << "core count must be 1-" << softcpu::kMaxCores << '\n';
+          return 1;
+        }
+      } else if (arg == "--quantum") {
+        if (i + 1 >= argc) {
+          std::cerr << "missing quantum\n";
+          return 1;
+        }
+        quantum = std::strtoull(argv[++i], nullptr, 0);
+        if (quantum == 0) {
+          std::cerr << "invalid quantum\n";
+          return 1;
+        }
+      } else if (arg == "--deterministic") {
+        deterministic = true;
+      } else if (arg == "--icache" || arg == "--dcache") {
+        if (i + 1 >= argc) {
+          std::cerr << "missing cache geometry\n";
+          return 1;
+        }
+        auto value = parseCacheSpec(argv[++i]);
+        if (!value) {
+          std::cerr << "invalid cache geometry (sizes must be powers of "
+                       "two)\n";
+          return 1;
+        }
+        (arg == "--icache" ? icache : dcache) = *value;
+      } else if (arg == "--pipeline") {
+        if (i + 1 >= argc) {
+          std::cerr << "missing branch predictor\n";
+          return 1;
+        }
+        const std::string name = argv[++i];
+        pipeline.emplace();
+        if (name == "static") {
+          pipeline->predictor = softcpu::PredictorKind::Static;
+        } else if (name == "2bit") {
+          pipeline->predictor = softcpu::PredictorKind::TwoBit;
+        } else if (name == "gshare") {
+          pipeline->predictor = softcpu::PredictorKind::Gshare;
+        } else {
+          std::cerr << "unknown branch predictor: " << name << '\n';
+          return 1;
+        }
+      } else if (arg == "--no-forwarding") {
+        forwarding = false;
+      } else if (arg == "--profile") {
+        profile = true;
+      } else if (arg == "--symbols") {
+        if (i + 1 >= argc) {
+          std::cerr << "missing symbol map path\n";
+          return 1;
+        }
+        auto value = softcpu::util::readSymbolMap(argv[++i]);
+        if (!value) {
+          std::cerr << "unable to read symbol map\n";
+          return 1;
+        }
+        symbols = std::move(*value);
+      } else if (arg == "--banks") {
+        if (i + 1 >= argc) {
+          std::cerr << "missing bank file path\n";
+          return 1;
+        }
+        auto value = softcpu::util::readBankFile(argv[++i]);
+        if (!value) {
+          std::cerr << "unable to read bank file\n";
+          return 1;
+        }
+        banks = std::move(*value);
+      } else if (arg == "--phys-mem") {
+        if (i + 1 >= argc) {
+          std::cerr << "missing physical memory size\n";
+          return 1;
+        }
+        physical_memory = std::strtoull(argv[++i], nullptr, 0);
+        if (physical_memory == 0) {
+          std::cerr << "invalid physical memory size\n";
+          return 1;
+        }
+      } else if (arg == "--break") {
+        if (i + 1 >= argc) {
+          std::cerr << "missing breakpoint address\n";
+          return 1;
+        }
+        auto value = parseWord(argv[++i]);
+        if (!value) {
+          std::cerr << "invalid breakpoint address\n";
+          return 1;
+        }
+        breakpoints.push_back(*value);
+      } else if (arg == "--watch" || arg == "--watch-read" ||
+                 arg == "--watch-write") {
+        if (i + 1 >= argc) {
+          std::cerr << "missing watchpoint address\n";
+          return 1;
+        }
+        const auto kind = arg == "--watch-read"    ? softcpu::WatchKind::Read
+                          : arg == "--watch-write" ? softcpu::WatchKind::Write
+                                                   : softcpu::WatchKind::Access;
+        auto value = parseWatchSpec(argv[++i], kind);
+        if (!value) {
+          std::cerr << "invalid watchpoint\n";
+          return 1;
+        }
+        watchpoints.push_back(*value);
       } else if (arg == "--help") {
         printUsage();
         return 0;
@@ -167,22 +505,437 @@ int main(int argc, char **argv) {
       std::cerr << "run requires a binary image\n";
       return 1;
     }
+    const bool caches = icache.size_bytes > 0 || dcache.size_bytes > 0;
+    if (caches && cores > 1) {
+      std::cerr << "cache modelling supports a single core\n";
+      return 1;
+    }
+    if (pipeline && cores > 1) {
+      std::cerr << "pipeline timing supports a single core\n";
+      return 1;
+    }
+    // Heatmap counters are plain integers on the shared bus, so parallel
+    // cores would race on them; the profiler and coverage follow core 0 only
+    if (!heatmap_prefix.empty() && cores > 1 && !deterministic) {
+      std::cerr << "--heatmap with several cores requires --deterministic\n";
+      return 1;
+    }
+    // Breakpoints, watchpoints and pacing live in the single-core run loop;
+    // parallel cores cannot interleave trace lines
+    if (cores > 1 && (!breakpoints.empty() || !watchpoints.empty())) {
+      std::cerr << "breakpoints and watchpoints support a single core\n";
+      return 1;
+    }
+    if (cores > 1 && clock_hz != 0) {
+      std::cerr << "--clock-hz supports a single core\n";
+      return 1;
+    }
+    if (cores > 1 && trace && !deterministic) {
+      std::cerr << "--trace with several cores requires --deterministic\n";
+      return 1;
+    }
+    if (profile && cores > 1) {
+      std::cerr << "profiling supports a single core\n";
+      return 1;
+    }
+    if (!coverage_path.empty() && cores > 1) {
+      std::cerr << "edge coverage supports a single core\n";
+      return 1;
+    }
+    if (!forwarding && !pipeline) {
+      std::cerr << "--no-forwarding requires --pipeline\n";
+      return 1;
+    }
 
     // Initialize and run the emulator
     softcpu::Emulator emulator;
+    // Physical memory grows to hold every banked section
+    for (const auto &block : banks) {
+      physical_memory =
+          std::max(physical_memory, block.address + block.bytes.size());
+    }
+    if (physical_memory > 0) {
+      emulator.setPhysicalMemory(physical_memory);
+    }
+    emulator.setCoreCount(cores);
     emulator.reset();
     if (!emulator.loadBinaryFile(program_path, origin)) {
       std::cerr << "unable to load " << program_path << '\n';
       return 1;
     }
-    emulator.registers().pc = entry;
+    for (const auto &block : banks) {
+      if (!emulator.loadPhysical(block.address, block.bytes)) {
+        std::cerr << "banked section at physical 0x" << std::hex
+                  << block.address << std::dec
+                  << " exceeds the physical memory limit\n";
+        return 1;
+      }
+    }
+    for (std::size_t core = 0; core < cores; ++core) {
+      emulator.registers(core).pc = entry;
+    }
+    for (const auto address : breakpoints) {
+      emulator.setBreakpoint(address);
+    }
+    for (const auto &watch : watchpoints) {
+      emulator.addWatchpoint(watch.address, watch.length, watch.kind);
+    }
+    if (!heatmap_prefix.empty()) {
+      emulator.enableHeatmap();
+    }
+    if (profile) {
+      emulator.enableProfiler();
+    }
+    if (caches) {
+      emulator.enableCache(icache, dcache);
+    }
+    if (pipeline) {
+      pipeline->forwarding = forwarding;
+      emulator.enablePipeline(*pipeline);
+    }
+    // Under afl-fuzz the edge map is AFL's shared memory segment
+    std::vector<std::uint8_t> coverage_map;
+    std::optional<softcpu::EdgeCoverage> coverage;
+    if (auto *shared = softcpu::attachAflSharedMemory()) {
+      if (cores > 1) {
+        std::cerr << "edge coverage supports a single core\n";
+        return 1;
+      }
+      coverage.emplace(shared, softcpu::kAflMapSize);
+    } else if (!coverage_path.empty()) {
+      coverage_map.assign(softcpu::kAflMapSize, 0);
+      coverage.emplace(coverage_map.data(), coverage_map.size());
+    }
+    if (coverage) {
+      emulator.setCoverage(&*coverage);
+    }
     softcpu::RunOptions run_options;
     run_options.cycle_limit = cycles;
     run_options.trace = trace;
-    if (!emulator.run(run_options)) {
+    run_options.clock_hz = clock_hz;
+    run_options.quantum = quantum;
+    run_options.deterministic = deterministic;
+    run_options.console = softcpu::makeConsoleSink(console);
+    if (!run_options.console) {
+      std::cerr << "unable to open console output " << console.path << '\n';
+      return 1;
+    }
+    const bool ok = emulator.run(run_options);
+    // Captured output is emitted in one write once the run finishes, even
+    // if it faulted
+    if (const auto *capture = dynamic_cast<const softcpu::CaptureSink *>(
+            run_options.console.get())) {
+      std::cout << capture->text() << std::flush;
+      if (capture->dropped() > 0) {
+        std::cerr << "console capture dropped " << capture->dropped()
+                  << " bytes\n";
+      }
+    }
+    // The heatmap is written even if the run faulted
+    if (const auto *heatmap = emulator.heatmap()) {
+      if (!heatmap->writePageCsv(heatmap_prefix + ".csv") ||
+          !heatmap->writeWordCsv(heatmap_prefix + "-words.csv") ||
+          !heatmap->writePpm(heatmap_prefix + ".ppm")) {
+        std::cerr << "failed to write heatmap " << heatmap_prefix << '\n';
+        return 1;
+      }
+    }
+    if (coverage && !coverage_path.empty()) {
+      const std::vector<std::uint8_t> edges(
+          coverage->map(), coverage->map() + coverage->size());
+      if (!softcpu::util::writeBinaryFile(coverage_path, edges)) {
+        std::cerr << "failed to write " << coverage_path << '\n';
+        return 1;
+      }
+      std::cerr << coverage->edgesHit() << " edges covered\n";
+    }
+    if (const auto *profiler = emulator.profiler()) {
+      profiler->writeReport(std::cerr, symbols);
+    }
+    if (const auto *cache = emulator.cache()) {
+      cache->writeReport(std::cerr, symbols, emulator.profiler());
+    }
+    if (const auto *model = emulator.pipeline()) {
+      model->writeReport(std::cerr, emulator.cycles());
+    }
+    if (!ok) {
+      const auto &stats = emulator.lastRunStats();
+      const auto address = stats.stop_address;
+      // Known opcodes fault on an invalid operand (CAS/FADD on a register)
+      const auto opcode = emulator.fetch8(address);
+      if (softcpu::isKnownOpcode(opcode)) {
+        std::fprintf(stderr, "Fault at PC %04X: invalid operand for %s",
+                     address,
+                     softcpu::opcodeName(static_cast<softcpu::Opcode>(opcode)));
+      } else {
+        std::fprintf(stderr, "Fault at PC %04X: unknown opcode %02X", address,
+                     opcode);
+      }
+      if (cores > 1) {
+        std::fprintf(stderr, " on core %u", unsigned{stats.stop_core});
+      }
+      std::fputc('\n', stderr);
       std::cerr << "execution stopped due to fault\n";
       return 1;
     }
+    const auto reason = emulator.lastRunStats().stop_reason;
+    if (reason == softcpu::StopReason::Breakpoint ||
+        reason == softcpu::StopReason::Watchpoint) {
+      printStop(emulator);
+    }
+    if (clock_hz != 0) {
+      const auto &stats = emulator.lastRunStats();
+      std::fprintf(stderr,
+                   "%llu cycles in %.3f s: %.0f Hz achieved (target %llu), "
+                   "host CPU %.1f%%\n",
+                   static_cast<unsigned long long>(stats.cycles),
+                   stats.wall_seconds, stats.achievedHz(),
+                   static_cast<unsigned long long>(clock_hz),
+                   100.0 * stats.hostUtilization());
+    }
+    return 0;
+  }
+
+  // Handle 'fuzz' command
+  if (command == "fuzz") {
+    softcpu::FuzzOptions options;
+    options.output_dir = "fuzz-out";
+    std::string program_path;
+    std::string corpus_dir;
+    bool have_region = false;
+    bool have_entry = false;
+
+    // Parse arguments for fuzz command
+    for (int i = 2; i < argc; ++i) {
+      const std::string arg = argv[i];
+      const bool has_value = i + 1 < argc;
+      if (arg == "--input-region") {
+        auto value = has_value ? parseWatchSpec(argv[++i],
+                                                softcpu::WatchKind::Access)
+                               : std::nullopt;
+        if (!value) {
+          std::cerr << "invalid input region\n";
+          return 1;
+        }
+        options.input_address = value->address;
+        options.input_length = value->length;
+        have_region = true;
+      } else if (arg == "--origin" || arg == "--entry" ||
+                 arg == "--stack-floor") {
+        auto value = has_value ? parseWord(argv[++i]) : std::nullopt;
+        if (!value) {
+          std::cerr << "invalid " << arg.substr(2) << " address\n";
+          return 1;
+        }
+        if (arg == "--origin") {
+          options.origin = *value;
+        } else if (arg == "--entry") {
+          options.entry = *value;
+          have_entry = true;
+        } else {
+          options.stack_floor = *value;
+        }
+      } else if (arg == "--jobs" || arg == "--cycles" || arg == "--execs" ||
+                 arg == "--seed") {
+        if (!has_value) {
+          std::cerr << "missing value for " << arg << '\n';
+          return 1;
+        }
+        const auto value = std::strtoull(argv[++i], nullptr, 0);
+        if (arg == "--jobs") {
+          options.jobs = static_cast<unsigned>(value);
+        } else if (arg == "--cycles") {
+          options.cycle_budget = value;
+        } else if (arg == "--execs") {
+          options.max_execs = value;
+        } else {
+          options.seed = value;
+        }
+      } else if (arg == "--seconds") {
+        if (!has_value) {
+          std::cerr << "missing value for --seconds\n";
+          return 1;
+        }
+        options.max_seconds = std::strtod(argv[++i], nullptr);
+      } else if (arg == "--out" || arg == "--corpus") {
+        if (!has_value) {
+          std::cerr << "missing directory for " << arg << '\n';
+          return 1;
+        }
+        (arg == "--out" ? options.output_dir : corpus_dir) = argv[++i];
+      } else if (!arg.empty() && arg[0] == '-') {
+        std::cerr << "unknown option: " << arg << '\n';
+        return 1;
+      } else {
+        program_path = arg;
+      }
+    }
+
+    if (program_path.empty() || !have_region) {
+      std::cerr << "fuzz requires a binary image and --input-region\n";
+      return 1;
+    }
+    if (!have_entry) {
+      options.entry = options.origin;
+    }
+    options.image = softcpu::util::readBinaryFile(program_path);
+    if (options.image.empty()) {
+      std::cerr << "unable to load " << program_path << '\n';
+      return 1;
+    }
+    if (!corpus_dir.empty()) {
+      std::error_code error;
+      for (const auto &entry :
+           std::filesystem::directory_iterator(corpus_dir, error)) {
+        if (entry.is_regular_file()) {
+          options.seeds.push_back(
+              softcpu::util::readBinaryFile(entry.path().string()));
+        }
+      }
+      if (error) {
+        std::cerr << "unable to read corpus " << corpus_dir << '\n';
+        return 1;
+      }
+    }
+
+    softcpu::Fuzzer fuzzer(std::move(options));
+    const auto print = [](const softcpu::FuzzStats &stats) {
+      std::fprintf(stderr,
+                   "%7.1fs  execs %llu (%.0f/s)  corpus %zu  edges %zu  "
+                   "crashes %llu\n",
+                   stats.seconds, static_cast<unsigned long long>(stats.execs),
+                   stats.seconds > 0.0
+                       ? static_cast<double>(stats.execs) / stats.seconds
+                       : 0.0,
+                   stats.corpus_size, stats.edges,
+                   static_cast<unsigned long long>(stats.crashes));
+    };
+    print(fuzzer.run(print));
+    return 0;
+  }
+
+  // Handle 'serve' command
+  if (command == "serve") {
+    softcpu::ServerOptions options;
+    for (int i = 2; i < argc; ++i) {
+      const std::string arg = argv[i];
+      if (arg == "--socket") {
+        if (i + 1 >= argc) {
+          std::cerr << "missing socket path\n";
+          return 1;
+        }
+        options.socket_path = argv[++i];
+      } else if (arg == "--workers") {
+        if (i + 1 >= argc) {
+          std::cerr << "missing worker count\n";
+          return 1;
+        }
+        options.workers =
+            static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 0));
+      } else {
+        std::cerr << "unknown option: " << arg << '\n';
+        return 1;
+      }
+    }
+    if (options.socket_path.empty()) {
+      std::cerr << "serve requires --socket\n";
+      return 1;
+    }
+
+    softcpu::JobServer server(std::move(options));
+    active_server = &server;
+    std::signal(SIGINT, stopServer);
+    std::signal(SIGTERM, stopServer);
+    const bool ok = server.serve();
+    active_server = nullptr;
+    if (!ok) {
+      std::cerr << "serve: " << server.error() << '\n';
+      return 1;
+    }
+    return 0;
+  }
+
+  // Handle 'disasm' command
+  if (command == "disasm") {
+    std::string program_path;
+    std::uint16_t origin = softcpu::kResetVector;
+    std::optional<std::uint16_t> entry;
+    softcpu::util::SymbolMap symbols;
+    std::string dot_path;
+    bool label_roots = true;
+
+    // Parse arguments for disasm command
+    for (int i = 2; i < argc; ++i) {
+      const std::string arg = argv[i];
+      if (arg == "--origin" || arg == "--entry") {
+        if (i + 1 >= argc) {
+          std::cerr << "missing " << arg.substr(2) << " value\n";
+          return 1;
+        }
+        auto value = parseWord(argv[++i]);
+        if (!value) {
+          std::cerr << "invalid " << arg.substr(2) << '\n';
+          return 1;
+        }
+        (arg == "--origin" ? origin : entry.emplace()) = *value;
+      } else if (arg == "--symbols") {
+        if (i + 1 >= argc) {
+          std::cerr << "missing symbol map path\n";
+          return 1;
+        }
+        auto value = softcpu::util::readSymbolMap(argv[++i]);
+        if (!value) {
+          std::cerr << "unable to read symbol map\n";
+          return 1;
+        }
+        symbols = std::move(*value);
+      } else if (arg == "--dot") {
+        if (i + 1 >= argc) {
+          std::cerr << "missing dot output path\n";
+          return 1;
+        }
+        dot_path = argv[++i];
+      } else if (arg == "--no-labels") {
+        label_roots = false;
+      } else if (!arg.empty() && arg[0] == '-') {
+        std::cerr << "unknown option: " << arg << '\n';
+        return 1;
+      } else {
+        program_path = arg;
+      }
+    }
+
+    if (program_path.empty()) {
+      std::cerr << "disasm requires a binary image\n";
+      return 1;
+    }
+    const auto image = softcpu::util::readBinaryFile(program_path);
+    if (image.empty() || origin + image.size() > softcpu::kMemorySize) {
+      std::cerr << "unable to load " << program_path << '\n';
+      return 1;
+    }
+    std::vector<std::uint8_t> memory(softcpu::kMemorySize, 0);
+    std::copy(image.begin(), image.end(), memory.begin() + origin);
+
+    // Walk from the entry point and, unless disabled, every label
+    std::vector<std::uint16_t> roots{entry.value_or(origin)};
+    if (label_roots) {
+      for (const auto &[address, name] : symbols) {
+        roots.push_back(address);
+      }
+    }
+    const softcpu::Disassembler disassembler(memory.data(), origin,
+                                             origin + image.size());
+    const auto cfg = disassembler.recover(roots);
+    disassembler.writeListing(std::cout, cfg, symbols);
+    if (!dot_path.empty()) {
+      std::ofstream dot(dot_path);
+      softcpu::Disassembler::writeDot(dot, cfg, symbols);
+      if (!dot) {
+        std::cerr << "failed to write " << dot_path << '\n';
+        return 1;
+      }
+    }
     return 0;
   }
 
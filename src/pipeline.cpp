@@ -0,0 +1,400 @@
+#include "softcpu/pipeline.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace softcpu {
+
+namespace {
+// Bit of the flags in register masks (R0-R7 use bits 0-7; R7 is SP)
+constexpr std::uint16_t kFlags = 1u << kRegisterCount;
+constexpr std::uint16_t kSp = 1u << (kRegisterCount - 1);
+
+// Bubbles behind a redirect resolved in ID and in EX
+constexpr std::uint64_t kDecodeRedirect = 1;
+constexpr std::uint64_t kExecuteRedirect = 2;
+
+// Cycles from entering EX until a result can be used by a following EX
+constexpr std::uint64_t kAluLatency = 1;  // Forwarded from EX/MEM
+constexpr std::uint64_t kLoadLatency = 2; // Forwarded from MEM/WB
+constexpr std::uint64_t kWritebackLatency = 3;
+
+enum class Control : std::uint8_t { None, Conditional, Direct, Indirect };
+
+// Registers an instruction reads and writes
+struct Effects {
+  std::uint16_t reads{0};
+  std::uint16_t writes{0};
+  std::uint16_t loaded{0}; // Writes whose value comes from memory
+  Control control{Control::None};
+};
+
+bool isMemory(const Operand &operand) {
+  return operand.type == OperandType::Absolute ||
+         operand.type == OperandType::RegisterIndirect ||
+         operand.type == OperandType::RegisterIndexed;
+}
+
+// Registers needed to evaluate an operand (the value or the address)
+std::uint16_t uses(const Operand &operand) {
+  switch (operand.type) {
+  case OperandType::Register:
+  case OperandType::RegisterIndirect:
+  case OperandType::RegisterIndexed:
+    return static_cast<std::uint16_t>(1u << operand.reg);
+  default:
+    return 0;
+  }
+}
+
+// Register written when an operand is a destination
+std::uint16_t defines(const Operand &operand) {
+  return operand.type == OperandType::Register
+             ? static_cast<std::uint16_t>(1u << operand.reg)
+             : 0;
+}
+
+Control jumpKind(const Operand &target) {
+  return target.type == OperandType::Immediate ? Control::Direct
+                                               : Control::Indirect;
+}
+
+Effects analyzeOpcode(const DecodedInstruction &inst) {
+  const auto &a = inst.operand_a;
+  const auto &b = inst.operand_b;
+  const auto modifier_reg = static_cast<std::uint16_t>(
+      1u << (inst.modifier & kModifierRegisterMask));
+  Effects fx;
+  if (isCompareBranch(inst.opcode)) {
+    fx.reads = static_cast<std::uint16_t>(uses(a) | uses(b));
+    fx.control = Control::Conditional;
+    return fx;
+  }
+  if (isConditionalBranch(inst.opcode)) {
+    fx.reads = static_cast<std::uint16_t>(uses(a) | kFlags);
+    fx.control = Control::Conditional;
+    return fx;
+  }
+  switch (inst.opcode) {
+  case Opcode::NOP:
+  case Opcode::HALT:
+  case Opcode::EI:
+  case Opcode::DI:
+  case Opcode::WAIT:
+    break;
+  case Opcode::LDI:
+  case Opcode::MOV:
+  case Opcode::LOAD:
+  case Opcode::IN:
+    fx.reads = static_cast<std::uint16_t>(
+        uses(b) | (isMemory(a) ? uses(a) : 0));
+    fx.writes = defines(a);
+    fx.loaded = isMemory(b) || inst.opcode == Opcode::IN ? fx.writes : 0;
+    if (inst.opcode == Opcode::LDI) {
+      fx.writes |= kFlags;
+    }
+    break;
+  case Opcode::STORE:
+    fx.reads = static_cast<std::uint16_t>(uses(a) | uses(b));
+    break;
+  case Opcode::NOT:
+  case Opcode::BSWAP:
+  case Opcode::ABS:
+  case Opcode::NEG:
+    fx.reads = uses(a);
+    fx.writes = static_cast<std::uint16_t>(defines(a) | kFlags);
+    fx.loaded = isMemory(a) ? defines(a) : 0;
+    break;
+  case Opcode::POPCNT:
+  case Opcode::CLZ:
+  case Opcode::CTZ:
+    fx.reads = static_cast<std::uint16_t>(
+        uses(b) | (isMemory(a) ? uses(a) : 0));
+    fx.writes = static_cast<std::uint16_t>(defines(a) | kFlags);
+    fx.loaded = isMemory(b) ? fx.writes : 0;
+    break;
+  case Opcode::CMP:
+  case Opcode::BTST:
+    fx.reads = static_cast<std::uint16_t>(uses(a) | uses(b));
+    fx.writes = kFlags;
+    fx.loaded = isMemory(a) || isMemory(b) ? kFlags : 0;
+    break;
+  case Opcode::JMP:
+    fx.reads = uses(a);
+    fx.control = jumpKind(a);
+    break;
+  case Opcode::CALL:
+    fx.reads = static_cast<std::uint16_t>(uses(a) | kSp);
+    fx.writes = kSp;
+    fx.control = jumpKind(a);
+    break;
+  case Opcode::RET:
+    fx.reads = kSp;
+    fx.writes = kSp;
+    fx.control = Control::Indirect;
+    break;
+  case Opcode::RETI:
+    fx.reads = kSp;
+    fx.writes = static_cast<std::uint16_t>(kSp | kFlags);
+    fx.loaded = kFlags;
+    fx.control = Control::Indirect;
+    break;
+  case Opcode::PUSH:
+    fx.reads = static_cast<std::uint16_t>(uses(a) | kSp);
+    fx.writes = kSp;
+    break;
+  case Opcode::POP:
+    fx.reads = static_cast<std::uint16_t>(kSp | (isMemory(a) ? uses(a) : 0));
+    fx.writes = static_cast<std::uint16_t>(kSp | defines(a));
+    fx.loaded = defines(a);
+    break;
+  case Opcode::OUT:
+    fx.reads = uses(b);
+    break;
+  case Opcode::ADJSP:
+    fx.reads = static_cast<std::uint16_t>(uses(a) | kSp);
+    fx.writes = kSp;
+    break;
+  case Opcode::SYS:
+    fx.reads = static_cast<std::uint16_t>(uses(a) | 1u); // Prints R0
+    break;
+  case Opcode::MEMCPY:
+  case Opcode::MEMSET:
+    fx.reads = static_cast<std::uint16_t>(uses(a) | uses(b) | modifier_reg);
+    break;
+  case Opcode::MEMCMP:
+    fx.reads = static_cast<std::uint16_t>(uses(a) | uses(b) | modifier_reg);
+    fx.writes = kFlags;
+    fx.loaded = kFlags;
+    break;
+  case Opcode::CAS:
+    fx.reads = static_cast<std::uint16_t>(uses(a) | uses(b) | modifier_reg);
+    fx.writes = static_cast<std::uint16_t>(modifier_reg | kFlags);
+    fx.loaded = fx.writes;
+    break;
+  case Opcode::FADD:
+    fx.reads = static_cast<std::uint16_t>(uses(a) | uses(b));
+    fx.writes = static_cast<std::uint16_t>(defines(b) | kFlags);
+    fx.loaded = fx.writes;
+    break;
+  case Opcode::ADC:
+  case Opcode::SBC:
+    fx.reads = static_cast<std::uint16_t>(uses(a) | uses(b) | kFlags);
+    fx.writes = static_cast<std::uint16_t>(defines(a) | kFlags);
+    fx.loaded = isMemory(a) || isMemory(b) ? fx.writes : 0;
+    break;
+  case Opcode::DIVMOD:
+    fx.reads = static_cast<std::uint16_t>(uses(a) | uses(b));
+    fx.writes =
+        static_cast<std::uint16_t>(defines(a) | modifier_reg | kFlags);
+    fx.loaded = isMemory(a) || isMemory(b) ? fx.writes : 0;
+    break;
+  case Opcode::UNPKB:
+    fx.reads = static_cast<std::uint16_t>(
+        uses(b) | (isMemory(a) ? uses(a) : 0));
+    fx.writes = static_cast<std::uint16_t>(defines(a) | modifier_reg);
+    fx.loaded = isMemory(b) ? fx.writes : 0;
+    break;
+  default:
+    // Two-operand ALU form: a = a op b, flags updated
+    fx.reads = static_cast<std::uint16_t>(uses(a) | uses(b));
+    fx.writes = static_cast<std::uint16_t>(defines(a) | kFlags);
+    fx.loaded = isMemory(a) || isMemory(b) ? fx.writes : 0;
+    break;
+  }
+  return fx;
+}
+
+// Effects including the base-register update of an auto-indexed operand
+// and the flags read by a predicate; predicated jumps become conditional
+Effects analyze(const DecodedInstruction &inst) {
+  auto fx = analyzeOpcode(inst);
+  if (conditionOf(inst.modifier) != Condition::Always) {
+    fx.reads |= kFlags;
+    if (fx.control != Control::None) {
+      fx.control = Control::Conditional;
+    }
+  }
+  for (const auto *operand : {&inst.operand_a, &inst.operand_b}) {
+    if (operand->auto_index != AutoIndex::None) {
+      fx.writes |= static_cast<std::uint16_t>(1u << operand->reg);
+    }
+  }
+  return fx;
+}
+} // namespace
+
+const char *predictorName(PredictorKind kind) {
+  switch (kind) {
+  case PredictorKind::Static:
+    return "static";
+  case PredictorKind::TwoBit:
+    return "2bit";
+  case PredictorKind::Gshare:
+    return "gshare";
+  }
+  return "?";
+}
+
+PipelineModel::PipelineModel(const PipelineConfig &config) : config_(config) {
+  clear();
+}
+
+bool PipelineModel::valid(const PipelineConfig &config) {
+  return config.table_bits >= 1 && config.table_bits <= 16 &&
+         config.history_bits <= config.table_bits;
+}
+
+void PipelineModel::clear() {
+  stats_ = {};
+  // Counters start weakly not-taken
+  counters_.assign(std::size_t{1} << config_.table_bits, 1);
+  history_ = 0;
+  clock_ = 0;
+  resume_ = 0;
+  ready_.fill(0);
+  loaded_.fill(false);
+}
+
+std::size_t PipelineModel::tableIndex(std::uint16_t pc) const {
+  const std::size_t mask = counters_.size() - 1;
+  if (config_.predictor == PredictorKind::Gshare) {
+    return (pc ^ history_) & mask;
+  }
+  return pc & mask;
+}
+
+bool PipelineModel::predict(std::uint16_t pc, std::uint16_t target,
+                            bool taken) {
+  if (config_.predictor == PredictorKind::Static) {
+    return (target <= pc) == taken;
+  }
+  auto &counter = counters_[tableIndex(pc)];
+  const bool predicted = counter >= 2;
+  if (taken && counter < 3) {
+    ++counter;
+  } else if (!taken && counter > 0) {
+    --counter;
+  }
+  if (config_.predictor == PredictorKind::Gshare) {
+    const std::uint32_t mask = (1u << config_.history_bits) - 1;
+    history_ = ((history_ << 1) | (taken ? 1u : 0u)) & mask;
+  }
+  return predicted == taken;
+}
+
+std::uint64_t PipelineModel::retire(const DecodedInstruction &inst,
+                                    std::uint16_t next_pc) {
+  const auto fx = analyze(inst);
+  ++stats_.instructions;
+
+  // Issue one cycle after the previous instruction unless a source is late
+  const std::uint64_t earliest = std::max(clock_ + 1, resume_);
+  std::uint64_t start = earliest;
+  bool late_load = false;
+  for (std::size_t reg = 0; reg < kTrackedRegisters; ++reg) {
+    if ((fx.reads & (1u << reg)) != 0 && ready_[reg] > start) {
+      start = ready_[reg];
+      late_load = loaded_[reg];
+    }
+  }
+  const std::uint64_t stall = start - earliest;
+  (late_load ? stats_.load_use_cycles : stats_.data_cycles) += stall;
+  clock_ = start;
+
+  for (std::size_t reg = 0; reg < kTrackedRegisters; ++reg) {
+    if ((fx.writes & (1u << reg)) == 0) {
+      continue;
+    }
+    const bool loaded = (fx.loaded & (1u << reg)) != 0;
+    ready_[reg] = start + (!config_.forwarding ? kWritebackLatency
+                           : loaded            ? kLoadLatency
+                                               : kAluLatency);
+    loaded_[reg] = loaded;
+  }
+
+  std::uint64_t bubbles = 0;
+  switch (fx.control) {
+  case Control::None:
+    break;
+  case Control::Conditional: {
+    const auto fallthrough =
+        static_cast<std::uint16_t>(inst.address + inst.size_bytes);
+    const bool taken = next_pc != fallthrough;
+    const auto target = directTarget(inst).value_or(next_pc);
+    ++stats_.branches;
+    stats_.taken += taken ? 1 : 0;
+    if (!predict(inst.address, target, taken)) {
+      ++stats_.mispredicts;
+      bubbles = kExecuteRedirect;
+      stats_.mispredict_cycles += bubbles;
+    } else if (taken) {
+      bubbles = kDecodeRedirect;
+      stats_.redirect_cycles += bubbles;
+    }
+    break;
+  }
+  case Control::Direct:
+    bubbles = kDecodeRedirect;
+    stats_.redirect_cycles += bubbles;
+    break;
+  case Control::Indirect:
+    bubbles = kExecuteRedirect;
+    stats_.redirect_cycles += bubbles;
+    break;
+  }
+  resume_ = start + 1 + bubbles;
+  return stall + bubbles;
+}
+
+void PipelineModel::writeReport(std::ostream &out,
+                                std::uint64_t total_cycles) const {
+  const auto instructions = stats_.instructions;
+  if (instructions == 0) {
+    out << "pipeline: no instructions retired\n";
+    return;
+  }
+  const auto per = [instructions](std::uint64_t cycles) {
+    return static_cast<double>(cycles) / static_cast<double>(instructions);
+  };
+  const auto pipeline = instructions + stats_.stallCycles();
+  const auto other = total_cycles > pipeline ? total_cycles - pipeline : 0;
+  char line[160];
+  std::snprintf(line, sizeof(line),
+                "pipeline: 5-stage, forwarding %s, predictor %s\n",
+                config_.forwarding ? "on" : "off",
+                predictorName(config_.predictor));
+  out << line;
+  std::snprintf(line, sizeof(line), "%llu instructions, %llu cycles, CPI %.3f\n",
+                static_cast<unsigned long long>(instructions),
+                static_cast<unsigned long long>(total_cycles),
+                per(total_cycles));
+  out << line;
+  const std::pair<const char *, std::uint64_t> causes[] = {
+      {"issue", instructions},
+      {"load-use", stats_.load_use_cycles},
+      {"data hazard", stats_.data_cycles},
+      {"mispredict", stats_.mispredict_cycles},
+      {"taken/jump", stats_.redirect_cycles},
+      {"memory/device", other}};
+  for (const auto &[name, cycles] : causes) {
+    std::snprintf(line, sizeof(line), "  %-14s %6.3f %12llu cycles\n", name,
+                  per(cycles), static_cast<unsigned long long>(cycles));
+    out << line;
+  }
+  const auto branches = stats_.branches;
+  std::snprintf(
+      line, sizeof(line),
+      "%llu conditional branches, %llu taken, %llu mispredicted (%.2f%% "
+      "accuracy)\n",
+      static_cast<unsigned long long>(branches),
+      static_cast<unsigned long long>(stats_.taken),
+      static_cast<unsigned long long>(stats_.mispredicts),
+      branches > 0 ? 100.0 * static_cast<double>(branches -
+                                                 stats_.mispredicts) /
+                         static_cast<double>(branches)
+                   : 100.0);
+  out << line;
+}
+
+} // namespace softcpu
@@ -0,0 +1,160 @@
+#include "softcpu/profiler.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <unordered_set>
+
+namespace softcpu {
+
+void CallProfiler::reset(std::uint16_t entry, std::uint16_t sp) {
+  functions_.clear();
+  stack_.clear();
+  pending_ = Pending::None;
+  base_sp_ = sp;
+  max_stack_bytes_ = 0;
+  max_depth_ = 0;
+  instructions_ = 0;
+  cycles_ = 0;
+  push(entry, 0, sp);
+}
+
+void CallProfiler::push(std::uint16_t target, std::uint16_t return_address,
+                        std::uint16_t sp) {
+  auto &activity = functions_[target];
+  activity.profile.entry = target;
+  ++activity.profile.calls;
+  ++activity.active;
+  stack_.push_back(
+      Frame{&activity, return_address, sp, sp, instructions_, cycles_});
+  max_depth_ = std::max(max_depth_, stack_.size());
+}
+
+void CallProfiler::pop() {
+  const Frame frame = stack_.back();
+  stack_.pop_back();
+  auto &profile = frame.function->profile;
+  // Only the outermost frame of a recursive function counts, otherwise the
+  // inner frames' time would be included several times
+  if (--frame.function->active == 0) {
+    profile.inclusive_instructions += instructions_ - frame.entry_instructions;
+    profile.inclusive_cycles += cycles_ - frame.entry_cycles;
+  }
+  profile.max_stack_bytes =
+      std::max(profile.max_stack_bytes,
+               static_cast<std::uint16_t>(frame.entry_sp - frame.min_sp));
+  if (!stack_.empty()) {
+    stack_.back().min_sp = std::min(stack_.back().min_sp, frame.min_sp);
+  }
+}
+
+void CallProfiler::retire(std::uint64_t cycles, bool instruction,
+                          std::uint16_t sp) {
+  instructions_ += instruction ? 1 : 0;
+  cycles_ += cycles;
+  if (!stack_.empty()) {
+    auto &top = stack_.back();
+    top.function->profile.exclusive_instructions += instruction ? 1 : 0;
+    top.function->profile.exclusive_cycles += cycles;
+    top.min_sp = std::min(top.min_sp, sp);
+  }
+  if (sp < base_sp_) {
+    max_stack_bytes_ = std::max(max_stack_bytes_,
+                                static_cast<std::uint16_t>(base_sp_ - sp));
+  }
+
+  switch (pending_) {
+  case Pending::None:
+    return;
+  case Pending::Call:
+    push(pending_target_, pending_return_, sp);
+    break;
+  case Pending::Return: {
+    // Unwind to the frame that returns here; a RET that matches no frame
+    // (e.g., a computed jump through the stack) leaves the stack alone. The
+    // root frame has no caller and is never popped.
+    for (std::size_t i = stack_.size(); i-- > 1;) {
+      if (stack_[i].return_address == pending_return_) {
+        while (stack_.size() > i) {
+          pop();
+        }
+        break;
+      }
+    }
+    break;
+  }
+  }
+  pending_ = Pending::None;
+}
+
+std::vector<FunctionProfile> CallProfiler::functions() const {
+  std::unordered_map<std::uint16_t, FunctionProfile> totals;
+  for (const auto &[entry, activity] : functions_) {
+    totals[entry] = activity.profile;
+  }
+
+  // Frames still open (at least the root) count up to now
+  std::unordered_set<std::uint16_t> seen;
+  for (const auto &frame : stack_) {
+    auto &profile = totals[frame.function->profile.entry];
+    if (seen.insert(profile.entry).second) {
+      profile.inclusive_instructions +=
+          instructions_ - frame.entry_instructions;
+      profile.inclusive_cycles += cycles_ - frame.entry_cycles;
+    }
+  }
+  std::uint16_t min_sp = 0xFFFF;
+  for (auto it = stack_.rbegin(); it != stack_.rend(); ++it) {
+    min_sp = std::min(min_sp, it->min_sp);
+    auto &profile = totals[it->function->profile.entry];
+    profile.max_stack_bytes =
+        std::max(profile.max_stack_bytes,
+                 static_cast<std::uint16_t>(it->entry_sp - min_sp));
+  }
+
+  std::vector<FunctionProfile> result;
+  result.reserve(totals.size());
+  for (const auto &[entry, profile] : totals) {
+    result.push_back(profile);
+  }
+  std::sort(result.begin(), result.end(),
+            [](const FunctionProfile &lhs, const FunctionProfile &rhs) {
+              if (lhs.inclusive_cycles != rhs.inclusive_cycles) {
+                return lhs.inclusive_cycles > rhs.inclusive_cycles;
+              }
+              return lhs.entry < rhs.entry;
+            });
+  return result;
+}
+
+void CallProfiler::writeReport(std::ostream &out,
+                               const util::SymbolMap &symbols) const {
+  char line[160];
+  std::snprintf(line, sizeof(line), "%-20s %8s %12s %12s %12s %12s %6s\n",
+                "function", "calls", "incl_cycles", "excl_cycles",
+                "incl_instr", "excl_instr", "stack");
+  out << line;
+  for (const auto &profile : functions()) {
+    std::string name;
+    if (auto it = symbols.find(profile.entry); it != symbols.end()) {
+      name = it->second;
+    } else {
+      char address[8];
+      std::snprintf(address, sizeof(address), "0x%04X", profile.entry);
+      name = address;
+    }
+    std::snprintf(
+        line, sizeof(line), "%-20s %8llu %12llu %12llu %12llu %12llu %6u\n",
+        name.c_str(), static_cast<unsigned long long>(profile.calls),
+        static_cast<unsigned long long>(profile.inclusive_cycles),
+        static_cast<unsigned long long>(profile.exclusive_cycles),
+        static_cast<unsigned long long>(profile.inclusive_instructions),
+        static_cast<unsigned long long>(profile.exclusive_instructions),
+        static_cast<unsigned>(profile.max_stack_bytes));
+    out << line;
+  }
+  out << "max call depth " << max_depth_ << ", max stack " << max_stack_bytes_
+      << " bytes\n";
+}
+
+} // namespace softcpu
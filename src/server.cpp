@@ -0,0 +1,428 @@
+#include "softcpu/server.hpp"
+
+#include "softcpu/emulator.hpp"
+#include "softcpu/utils.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <optional>
+#include <sstream>
+#include <thread>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace softcpu {
+
+namespace {
+// Cycle limit applied when a request does not set one, so a runaway guest
+// cannot pin a worker forever
+constexpr std::uint64_t kDefaultCycleLimit = 10'000'000;
+
+// Largest cycle limit a request may ask for; larger values are capped
+constexpr std::uint64_t kMaxCycleLimit = 1'000'000'000;
+
+// How often the accept loop checks for stop()
+constexpr int kAcceptPollMs = 200;
+
+// Longest request line accepted
+constexpr std::size_t kMaxLineLength = 4096;
+
+// Buffered reads and full writes on a connected socket (not owned)
+class Connection {
+public:
+  explicit Connection(int fd) : fd_(fd) {}
+
+  // Read one '\n'-terminated line (without the newline). Returns false on
+  // EOF, error, or an over-long line.
+  bool readLine(std::string &line) {
+    line.clear();
+    while (true) {
+      const char *first = buffer_.data() + start_;
+      const char *last = buffer_.data() + buffer_.size();
+      const char *newline = std::find(first, last, '\n');
+      if (newline != last) {
+        line.assign(first, newline);
+        start_ = static_cast<std::size_t>(newline - buffer_.data()) + 1;
+        if (!line.empty() && line.back() == '\r') {
+          line.pop_back();
+        }
+        return true;
+      }
+      if (buffer_.size() - start_ > kMaxLineLength || !fill()) {
+        return false;
+      }
+    }
+  }
+
+  // Read exactly `count` bytes
+  bool readExact(std::size_t count, std::vector<std::uint8_t> &out) {
+    out.clear();
+    while (out.size() < count) {
+      if (start_ == buffer_.size() && !fill()) {
+        return false;
+      }
+      const auto take = std::min(count - out.size(), buffer_.size() - start_);
+      out.insert(out.end(), buffer_.data() + start_,
+                 buffer_.data() + start_ + take);
+      start_ += take;
+    }
+    return true;
+  }
+
+  bool writeAll(const char *data, std::size_t size) {
+    while (size > 0) {
+      const auto written = ::send(fd_, data, size, MSG_NOSIGNAL);
+      if (written <= 0) {
+        return false;
+      }
+      data += written;
+      size -= static_cast<std::size_t>(written);
+    }
+    return true;
+  }
+
+  bool writeAll(const std::string &text) {
+    return writeAll(text.data(), text.size());
+  }
+
+private:
+  // Append whatever the socket has to the buffer, dropping consumed bytes
+  bool fill() {
+    buffer_.erase(buffer_.begin(),
+                  buffer_.begin() + static_cast<std::ptrdiff_t>(start_));
+    start_ = 0;
+    char chunk[16384];
+    const auto received = ::recv(fd_, chunk, sizeof(chunk), 0);
+    if (received <= 0) {
+      return false;
+    }
+    buffer_.insert(buffer_.end(), chunk, chunk + received);
+    return true;
+  }
+
+  int fd_;
+  std::vector<char> buffer_;
+  std::size_t start_{0};
+};
+
+// A parsed RUN request
+struct Request {
+  std::string path;
+  std::size_t image_size{0};
+  std::uint16_t origin{kResetVector};
+  std::optional<std::uint16_t> entry;
+  std::uint64_t cycles{kDefaultCycleLimit};
+  std::uint16_t input_address{0};
+  std::size_t input_size{0};
+};
+
+// Parse "RUN key=value ..." into `request`; returns an error message or ""
+std::string parseRequest(const std::string &line, Request &request) {
+  std::istringstream fields(line);
+  std::string command;
+  fields >> command;
+  if (command != "RUN") {
+    return "unknown command";
+  }
+  std::string field;
+  while (fields >> field) {
+    const auto equals = field.find('=');
+    if (equals == std::string::npos) {
+      return "malformed field " + field;
+    }
+    const auto key = field.substr(0, equals);
+    const auto value = field.substr(equals + 1);
+    if (key == "path") {
+      request.path = value;
+      continue;
+    }
+    if (key == "input") {
+      const auto colon = value.find(':');
+      const auto address = util::parseNumber(value.substr(0, colon));
+      const auto size = colon == std::string::npos
+                            ? std::nullopt
+                            : util::parseNumber(value.substr(colon + 1));
+      if (!address || !size || *address < 0 || *size < 0 ||
+          *address + static_cast<std::size_t>(*size) > kMemorySize) {
+        return "invalid input region";
+      }
+      request.input_address = static_cast<std::uint16_t>(*address);
+      request.input_size = static_cast<std::size_t>(*size);
+      continue;
+    }
+    const auto number = util::parseNumber(value);
+    if (!number || *number < 0) {
+      return "invalid value for " + key;
+    }
+    if (key == "cycles") {
+      // Zero would mean an unlimited run
+      if (*number == 0) {
+        return "invalid value for " + key;
+      }
+      request.cycles =
+          std::min(static_cast<std::uint64_t>(*number), kMaxCycleLimit);
+      continue;
+    }
+    if (key == "image") {
+      if (static_cast<std::size_t>(*number) > kMemorySize) {
+        return "image larger than memory";
+      }
+      request.image_size = static_cast<std::size_t>(*number);
+    } else if (key == "origin") {
+      request.origin = static_cast<std::uint16_t>(*number & 0xFFFF);
+    } else if (key == "entry") {
+      request.entry = static_cast<std::uint16_t>(*number & 0xFFFF);
+    } else {
+      return "unknown field " + key;
+    }
+  }
+  if (request.path.empty() == (request.image_size == 0)) {
+    return "exactly one of path= or image= is required";
+  }
+  return "";
+}
+
+// Accepted connections waiting for a worker, plus the ones being served so
+// that close() can interrupt them
+class ConnectionQueue {
+public:
+  void push(int fd) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      fds_.push_back(fd);
+    }
+    ready_.notify_one();
+  }
+
+  // Next connection, or -1 once closed and drained
+  int pop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ready_.wait(lock, [this] { return closed_ || !fds_.empty(); });
+    if (fds_.empty()) {
+      return -1;
+    }
+    const int fd = fds_.front();
+    fds_.pop_front();
+    active_.push_back(fd);
+    return fd;
+  }
+
+  // Close a connection returned by pop()
+  void release(int fd) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    active_.erase(std::find(active_.begin(), active_.end(), fd));
+    ::close(fd);
+  }
+
+  // Stop handing out connections and wake workers blocked on open ones
+  void close() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      closed_ = true;
+      for (const int fd : fds_) {
+        ::close(fd);
+      }
+      fds_.clear();
+      for (const int fd : active_) {
+        ::shutdown(fd, SHUT_RDWR);
+      }
+    }
+    ready_.notify_all();
+  }
+
+private:
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::deque<int> fds_;
+  std::vector<int> active_;
+  bool closed_{false};
+};
+
+// One pool member: a warm Emulator serving connections from the queue
+class Worker {
+public:
+  Worker(JobServer &server, std::size_t console_capacity)
+      : server_(server),
+        console_(std::make_shared<CaptureSink>(console_capacity)) {
+    emulator_.setConsoleSink(console_);
+  }
+
+  void serve(ConnectionQueue &queue) {
+    for (int fd = queue.pop(); fd >= 0; fd = queue.pop()) {
+      Connection connection(fd);
+      std::string line;
+      while (connection.readLine(line)) {
+        if (!line.empty() && !handle(connection, line)) {
+          break;
+        }
+      }
+      queue.release(fd);
+    }
+  }
+
+private:
+  // Execute one request and write its response; false drops the connection.
+  // An exception fails the request instead of the whole server.
+  bool handle(Connection &connection, const std::string &line) {
+    try {
+      return execute(connection, line);
+    } catch (const std::exception &error) {
+      return connection.writeAll(std::string("ERR ") + error.what() + "\n");
+    }
+  }
+
+  bool execute(Connection &connection, const std::string &line) {
+    Request request;
+    const auto problem = parseRequest(line, request);
+    if (!problem.empty()) {
+      return connection.writeAll("ERR " + problem + "\n");
+    }
+    if (request.image_size > 0) {
+      if (!connection.readExact(request.image_size, image_)) {
+        return false;
+      }
+    } else if (!server_.loadImage(request.path, image_)) {
+      return connection.writeAll("ERR unable to load " + request.path + "\n");
+    }
+    if (!connection.readExact(request.input_size, input_)) {
+      return false;
+    }
+    // Checked once the payload is consumed, so the stream stays in step
+    if (request.origin + image_.size() > kMemorySize) {
+      return connection.writeAll("ERR image does not fit at origin\n");
+    }
+
+    emulator_.reset();
+    emulator_.loadImage(image_, request.origin);
+    std::copy(input_.begin(), input_.end(),
+              emulator_.memory().data() + request.input_address);
+    emulator_.registers().pc = request.entry.value_or(request.origin);
+    console_->clear();
+    RunOptions options;
+    options.cycle_limit = request.cycles;
+    emulator_.run(options);
+
+    const auto &stats = emulator_.lastRunStats();
+    const auto &regs = emulator_.registers();
+    // Keep the reason a single token, e.g. "cycle_limit"
+    std::string reason = stopReasonName(stats.stop_reason);
+    std::replace(reason.begin(), reason.end(), ' ', '_');
+    char header[256];
+    auto used = std::snprintf(
+        header, sizeof(header),
+        "OK reason=%s cycles=%llu instructions=%llu pc=0x%04X sp=0x%04X "
+        "flags=0x%02X",
+        reason.c_str(),
+        static_cast<unsigned long long>(stats.cycles),
+        static_cast<unsigned long long>(stats.instructions), regs.pc, regs.sp,
+        static_cast<unsigned>(regs.flags.value));
+    for (std::size_t i = 0; i < regs.gpr.size(); ++i) {
+      used += std::snprintf(header + used, sizeof(header) - used,
+                            " r%zu=0x%04X", i, regs.gpr[i]);
+    }
+    const auto text = console_->text();
+    std::snprintf(header + used, sizeof(header) - used, " console=%zu\n",
+                  text.size());
+    return connection.writeAll(header) &&
+           connection.writeAll(text.data(), text.size());
+  }
+
+  JobServer &server_;
+  Emulator emulator_;
+  std::shared_ptr<CaptureSink> console_;
+  std::vector<std::uint8_t> image_;
+  std::vector<std::uint8_t> input_;
+};
+} // namespace
+
+JobServer::JobServer(ServerOptions options) : options_(std::move(options)) {
+  options_.workers = std::max(1u, options_.workers);
+}
+
+bool JobServer::loadImage(const std::string &path,
+                          std::vector<std::uint8_t> &image) {
+  std::error_code error;
+  const auto modified = std::filesystem::last_write_time(path, error);
+  if (error) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  auto it = image_cache_.find(path);
+  if (it == image_cache_.end() || it->second.modified != modified) {
+    auto bytes = util::readBinaryFile(path);
+    if (bytes.empty() || bytes.size() > kMemorySize) {
+      return false;
+    }
+    it = image_cache_.insert_or_assign(path, CachedImage{modified, bytes})
+             .first;
+  }
+  image = it->second.bytes;
+  return true;
+}
+
+bool JobServer::serve() {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (options_.socket_path.empty() ||
+      options_.socket_path.size() >= sizeof(address.sun_path)) {
+    error_ = "invalid socket path";
+    return false;
+  }
+  std::memcpy(address.sun_path, options_.socket_path.c_str(),
+              options_.socket_path.size() + 1);
+
+  const int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener < 0) {
+    error_ = std::strerror(errno);
+    return false;
+  }
+  ::unlink(options_.socket_path.c_str());
+  if (::bind(listener, reinterpret_cast<const sockaddr *>(&address),
+             sizeof(address)) != 0 ||
+      ::listen(listener, SOMAXCONN) != 0) {
+    error_ = std::strerror(errno);
+    ::close(listener);
+    return false;
+  }
+
+  // Emulators are built once, before the first request arrives
+  ConnectionQueue queue;
+  std::vector<std::unique_ptr<Worker>> workers;
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < options_.workers; ++i) {
+    workers.push_back(
+        std::make_unique<Worker>(*this, options_.console_capacity));
+  }
+  for (auto &worker : workers) {
+    threads.emplace_back([&worker, &queue] { worker->serve(queue); });
+  }
+
+  pollfd poll_fd{listener, POLLIN, 0};
+  while (!stop_) {
+    if (::poll(&poll_fd, 1, kAcceptPollMs) <= 0) {
+      continue;
+    }
+    const int fd = ::accept(listener, nullptr, nullptr);
+    if (fd >= 0) {
+      queue.push(fd);
+    }
+  }
+
+  queue.close();
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  ::close(listener);
+  ::unlink(options_.socket_path.c_str());
+  return true;
+}
+
+} // namespace softcpu
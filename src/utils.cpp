@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <cctype>
 #include <charconv>
+#include <cstdio>
 #include <fstream>
 #include <sstream>
 #include <system_error>
@@ -102,4 +103,95 @@ bool writeBinaryFile(const std::string &path,
   return output.good();
 }
 
+bool writeSymbolMap(
+    const std::string &path,
+    const std::vector<std::pair<std::string, std::uint16_t>> &labels) {
+  std::ofstream output(path);
+  if (!output) {
+    return false;
+  }
+  char address[8];
+  for (const auto &[name, value] : labels) {
+    std::snprintf(address, sizeof(address), "0x%04X", value);
+    output << address << ' ' << name << '\n';
+  }
+  return output.good();
+}
+
+std::optional<SymbolMap> readSymbolMap(const std::string &path) {
+  std::ifstream input(path);
+  if (!input) {
+    return std::nullopt;
+  }
+  SymbolMap symbols;
+  std::string line;
+  while (std::getline(input, line)) {
+    std::istringstream fields(line);
+    std::string address;
+    std::string name;
+    if (!(fields >> address >> name)) {
+      continue;
+    }
+    if (const auto value = parseNumber(address)) {
+      symbols.emplace(static_cast<std::uint16_t>(*value & 0xFFFF), name);
+    }
+  }
+  return symbols;
+}
+
+namespace {
+// Little-endian 32-bit field of a bank file record
+void putWord32(std::vector<std::uint8_t> &out, std::uint32_t value) {
+  for (int shift = 0; shift < 32; shift += 8) {
+    out.push_back(static_cast<std::uint8_t>((value >> shift) & 0xFF));
+  }
+}
+
+std::uint32_t getWord32(const std::uint8_t *in) {
+  return static_cast<std::uint32_t>(in[0]) |
+         (static_cast<std::uint32_t>(in[1]) << 8) |
+         (static_cast<std::uint32_t>(in[2]) << 16) |
+         (static_cast<std::uint32_t>(in[3]) << 24);
+}
+} // namespace
+
+bool writeBankFile(const std::string &path,
+                   const std::vector<PhysicalBlock> &blocks) {
+  std::vector<std::uint8_t> data;
+  for (const auto &block : blocks) {
+    putWord32(data, block.address);
+    putWord32(data, static_cast<std::uint32_t>(block.bytes.size()));
+    data.insert(data.end(), block.bytes.begin(), block.bytes.end());
+  }
+  return writeBinaryFile(path, data);
+}
+
+std::optional<std::vector<PhysicalBlock>>
+readBankFile(const std::string &path) {
+  std::ifstream input(path, std::ios::binary);
+  if (!input) {
+    return std::nullopt;
+  }
+  const auto data = readBinaryFile(path);
+  std::vector<PhysicalBlock> blocks;
+  std::size_t at = 0;
+  while (at < data.size()) {
+    if (data.size() - at < 8) {
+      return std::nullopt;
+    }
+    PhysicalBlock block;
+    block.address = getWord32(data.data() + at);
+    const std::size_t length = getWord32(data.data() + at + 4);
+    at += 8;
+    if (data.size() - at < length) {
+      return std::nullopt;
+    }
+    block.bytes.assign(data.begin() + static_cast<std::ptrdiff_t>(at),
+                       data.begin() + static_cast<std::ptrdiff_t>(at + length));
+    at += length;
+    blocks.push_back(std::move(block));
+  }
+  return blocks;
+}
+
 } // namespace softcpu::util
@@ -0,0 +1,124 @@
+#include "test_support.hpp"
+
+#include <string>
+
+using namespace softcpu;
+using namespace std::string_literals;
+
+namespace {
+
+std::string memoryText(const Emulator &emulator, std::uint16_t address,
+                       std::size_t length) {
+  std::string text;
+  for (std::size_t i = 0; i < length; ++i) {
+    text += static_cast<char>(
+        emulator.memory().read8(static_cast<std::uint16_t>(address + i)));
+  }
+  return text;
+}
+
+void copyIsOverlapSafe() {
+  Emulator emulator;
+  test::runSource(emulator, R"(
+        LDI r0, #0x8000
+        LDI r1, #text
+        LDI r2, #8
+        MEMCPY r0, r1, r2
+        ; shift right by two, then left by one, within the copy
+        LDI r3, #0x8002
+        MEMCPY r3, r0, r2
+        LDI r4, #0x8001
+        MEMCPY r0, r4, r2
+        HALT
+text:
+        .ascii "abcdefgh"
+)");
+  // "abcdefgh" -> "ababcdefgh" -> "babcdefggh"
+  CHECK_EQ(memoryText(emulator, 0x8000, 10), "babcdefggh"s);
+  const auto &regs = emulator.registers();
+  CHECK_EQ(regs.gpr[0], 0x8000); // Registers are left unchanged
+  CHECK_EQ(regs.gpr[2], 8);
+}
+
+void fillUsesTheLowByte() {
+  Emulator emulator;
+  test::runSource(emulator, R"(
+        LDI r0, #0x8001
+        LDI r1, #0x1234
+        LDI r2, #3
+        MEMSET r0, r1, r2
+        LDI r2, #0
+        LDI r1, #0x55
+        MEMSET r0, r1, r2        ; zero length writes nothing
+        HALT
+)");
+  CHECK_EQ(memoryText(emulator, 0x8000, 5), "\0\x34\x34\x34\0"s);
+}
+
+// Flags after MEMCMP of `lhs` and `rhs` over `count` bytes
+FlagRegister compareFlags(const std::string &lhs, const std::string &rhs,
+                          unsigned count) {
+  Emulator emulator;
+  test::runSource(emulator, R"(
+        LDI r0, #lhs
+        LDI r1, #rhs
+        LDI r2, #)" + std::to_string(count) + R"(
+        MEMCMP r0, r1, r2
+        HALT
+lhs:
+        .ascii ")" + lhs + R"("
+rhs:
+        .ascii ")" + rhs + R"("
+)");
+  return emulator.registers().flags;
+}
+
+void compareSetsFlagsLikeCmp() {
+  auto flags = compareFlags("same", "same", 4);
+  CHECK(flags.test(StatusFlag::kZero));
+  CHECK(flags.test(StatusFlag::kCarry));
+
+  // First difference decides: 'a' < 'b' borrows
+  flags = compareFlags("xaz", "xba", 3);
+  CHECK(!flags.test(StatusFlag::kZero));
+  CHECK(!flags.test(StatusFlag::kCarry));
+  CHECK(flags.test(StatusFlag::kNegative));
+
+  flags = compareFlags("xca", "xbz", 3);
+  CHECK(!flags.test(StatusFlag::kZero));
+  CHECK(flags.test(StatusFlag::kCarry));
+  CHECK(!flags.test(StatusFlag::kNegative));
+
+  // Bytes past the count are ignored
+  flags = compareFlags("abX", "abY", 2);
+  CHECK(flags.test(StatusFlag::kZero));
+  flags = compareFlags("a", "b", 0);
+  CHECK(flags.test(StatusFlag::kZero));
+}
+
+void blockCostsStallCycles() {
+  Emulator plain;
+  test::runSource(plain, R"(
+        LDI r2, #0
+        MEMCPY r0, r1, r2
+        HALT
+)");
+  Emulator copying;
+  test::runSource(copying, R"(
+        LDI r2, #64
+        MEMCPY r0, r1, r2
+        HALT
+)");
+  // Two stall cycles per word moved
+  CHECK_EQ(copying.cycles() - plain.cycles(), 64u);
+}
+
+} // namespace
+
+int main() {
+  copyIsOverlapSafe();
+  fillUsesTheLowByte();
+  compareSetsFlagsLikeCmp();
+  blockCostsStallCycles();
+  return test::result();
+}
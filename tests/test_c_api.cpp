@@ -0,0 +1,157 @@
+#include "test_support.hpp"
+
+#include "softcpu/softcpu.h"
+
+#include <vector>
+
+using namespace softcpu;
+
+namespace {
+
+// Assembled with the C++ assembler; the library itself is used only
+// through the C API
+std::vector<std::uint8_t> assemble(const std::string &source) {
+  Assembler assembler;
+  const auto assembled = assembler.assembleString(source);
+  CHECK(assembled.ok);
+  return assembled.bytes;
+}
+
+// Doubles R1 into R0, prints it and halts
+const std::vector<std::uint8_t> &doubler() {
+  static const auto image = assemble(R"(
+        MOV r0, r1
+        ADD r0, r1
+        SYS #2
+        HALT
+)");
+  return image;
+}
+
+void createLoadAndRun() {
+  CHECK_EQ(softcpu_abi_version(), SOFTCPU_ABI_VERSION);
+  auto *machine = softcpu_create();
+  CHECK(machine != nullptr);
+  if (machine == nullptr) {
+    return;
+  }
+  const auto &image = doubler();
+  CHECK_EQ(softcpu_load(machine, image.data(), image.size(), 0), 0);
+  // Loads that would run past the address space are rejected untouched
+  CHECK_EQ(softcpu_load(machine, image.data(), image.size(), 0xFFFE), -1);
+  CHECK_EQ(softcpu_memory(machine)[0xFFFE], 0);
+
+  softcpu_set_register(machine, 1, 21);
+  softcpu_capture_console(machine, 64);
+  softcpu_run_result result{};
+  CHECK_EQ(softcpu_run(machine, 0, &result), SOFTCPU_STOP_HALTED);
+  CHECK_EQ(result.reason, SOFTCPU_STOP_HALTED);
+  CHECK_EQ(result.cycles, softcpu_cycles(machine));
+  CHECK_EQ(result.instructions, 4u);
+  CHECK_EQ(softcpu_get_register(machine, 0), 42);
+  size_t size = 0;
+  const char *text = softcpu_console_output(machine, &size);
+  CHECK_EQ(std::string(text, size), "[R0=42]\n");
+  softcpu_clear_console(machine);
+  softcpu_console_output(machine, &size);
+  CHECK_EQ(size, 0u);
+
+  // Without capture the output is discarded
+  softcpu_capture_console(machine, 0);
+  softcpu_set_pc(machine, 0);
+  softcpu_run(machine, 0, nullptr);
+  text = softcpu_console_output(machine, &size);
+  CHECK_EQ(size, 0u);
+  CHECK_EQ(std::string(text), "");
+  softcpu_destroy(machine);
+}
+
+void registerAccessors() {
+  auto *machine = softcpu_create();
+  CHECK(machine != nullptr);
+  if (machine == nullptr) {
+    return;
+  }
+  CHECK_EQ(softcpu_get_sp(machine), kStackReset);
+  softcpu_set_register(machine, SOFTCPU_REGISTER_COUNT - 1, 0x8000);
+  CHECK_EQ(softcpu_get_sp(machine), 0x8000);
+  softcpu_set_sp(machine, 0x7000);
+  CHECK_EQ(softcpu_get_register(machine, SOFTCPU_REGISTER_COUNT - 1),
+           0x7000);
+  // Indices past the register file read as zero and ignore writes
+  softcpu_set_register(machine, SOFTCPU_REGISTER_COUNT, 5);
+  CHECK_EQ(softcpu_get_register(machine, SOFTCPU_REGISTER_COUNT), 0);
+  softcpu_set_flags(machine, 0x0003);
+  CHECK_EQ(softcpu_get_flags(machine), 0x0003);
+  softcpu_reset(machine);
+  CHECK_EQ(softcpu_get_flags(machine), 0);
+  softcpu_destroy(machine);
+}
+
+void faultsAndCycleLimits() {
+  auto *machine = softcpu_create();
+  CHECK(machine != nullptr);
+  if (machine == nullptr) {
+    return;
+  }
+  const auto spin = assemble("NOP\nspin:\nJMP spin\n");
+  softcpu_load(machine, spin.data(), spin.size(), 0);
+  softcpu_run_result result{};
+  CHECK_EQ(softcpu_run(machine, 500, &result), SOFTCPU_STOP_CYCLE_LIMIT);
+  CHECK_EQ(result.cycles, 500u);
+
+  softcpu_reset(machine);
+  const std::uint8_t unknown[] = {0xFF, 0, 0, 0};
+  softcpu_load(machine, unknown, sizeof(unknown), 0x100);
+  softcpu_set_pc(machine, 0x100);
+  CHECK_EQ(softcpu_run(machine, 0, &result), SOFTCPU_STOP_FAULT);
+  CHECK_EQ(result.stop_address, 0x100);
+  softcpu_destroy(machine);
+}
+
+void batchRunsEveryMachine() {
+  constexpr std::size_t kMachines = 10;
+  std::vector<softcpu_machine *> machines;
+  for (std::size_t i = 0; i < kMachines; ++i) {
+    auto *machine = softcpu_create();
+    CHECK(machine != nullptr);
+    if (machine == nullptr) {
+      return;
+    }
+    machines.push_back(machine);
+  }
+  const auto &image = doubler();
+  // Serial (threads 0 and 1), parallel, more threads than machines, and
+  // without results
+  for (const unsigned threads : {0u, 1u, 3u, 16u}) {
+    for (std::size_t i = 0; i < kMachines; ++i) {
+      softcpu_reset(machines[i]);
+      softcpu_load(machines[i], image.data(), image.size(), 0);
+      softcpu_set_register(machines[i], 1, static_cast<uint16_t>(i));
+    }
+    std::vector<softcpu_run_result> results(kMachines);
+    softcpu_run_batch(machines.data(), kMachines, 0, threads,
+                      threads == 16 ? nullptr : results.data());
+    for (std::size_t i = 0; i < kMachines; ++i) {
+      CHECK_EQ(softcpu_get_register(machines[i], 0), 2 * i);
+      if (threads != 16) {
+        CHECK_EQ(results[i].reason, SOFTCPU_STOP_HALTED);
+        CHECK_EQ(results[i].instructions, 4u);
+      }
+    }
+  }
+  softcpu_run_batch(machines.data(), 0, 0, 4, nullptr); // Nothing to run
+  for (auto *machine : machines) {
+    softcpu_destroy(machine);
+  }
+}
+
+} // namespace
+
+int main() {
+  createLoadAndRun();
+  registerAccessors();
+  faultsAndCycleLimits();
+  batchRunsEveryMachine();
+  return test::result();
+}
@@ -0,0 +1,92 @@
+#include "test_support.hpp"
+
+#include "softcpu/cache.hpp"
+
+using namespace softcpu;
+
+namespace {
+
+void geometryValidation() {
+  CHECK((CacheConfig{1024, 2, 16, 10}.valid()));
+  CHECK(!(CacheConfig{1000, 2, 16, 10}.valid()));
+  CHECK(!(CacheConfig{1024, 3, 16, 10}.valid()));
+  CHECK(!(CacheConfig{16, 2, 16, 10}.valid())); // Two ways of one line
+  Emulator emulator;
+  CHECK(!emulator.enableCache({1000, 1, 16, 10}, {}));
+  CHECK(emulator.cache() == nullptr);
+}
+
+void lruAndWriteBack() {
+  // Two sets of two 16-byte lines
+  Cache cache({64, 2, 16, 10});
+  CHECK_EQ(cache.access(0x0000, false), 10u); // Miss
+  CHECK_EQ(cache.access(0x000F, false), 0u);  // Same line
+  CHECK_EQ(cache.access(0x0040, true), 10u);  // Set 0, second way, dirty
+  CHECK_EQ(cache.access(0x0000, false), 0u);  // 0x0000 is now most recent
+  // A third line in set 0 evicts the dirty 0x0040: fill plus write-back
+  CHECK_EQ(cache.access(0x0080, false), 20u);
+  CHECK_EQ(cache.access(0x0000, false), 0u);
+  CHECK_EQ(cache.access(0x0010, false), 10u); // Set 1 is independent
+  const auto &stats = cache.stats();
+  CHECK_EQ(stats.accesses, 7u);
+  CHECK_EQ(stats.misses, 4u);
+  CHECK_EQ(stats.writebacks, 1u);
+  CHECK_EQ(stats.penalty_cycles, 50u);
+  cache.clear();
+  CHECK_EQ(cache.stats().accesses, 0u);
+  CHECK_EQ(cache.access(0x0000, false), 10u);
+}
+
+// Sums a 1 KiB table twice; the second pass hits only if it fits
+const char *const kTableSum = R"(
+        LDI r3, #2
+pass:   LDI r1, #0x4000
+        LDI r2, #512
+sum:    ADD r0, [r1]+
+        SUBI r2, #1
+        JNZ sum
+        SUBI r3, #1
+        JNZ pass
+        HALT
+)";
+
+void missesAddCycles() {
+  Emulator plain;
+  test::runSource(plain, kTableSum);
+  const auto base = plain.cycles();
+
+  Emulator cached;
+  test::loadSource(cached, kTableSum);
+  CHECK(cached.enableCache({256, 1, 16, 10}, {2048, 2, 16, 10}));
+  test::runCaptured(cached);
+  const auto *data = cached.cache()->dataCache();
+  CHECK(data != nullptr);
+  if (data == nullptr) {
+    return;
+  }
+  // 1 KiB of 16-byte lines: 64 cold misses, then the second pass hits
+  CHECK_EQ(data->stats().misses, 64u);
+  CHECK_EQ(data->stats().accesses, 1024u);
+  const auto penalty =
+      data->stats().penalty_cycles +
+      cached.cache()->instructionCache()->stats().penalty_cycles;
+  CHECK_EQ(cached.cycles(), base + penalty);
+
+  // The same loop with a cache too small for the table misses every line
+  // on both passes
+  Emulator small;
+  test::loadSource(small, kTableSum);
+  CHECK(small.enableCache({}, {512, 2, 16, 10}));
+  test::runCaptured(small);
+  CHECK_EQ(small.cache()->dataCache()->stats().misses, 128u);
+  CHECK(small.cache()->instructionCache() == nullptr);
+}
+
+} // namespace
+
+int main() {
+  geometryValidation();
+  lruAndWriteBack();
+  missesAddCycles();
+  return test::result();
+}
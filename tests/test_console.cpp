@@ -0,0 +1,84 @@
+#include "test_support.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+using namespace softcpu;
+
+namespace {
+
+void captureKeepsCapacityAndCountsDrops() {
+  CaptureSink sink(8);
+  sink.put('a');
+  sink.write("bcdef");
+  CHECK_EQ(sink.text(), "abcdef");
+  sink.write("ghijk");
+  CHECK_EQ(sink.text(), "abcdefgh");
+  CHECK_EQ(sink.dropped(), 3u);
+  sink.put('z');
+  CHECK_EQ(sink.dropped(), 4u);
+  sink.clear();
+  CHECK_EQ(sink.text(), "");
+  CHECK_EQ(sink.dropped(), 0u);
+  sink.write("xy");
+  CHECK_EQ(sink.text(), "xy");
+}
+
+void factoryBuildsEachMode() {
+  ConsoleOptions options;
+  options.mode = ConsoleMode::Capture;
+  options.capacity = 16;
+  auto capture = std::dynamic_pointer_cast<CaptureSink>(
+      makeConsoleSink(options));
+  CHECK(capture != nullptr);
+  if (capture != nullptr) {
+    CHECK_EQ(capture->capacity(), 16u);
+  }
+  options.mode = ConsoleMode::Null;
+  CHECK(makeConsoleSink(options) != nullptr);
+  options.mode = ConsoleMode::File;
+  options.path = "/nonexistent-directory/console.txt";
+  CHECK(makeConsoleSink(options) == nullptr);
+}
+
+void fileSinkWritesOnFlush() {
+  const std::string path = "softcpu_test_console.txt";
+  {
+    FileSink sink(path);
+    CHECK(sink.ok());
+    sink.put('>');
+    sink.write(" done\n");
+    sink.flush();
+  }
+  std::ifstream in(path, std::ios::binary);
+  const std::string text((std::istreambuf_iterator<char>(in)),
+                         std::istreambuf_iterator<char>());
+  CHECK_EQ(text, "> done\n");
+  std::remove(path.c_str());
+}
+
+void runOptionsInstallTheSink() {
+  Emulator emulator;
+  const auto text = test::runSource(emulator, R"(
+        LDI r1, #'h'
+        STORE r1, [IO_CONSOLE_DATA]
+        LDI r1, #'i'
+        STORE r1, [IO_CONSOLE_DATA]
+        LDI r0, #42
+        SYS #2
+        HALT
+)");
+  CHECK_EQ(text, "hi[R0=42]\n");
+  CHECK(emulator.lastRunStats().stop_reason == StopReason::Halted);
+}
+
+} // namespace
+
+int main() {
+  captureKeepsCapacityAndCountsDrops();
+  factoryBuildsEachMode();
+  fileSinkWritesOnFlush();
+  runOptionsInstallTheSink();
+  return test::result();
+}
@@ -0,0 +1,71 @@
+#include "test_support.hpp"
+
+#include "softcpu/coverage.hpp"
+
+#include <algorithm>
+#include <vector>
+
+using namespace softcpu;
+
+namespace {
+
+void countersNeverWrapToZero() {
+  std::vector<std::uint8_t> map(64);
+  EdgeCoverage coverage(map.data(), map.size());
+  for (int i = 0; i < 255; ++i) {
+    coverage.record(0x10, 0x20);
+  }
+  CHECK_EQ(coverage.edgesHit(), 1u);
+  coverage.record(0x10, 0x20); // 255 + 1 skips zero
+  CHECK_EQ(coverage.edgesHit(), 1u);
+}
+
+std::size_t edgesOf(const std::string &source, std::vector<std::uint8_t> &map) {
+  Emulator emulator;
+  EdgeCoverage coverage(map.data(), map.size());
+  test::loadSource(emulator, source);
+  emulator.setCoverage(&coverage);
+  test::runCaptured(emulator);
+  emulator.setCoverage(nullptr);
+  return coverage.edgesHit();
+}
+
+void onlyTakenBranchesCount() {
+  std::vector<std::uint8_t> map(kAflMapSize);
+  CHECK_EQ(edgesOf("LDI r0, #1\nJZ skip\nADDI r0, #1\nskip:\nHALT\n", map),
+           0u);
+
+  std::fill(map.begin(), map.end(), 0);
+  const auto edges = edgesOf(R"(
+        LDI r2, #4
+loop:
+        SUBI r2, #1
+        JNZ loop
+        HALT
+)", map);
+  CHECK_EQ(edges, 1u);
+  // The back edge was taken three times
+  CHECK(std::find(map.begin(), map.end(), 3) != map.end());
+
+  // Different paths through a program give different maps
+  std::vector<std::uint8_t> other(kAflMapSize);
+  edgesOf(R"(
+        LDI r2, #4
+loop:
+        SUBI r2, #1
+        JNZ loop
+        CALL leaf
+        HALT
+leaf:
+        RET
+)", other);
+  CHECK(other != map);
+}
+
+} // namespace
+
+int main() {
+  countersNeverWrapToZero();
+  onlyTakenBranchesCount();
+  return test::result();
+}
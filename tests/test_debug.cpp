@@ -0,0 +1,85 @@
+#include "test_support.hpp"
+
+using namespace softcpu;
+
+namespace {
+
+const char *const kLoop = R"(
+        LDI r1, #0
+        LDI r2, #3
+loop:
+        ADDI r1, #1
+        STORE r1, [counter]
+        SUBI r2, #1
+        JNZ loop
+done:
+        LOAD r3, [counter]
+        HALT
+counter:
+        .word 0
+)";
+
+void breakpointStopsBeforeAndResumes() {
+  Emulator emulator;
+  const auto assembled = test::loadSource(emulator, kLoop);
+  const auto loop = test::labelAddress(assembled, "loop");
+  emulator.setBreakpoint(loop);
+  for (unsigned pass = 0; pass < 3; ++pass) {
+    test::runCaptured(emulator);
+    const auto &stats = emulator.lastRunStats();
+    CHECK(stats.stop_reason == StopReason::Breakpoint);
+    CHECK_EQ(stats.stop_address, loop);
+    CHECK_EQ(emulator.registers().pc, loop);
+    CHECK_EQ(emulator.registers().gpr[1], pass); // ADDI not yet executed
+  }
+  emulator.clearBreakpoints();
+  test::runCaptured(emulator);
+  CHECK(emulator.lastRunStats().stop_reason == StopReason::Halted);
+  CHECK_EQ(emulator.registers().gpr[1], 3);
+}
+
+void watchpointsSeparateReadsAndWrites() {
+  Emulator emulator;
+  const auto assembled = test::loadSource(emulator, kLoop);
+  const auto counter = test::labelAddress(assembled, "counter");
+  emulator.addWatchpoint(counter, 2, WatchKind::Read);
+  test::runCaptured(emulator);
+  auto stats = emulator.lastRunStats();
+  // The loop only writes the counter; the read is the LOAD after it
+  CHECK(stats.stop_reason == StopReason::Watchpoint);
+  CHECK_EQ(stats.stop_address, counter);
+  CHECK(!stats.stop_on_write);
+  CHECK_EQ(emulator.registers().gpr[3], 3); // The LOAD has completed
+
+  test::loadSource(emulator, kLoop);
+  emulator.clearWatchpoints();
+  emulator.addWatchpoint(static_cast<std::uint16_t>(counter + 1), 1,
+                         WatchKind::Write);
+  test::runCaptured(emulator);
+  stats = emulator.lastRunStats();
+  CHECK(stats.stop_reason == StopReason::Watchpoint);
+  CHECK(stats.stop_on_write);
+  CHECK_EQ(emulator.memory().read16(counter), 1);
+}
+
+void debugRunKeepsCycleCounts() {
+  // The debug loop must account cycles exactly like the plain one
+  Emulator plain;
+  test::runSource(plain, kLoop);
+  Emulator watched;
+  test::loadSource(watched, kLoop);
+  watched.addWatchpoint(0xF000, 2, WatchKind::Access);
+  test::runCaptured(watched);
+  CHECK(watched.lastRunStats().stop_reason == StopReason::Halted);
+  CHECK_EQ(watched.cycles(), plain.cycles());
+  CHECK_EQ(watched.instructions(), plain.instructions());
+}
+
+} // namespace
+
+int main() {
+  breakpointStopsBeforeAndResumes();
+  watchpointsSeparateReadsAndWrites();
+  debugRunKeepsCycleCounts();
+  return test::result();
+}
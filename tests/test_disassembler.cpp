@@ -0,0 +1,141 @@
+#include "test_support.hpp"
+
+#include "softcpu/disassembler.hpp"
+
+#include <algorithm>
+#include <array>
+#include <sstream>
+
+using namespace softcpu;
+
+namespace {
+
+const char *const kNested = R"(
+start:  LDI r1, #3
+outer:  LDI r2, #4
+inner:  SUBI r2, #1
+        JNZ inner
+        CALL leaf
+        SUBI r1, #1
+        JNZ outer
+        HALT
+leaf:   ADDI r0, #1
+        RET
+)";
+
+struct Program {
+  AssemblyResult assembled;
+  std::array<std::uint8_t, kMemorySize> memory{};
+};
+
+Program assemble(const std::string &source) {
+  Program program;
+  Assembler assembler;
+  program.assembled = assembler.assembleString(source);
+  CHECK(program.assembled.ok);
+  std::copy(program.assembled.bytes.begin(), program.assembled.bytes.end(),
+            program.memory.begin());
+  return program;
+}
+
+void recoversBlocksAndLoops() {
+  const auto program = assemble(kNested);
+  const auto &assembled = program.assembled;
+  Disassembler disassembler(program.memory.data(), 0,
+                            assembled.bytes.size());
+  const auto cfg = disassembler.recover({0});
+
+  const auto outer = test::labelAddress(assembled, "outer");
+  const auto inner = test::labelAddress(assembled, "inner");
+  const auto leaf = test::labelAddress(assembled, "leaf");
+  // start, outer, inner, CALL through JNZ outer, HALT, leaf; a CALL does
+  // not end its block
+  CHECK_EQ(cfg.blocks.size(), 6u);
+  CHECK_EQ(cfg.loops, 2u);
+  const auto inner_block = cfg.blockAt(inner);
+  const auto outer_block = cfg.blockAt(outer);
+  const auto leaf_block = cfg.blockAt(leaf);
+  CHECK(inner_block && outer_block && leaf_block);
+  if (!inner_block || !outer_block || !leaf_block) {
+    return;
+  }
+  CHECK(cfg.blocks[*inner_block].loop_header);
+  CHECK_EQ(cfg.blocks[*inner_block].loop_depth, 2u);
+  CHECK_EQ(cfg.blocks[*inner_block].instructions.size(), 2u);
+  CHECK_EQ(cfg.blocks[*inner_block].cycles, 2u);
+  CHECK(cfg.blocks[*outer_block].loop_header);
+  CHECK_EQ(cfg.blocks[*outer_block].loop_depth, 1u);
+  CHECK_EQ(cfg.blocks[*leaf_block].loop_depth, 0u);
+  CHECK(std::find(cfg.functions.begin(), cfg.functions.end(), leaf) !=
+        cfg.functions.end());
+
+  const auto has = [&](std::uint16_t from, std::uint16_t to, EdgeKind kind) {
+    return std::any_of(cfg.edges.begin(), cfg.edges.end(),
+                       [&](const CfgEdge &edge) {
+                         return edge.from == from && edge.to == to &&
+                                edge.kind == kind;
+                       });
+  };
+  CHECK(has(inner, inner, EdgeKind::Taken));
+  CHECK(has(outer, inner, EdgeKind::Fallthrough));
+  CHECK(std::any_of(cfg.edges.begin(), cfg.edges.end(),
+                    [&](const CfgEdge &edge) {
+                      return edge.to == leaf && edge.kind == EdgeKind::Call;
+                    }));
+}
+
+void invalidBytesEndABlock() {
+  const auto program = assemble("LDI r0, #1\nbad: .byte 0xFF, 0, 0, 0\n");
+  const auto bad = test::labelAddress(program.assembled, "bad");
+  Disassembler disassembler(program.memory.data(), 0,
+                            program.assembled.bytes.size());
+  CHECK(!disassembler.decode(bad));
+  const auto cfg = disassembler.recover({0});
+  CHECK_EQ(cfg.blocks.size(), 1u);
+  if (!cfg.blocks.empty()) {
+    CHECK(cfg.blocks.front().invalid);
+    CHECK_EQ(cfg.blocks.front().instructions.size(), 1u);
+  }
+  // An instruction cut off by the end of the code range does not decode
+  Disassembler truncated(program.memory.data(), 0, 2);
+  CHECK(!truncated.decode(0));
+}
+
+void formatReassembles() {
+  // Every listed instruction assembles back to the same bytes
+  const auto program = assemble(kNested);
+  const auto &bytes = program.assembled.bytes;
+  Disassembler disassembler(program.memory.data(), 0, bytes.size());
+  const util::SymbolMap no_symbols;
+  std::uint16_t address = 0;
+  while (address < bytes.size()) {
+    const auto inst = disassembler.decode(address);
+    CHECK(inst.has_value());
+    if (!inst) {
+      return;
+    }
+    const auto text = Disassembler::format(*inst, no_symbols);
+    Assembler assembler;
+    AssemblerOptions options;
+    options.origin = address;
+    const auto again = assembler.assembleString(text + "\n", options);
+    CHECK(again.ok);
+    CHECK(std::equal(again.bytes.begin(), again.bytes.end(),
+                     bytes.begin() + address) &&
+          again.bytes.size() == inst->size_bytes);
+    address = static_cast<std::uint16_t>(address + inst->size_bytes);
+  }
+
+  std::ostringstream dot;
+  Disassembler::writeDot(dot, disassembler.recover({0}), no_symbols);
+  CHECK(dot.str().rfind("digraph", 0) == 0);
+}
+
+} // namespace
+
+int main() {
+  recoversBlocksAndLoops();
+  invalidBytesEndABlock();
+  formatReassembles();
+  return test::result();
+}
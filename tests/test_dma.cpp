@@ -0,0 +1,84 @@
+#include "test_support.hpp"
+
+using namespace softcpu;
+
+namespace {
+
+void copyFillAndConsoleTransfers() {
+  Emulator emulator;
+  const auto text = test::runSource(emulator, R"(
+        LDI r0, #message
+        STORE r0, [IO_DMA_SRC]
+        LDI r0, #0x8000
+        STORE r0, [IO_DMA_DST]
+        LDI r0, #6
+        STORE r0, [IO_DMA_LEN]
+        LDI r0, #0x0100         ; start | copy
+        STORE r0, [IO_DMA_MODE]
+        LOAD.B r1, [IO_DMA_CONTROL]
+        LOAD.B r2, [IO_IRQ_PENDING]
+        ; overwrite "lo" with "!!" and print the copy
+        LDI r0, #'!'
+        STORE.B r0, [IO_DMA_FILL]
+        LDI r0, #0x8003
+        STORE r0, [IO_DMA_DST]
+        LDI r0, #2
+        STORE r0, [IO_DMA_LEN]
+        LDI r0, #0x0101         ; start | fill
+        STORE r0, [IO_DMA_MODE]
+        LDI r0, #0x8000
+        STORE r0, [IO_DMA_SRC]
+        LDI r0, #6
+        STORE r0, [IO_DMA_LEN]
+        LDI r0, #0x0102         ; start | memory-to-console
+        STORE r0, [IO_DMA_MODE]
+        HALT
+message:
+        .ascii "Hello\n"
+)");
+  CHECK_EQ(text, "Hel!!\n");
+  const auto &regs = emulator.registers();
+  CHECK_EQ(regs.gpr[1], 0x80); // done
+  CHECK_EQ(regs.gpr[2] & 0x02, 0x02); // line 1 raised
+  CHECK_EQ(emulator.memory().read8(0x8000), 'H');
+}
+
+void consoleTransferFromDevicePage() {
+  // The DMA registers themselves are the source, so the transfer takes the
+  // byte-wise bus path
+  Emulator emulator;
+  const auto text = test::runSource(emulator, R"(
+        LDI r0, #IO_DMA_SRC
+        STORE r0, [IO_DMA_SRC]
+        LDI r0, #2
+        STORE r0, [IO_DMA_LEN]
+        LDI r0, #0x0102
+        STORE r0, [IO_DMA_MODE]
+        HALT
+)");
+  // The source register holds its own address when the transfer reads it
+  CHECK_EQ(text, "0\xFF");
+}
+
+void invalidModeOnlySetsError() {
+  Emulator emulator;
+  test::runSource(emulator, R"(
+        LDI r0, #0x0107
+        STORE r0, [IO_DMA_MODE]
+        LOAD.B r1, [IO_DMA_CONTROL]
+        LOAD.B r2, [IO_IRQ_PENDING]
+        HALT
+)");
+  const auto &regs = emulator.registers();
+  CHECK_EQ(regs.gpr[1], 0x40);
+  CHECK_EQ(regs.gpr[2] & 0x02, 0);
+}
+
+} // namespace
+
+int main() {
+  copyFillAndConsoleTransfers();
+  consoleTransferFromDevicePage();
+  invalidModeOnlySetsError();
+  return test::result();
+}
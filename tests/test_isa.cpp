@@ -0,0 +1,648 @@
+#include "test_support.hpp"
+
+#include <iostream>
+#include <iterator>
+#include <utility>
+
+using namespace softcpu;
+
+namespace {
+
+// Run a program to HALT and return core 0's registers
+RegisterFile run(const std::string &source) {
+  Emulator emulator;
+  test::runSource(emulator, source);
+  CHECK(emulator.lastRunStats().stop_reason == StopReason::Halted);
+  return emulator.registers();
+}
+
+// Flags as a "CZNV" string with '-' for clear bits, for readable failures
+std::string flagString(const FlagRegister &flags) {
+  std::string text = "----";
+  if (flags.test(StatusFlag::kCarry)) {
+    text[0] = 'C';
+  }
+  if (flags.test(StatusFlag::kZero)) {
+    text[1] = 'Z';
+  }
+  if (flags.test(StatusFlag::kNegative)) {
+    text[2] = 'N';
+  }
+  if (flags.test(StatusFlag::kOverflow)) {
+    text[3] = 'V';
+  }
+  return text;
+}
+
+// Multi-precision arithmetic (ADC, SBC, MULH, MULHU, DIVMOD)
+
+void carryChains() {
+  // 48-bit R2:R1:R0 = 0x0000FFFFFFFF + 1; the carry ripples twice
+  auto regs = run(R"(
+        LDI r0, #0xFFFF
+        LDI r1, #0xFFFF
+        LDI r2, #0
+        ADD r0, #1
+        ADC r1, #0
+        ADC r2, #0
+        HALT
+)");
+  CHECK_EQ(regs.gpr[0], 0);
+  CHECK_EQ(regs.gpr[1], 0);
+  CHECK_EQ(regs.gpr[2], 1);
+  CHECK_EQ(flagString(regs.flags), "----");
+
+  // 0x0001_0000_0000 - 1 borrows through both low words
+  regs = run(R"(
+        LDI r0, #0
+        LDI r1, #0
+        LDI r2, #1
+        SUB r0, #1
+        SBC r1, #0
+        SBC r2, #0
+        HALT
+)");
+  CHECK_EQ(regs.gpr[0], 0xFFFF);
+  CHECK_EQ(regs.gpr[1], 0xFFFF);
+  CHECK_EQ(regs.gpr[2], 0);
+  CHECK_EQ(flagString(regs.flags), "CZ--"); // No borrow out of the top word
+
+  // A borrow out of the top word clears C; signed overflow sets V
+  regs = run(R"(
+        LDI r0, #0
+        LDI r1, #0x8000
+        SUB r0, #1
+        SBC r1, #0
+        HALT
+)");
+  CHECK_EQ(regs.gpr[1], 0x7FFF);
+  CHECK_EQ(flagString(regs.flags), "C--V");
+  regs = run(R"(
+        LDI r0, #0
+        LDI r1, #0
+        SUB r0, #1
+        SBC r1, #0
+        HALT
+)");
+  CHECK_EQ(regs.gpr[1], 0xFFFF);
+  CHECK_EQ(flagString(regs.flags), "--N-");
+
+  // ADC adds the carry-out of the previous word (LDI clears C, so the
+  // operands are loaded first)
+  regs = run(R"(
+        LDI r1, #0x7FFF
+        LDI r0, #0x8000
+        ADD r0, #0x8000
+        ADC r1, #0
+        HALT
+)");
+  CHECK_EQ(regs.gpr[1], 0x8000);
+  CHECK_EQ(flagString(regs.flags), "--NV");
+}
+
+void highProducts() {
+  auto regs = run(R"(
+        LDI r0, #0xFFFE         ; -2
+        MULH r0, #3             ; -6 -> high word 0xFFFF, fits in 16 bits
+        HALT
+)");
+  CHECK_EQ(regs.gpr[0], 0xFFFF);
+  CHECK_EQ(flagString(regs.flags), "--N-");
+  regs = run(R"(
+        LDI r0, #0xFFFF
+        MULHU r0, #0xFFFF       ; 0xFFFE0001
+        HALT
+)");
+  CHECK_EQ(regs.gpr[0], 0xFFFE);
+  CHECK(regs.flags.test(StatusFlag::kCarry));
+  CHECK(regs.flags.test(StatusFlag::kOverflow));
+  regs = run(R"(
+        LDI r0, #0x4000
+        MULH r0, #2             ; 0x8000 does not fit as a signed word
+        HALT
+)");
+  CHECK_EQ(regs.gpr[0], 0);
+  CHECK(regs.flags.test(StatusFlag::kCarry));
+  CHECK(regs.flags.test(StatusFlag::kOverflow));
+}
+
+void divisionAndRemainder() {
+  auto regs = run(R"(
+        LDI r0, #100
+        LDI r1, #7
+        DIVMOD r0, r1, r2
+        HALT
+)");
+  CHECK_EQ(regs.gpr[0], 14);
+  CHECK_EQ(regs.gpr[2], 2);
+  CHECK_EQ(flagString(regs.flags), "----");
+
+  regs = run(R"(
+        LDI r0, #5
+        LDI r1, #9
+        DIVMOD r0, r1, r2       ; quotient 0 sets Z
+        HALT
+)");
+  CHECK_EQ(regs.gpr[0], 0);
+  CHECK_EQ(regs.gpr[2], 5);
+  CHECK_EQ(flagString(regs.flags), "-Z--");
+
+  // Unsigned: 0xFFFF / 2
+  regs = run(R"(
+        LDI r0, #0xFFFF
+        LDI r1, #2
+        DIVMOD r0, r1, r3
+        HALT
+)");
+  CHECK_EQ(regs.gpr[0], 0x7FFF);
+  CHECK_EQ(regs.gpr[3], 1);
+
+  // Division by zero: quotient 0, the remainder keeps the dividend
+  regs = run(R"(
+        LDI r0, #1234
+        LDI r1, #0
+        DIVMOD r0, r1, r2
+        HALT
+)");
+  CHECK_EQ(regs.gpr[0], 0);
+  CHECK_EQ(regs.gpr[2], 1234);
+  CHECK(regs.flags.test(StatusFlag::kCarry));
+  CHECK(regs.flags.test(StatusFlag::kOverflow));
+
+  // The remainder is written last when it names the destination
+  regs = run(R"(
+        LDI r0, #100
+        LDI r1, #7
+        DIVMOD r0, r1, r0
+        HALT
+)");
+  CHECK_EQ(regs.gpr[0], 2);
+}
+
+// Post-increment and pre-decrement addressing
+
+void autoIndexing() {
+  // Copy four words in reverse: post-increment source, pre-decrement
+  // destination
+  Emulator emulator;
+  const auto assembled = test::loadSource(emulator, R"(
+        LDI r1, #src
+        LDI r2, #dst_end
+        LDI r3, #4
+copy:   MOV r0, [r1]+
+        MOV -[r2], r0
+        SUBI r3, #1
+        JNZ copy
+        HALT
+src:    .word 1, 2, 3, 4
+dst:    .word 0, 0, 0, 0
+dst_end:
+)");
+  test::runCaptured(emulator);
+  const auto src = test::labelAddress(assembled, "src");
+  const auto dst = test::labelAddress(assembled, "dst");
+  const auto &regs = emulator.registers();
+  CHECK_EQ(regs.gpr[1], src + 8);
+  CHECK_EQ(regs.gpr[2], dst);
+  for (std::uint16_t i = 0; i < 4; ++i) {
+    CHECK_EQ(emulator.memory().read16(static_cast<std::uint16_t>(dst + 2 * i)),
+             4 - i);
+  }
+
+  // Byte steps, and a read-modify-write updates its register once
+  const auto step = run(R"(
+        LDI r1, #data
+        LOAD r2, [r1]+1          ; word at data, r1 += 1
+        LDI r3, #data_end
+        LOAD r4, -1[r3]          ; word at data_end - 1
+        LDI r5, #data
+        LDI r0, #0x0100
+        ADD [r5]+, r0            ; data += 0x100 once, r5 += 2
+        LOAD r6, [data]
+        SUB r5, r1
+        HALT
+data:   .word 0x2211, 0x4433
+data_end:
+)");
+  CHECK_EQ(step.gpr[2], 0x2211);
+  CHECK_EQ(step.gpr[3], step.gpr[1] + 2); // data_end - 1 = data + 3
+  CHECK_EQ(step.gpr[4], 0x0044);           // Last byte, then memory past it
+  CHECK_EQ(step.gpr[6], 0x2311);
+  CHECK_EQ(step.gpr[5], 1);                // data + 2 - (data + 1)
+}
+
+// Byte-width loads and stores
+
+void byteAccesses() {
+  Emulator emulator;
+  const auto assembled = test::loadSource(emulator, R"(
+        LOAD.B r1, [bytes]       ; zero-extended
+        LOAD.SB r2, [bytes]      ; sign-extended
+        LDI r0, #bytes
+        LOAD.B r3, [r0]+         ; byte steps advance by one
+        LOAD.B r3, [r0]+
+        LDI r4, #0xAB12
+        STORE.B r4, [slot]       ; only the low byte is written
+        ; strlen without masking words
+        LDI r0, #text
+        LDI r5, #0
+next:   LOAD.B r1, [r0]+
+        CMP r1, #0
+        JZ done
+        ADDI r5, #1
+        JMP next
+done:   LOAD.B r1, [bytes]
+        HALT
+bytes:  .byte 0x80, 0x7F
+slot:   .word 0xFFFF
+text:   .ascii "four"
+        .byte 0
+)");
+  test::runCaptured(emulator);
+  const auto slot = test::labelAddress(assembled, "slot");
+  const auto text = test::labelAddress(assembled, "text");
+  const auto &regs = emulator.registers();
+  CHECK_EQ(regs.gpr[1], 0x0080);
+  CHECK_EQ(regs.gpr[2], 0xFF80);
+  CHECK_EQ(regs.gpr[3], 0x007F);
+  CHECK_EQ(emulator.memory().read16(slot), 0xFF12);
+  CHECK_EQ(regs.gpr[5], 4);
+  CHECK_EQ(regs.gpr[0], text + 5);
+}
+
+void byteStoreToADevice() {
+  // Byte stores work on device registers too: one character each
+  Emulator emulator;
+  const auto text = test::runSource(emulator, R"(
+        LDI r0, #0x0A41
+        STORE.B r0, [IO_CONSOLE_DATA]
+        STORE.B r0, [IO_CONSOLE_DATA]
+        HALT
+)");
+  CHECK_EQ(text, "AA");
+}
+
+// Predicated execution
+
+void predicatedInstructions() {
+  // Branch-free signed max/min of r1 and r2
+  auto regs = run(R"(
+        LDI r1, #-5
+        LDI r2, #3
+        MOV r0, r1
+        MOV r3, r1
+        CMP r1, r2
+        MOV.lt r0, r2           ; max
+        MOV.gt r3, r2           ; min: skipped
+        HALT
+)");
+  CHECK_EQ(regs.gpr[0], 3);
+  CHECK_EQ(regs.gpr[3], 0xFFFB);
+
+  // Unsigned conditions read the same compare differently
+  regs = run(R"(
+        LDI r1, #0xFFFB
+        LDI r0, #0
+        CMP r1, #3
+        MOV.hi r0, #1
+        MOV.lo r0, #2           ; skipped
+        HALT
+)");
+  CHECK_EQ(regs.gpr[0], 1);
+
+  // A skipped instruction leaves flags, memory and auto-index registers
+  // alone, and a skipped HALT falls through
+  Emulator emulator;
+  const auto assembled = test::loadSource(emulator, R"(
+        LDI r0, #cell
+        LDI r1, #7
+        CMP r1, #7              ; Z=1
+        STORE.nz r1, [r0]+
+        ADD.nz r1, #1
+        HALT.nz
+        MOV r2, #1              ; MOV keeps the flags
+        HALT.z
+        MOV r2, #2
+        HALT
+cell:   .word 0
+)");
+  test::runCaptured(emulator);
+  const auto cell = test::labelAddress(assembled, "cell");
+  const auto &after = emulator.registers();
+  CHECK_EQ(after.gpr[0], cell);
+  CHECK_EQ(after.gpr[1], 7);
+  CHECK_EQ(after.gpr[2], 1);
+  CHECK_EQ(emulator.memory().read16(cell), 0);
+}
+
+void skippedInstructionsCostACycle() {
+  Emulator taken;
+  test::runSource(taken, "CMP r0, #0\nADD.z r1, #1\nHALT\n");
+  Emulator skipped;
+  test::runSource(skipped, "CMP r0, #0\nADD.nz r1, #1\nHALT\n");
+  CHECK_EQ(taken.registers().gpr[1], 1);
+  CHECK_EQ(skipped.registers().gpr[1], 0);
+  CHECK_EQ(skipped.cycles(), taken.cycles());
+  CHECK_EQ(skipped.instructions(), taken.instructions());
+}
+
+// Branch conditions and fused compare-and-branch
+
+struct BranchCase {
+  const char *mnemonic;
+  bool (*holds)(std::uint16_t a, std::uint16_t b);
+};
+
+std::int16_t asSigned(std::uint16_t value) {
+  return static_cast<std::int16_t>(value);
+}
+
+// Flags of CMP a, b
+bool negative(std::uint16_t a, std::uint16_t b) {
+  return (static_cast<std::uint16_t>(a - b) & 0x8000) != 0;
+}
+bool overflow(std::uint16_t a, std::uint16_t b) {
+  const int difference = asSigned(a) - asSigned(b);
+  return difference < -32768 || difference > 32767;
+}
+
+const BranchCase kBranches[] = {
+    {"JZ", [](std::uint16_t a, std::uint16_t b) { return a == b; }},
+    {"JNZ", [](std::uint16_t a, std::uint16_t b) { return a != b; }},
+    {"JN", [](std::uint16_t a, std::uint16_t b) { return negative(a, b); }},
+    {"JNN", [](std::uint16_t a, std::uint16_t b) { return !negative(a, b); }},
+    {"JC", [](std::uint16_t a, std::uint16_t b) { return a >= b; }},
+    {"JNC", [](std::uint16_t a, std::uint16_t b) { return a < b; }},
+    {"JV", [](std::uint16_t a, std::uint16_t b) { return overflow(a, b); }},
+    {"JNV", [](std::uint16_t a, std::uint16_t b) { return !overflow(a, b); }},
+    {"JLT", [](std::uint16_t a,
+               std::uint16_t b) { return asSigned(a) < asSigned(b); }},
+    {"JGE", [](std::uint16_t a,
+               std::uint16_t b) { return asSigned(a) >= asSigned(b); }},
+    {"JGT", [](std::uint16_t a,
+               std::uint16_t b) { return asSigned(a) > asSigned(b); }},
+    {"JLE", [](std::uint16_t a,
+               std::uint16_t b) { return asSigned(a) <= asSigned(b); }},
+    {"JB", [](std::uint16_t a, std::uint16_t b) { return a < b; }},
+    {"JAE", [](std::uint16_t a, std::uint16_t b) { return a >= b; }},
+    {"JA", [](std::uint16_t a, std::uint16_t b) { return a > b; }},
+    {"JBE", [](std::uint16_t a, std::uint16_t b) { return a <= b; }},
+};
+
+void conditionalJumps() {
+  const std::pair<std::uint16_t, std::uint16_t> pairs[] = {
+      {0, 0},           {1, 2},           {2, 1},
+      {0x8000, 1},      {1, 0x8000},      {0x7FFF, 0xFFFF},
+      {0xFFFF, 0x7FFF}, {0x8000, 0x7FFF}, {0xFFFF, 0}};
+  for (const auto &[a, b] : pairs) {
+    // Each taken jump sets its bit in R5
+    std::string source;
+    std::uint16_t expected = 0;
+    for (std::size_t i = 0; i < std::size(kBranches); ++i) {
+      const auto n = std::to_string(i);
+      source += "LDI r1, #" + std::to_string(a) + "\nCMP r1, #" +
+                std::to_string(b) + "\n" + kBranches[i].mnemonic + " t" +
+                n + "\nJMP n" + n + "\nt" + n + ": OR r5, #" +
+                std::to_string(1u << i) + "\nn" + n + ":\n";
+      if (kBranches[i].holds(a, b)) {
+        expected = static_cast<std::uint16_t>(expected | 1u << i);
+      }
+    }
+    const auto regs = run(source + "HALT\n");
+    CHECK_EQ(regs.gpr[5], expected);
+  }
+}
+
+void fusedBranches() {
+  // BEQ, BNE and BLT compare their operands directly and keep the flags
+  const auto regs = run(R"(
+        LDI r1, #-3
+        LDI r0, #0              ; Z=1
+        BEQ r1, #-3, eq
+        OR r5, #1
+eq:     BNE r1, #-3, wrong
+        BLT r1, #2, lt          ; signed: -3 < 2
+        OR r5, #2
+lt:     BLT r1, #-4, wrong
+        JNZ wrong               ; flags still from LDI r0, #0
+        MOV r4, #1
+        HALT
+wrong:  MOV r4, #2
+        HALT
+)");
+  CHECK_EQ(regs.gpr[5], 0);
+  CHECK_EQ(regs.gpr[4], 1);
+}
+
+// Bit manipulation
+
+void rotatesAndShifts() {
+  auto regs = run("LDI r0, #0x8001\nROL r0, #1\nHALT\n");
+  CHECK_EQ(regs.gpr[0], 0x0003);
+  CHECK(regs.flags.test(StatusFlag::kCarry)); // Bit rotated out of the top
+  regs = run("LDI r0, #0x8001\nROR r0, #4\nHALT\n");
+  CHECK_EQ(regs.gpr[0], 0x1800);
+  CHECK(!regs.flags.test(StatusFlag::kCarry)); // Bit 3 went out last
+  regs = run("LDI r0, #0x1234\nROL r0, #20\nHALT\n"); // 20 mod 16 = 4
+  CHECK_EQ(regs.gpr[0], 0x2341);
+  regs = run("LDI r0, #0x8004\nSAR r0, #3\nHALT\n");
+  CHECK_EQ(regs.gpr[0], 0xF000);
+  CHECK(regs.flags.test(StatusFlag::kCarry));
+  CHECK(regs.flags.test(StatusFlag::kNegative));
+  regs = run("LDI r0, #0x8000\nSAR r0, #0\nHALT\n");
+  CHECK_EQ(regs.gpr[0], 0x8000);
+  CHECK(!regs.flags.test(StatusFlag::kCarry)); // Zero count
+}
+
+void bitCounts() {
+  auto regs = run(R"(
+        LDI r1, #0x0F10
+        POPCNT r0, r1
+        CLZ r2, r1
+        CTZ r3, r1
+        LDI r4, #0x1234
+        BSWAP r4
+        HALT
+)");
+  CHECK_EQ(regs.gpr[0], 5);
+  CHECK_EQ(regs.gpr[2], 4);
+  CHECK_EQ(regs.gpr[3], 4);
+  CHECK_EQ(regs.gpr[4], 0x3412);
+  regs = run("LDI r1, #0\nCLZ r0, r1\nHALT\n");
+  CHECK_EQ(regs.gpr[0], 16);
+  CHECK(regs.flags.test(StatusFlag::kCarry));
+  regs = run("LDI r1, #0\nCTZ r0, r1\nHALT\n");
+  CHECK_EQ(regs.gpr[0], 16);
+  CHECK(regs.flags.test(StatusFlag::kCarry));
+  regs = run("LDI r1, #0\nPOPCNT r0, r1\nHALT\n");
+  CHECK_EQ(regs.gpr[0], 0);
+  CHECK(regs.flags.test(StatusFlag::kZero));
+}
+
+void singleBits() {
+  // BTST/BSET/BCLR report the old bit: C holds it, Z is its complement
+  auto regs = run("LDI r0, #0x0010\nBTST r0, #4\nHALT\n");
+  CHECK_EQ(flagString(regs.flags), "C---");
+  regs = run("LDI r0, #0x0010\nBSET r0, #20\nHALT\n"); // Bit 4 again
+  CHECK_EQ(regs.gpr[0], 0x0010);
+  CHECK(regs.flags.test(StatusFlag::kCarry));
+  regs = run("LDI r0, #0x0010\nBSET r0, #15\nHALT\n");
+  CHECK_EQ(regs.gpr[0], 0x8010);
+  CHECK(regs.flags.test(StatusFlag::kZero));
+  CHECK(!regs.flags.test(StatusFlag::kCarry));
+  regs = run(R"(
+        BSET [bitmap], #3       ; test-and-set on memory
+        BCLR [bitmap], #0
+        LOAD r0, [bitmap]
+        BCLR [bitmap], #0       ; already clear
+        HALT
+bitmap: .word 0x0001
+)");
+  CHECK_EQ(regs.gpr[0], 0x0008);
+  CHECK(regs.flags.test(StatusFlag::kZero));
+}
+
+// Result of "LDI r0, #a" then "<mnemonic> r0, #b"
+RegisterFile binary(const std::string &mnemonic, std::uint16_t a,
+                    std::uint16_t b) {
+  return run("LDI r0, #" + std::to_string(a) + "\n" + mnemonic +
+             " r0, #" + std::to_string(b) + "\nHALT\n");
+}
+
+struct BinaryCase {
+  const char *mnemonic;
+  std::uint16_t a;
+  std::uint16_t b;
+  std::uint16_t result;
+  const char *flags; // As flagString
+};
+
+void checkBinary(const BinaryCase &test) {
+  const auto regs = binary(test.mnemonic, test.a, test.b);
+  if (regs.gpr[0] != test.result || flagString(regs.flags) != test.flags) {
+    std::cerr << test.mnemonic << ' ' << std::hex << test.a << ", "
+              << test.b << std::dec << ":\n";
+  }
+  CHECK_EQ(regs.gpr[0], test.result);
+  CHECK_EQ(flagString(regs.flags), test.flags);
+}
+
+// Packed 8-bit lanes
+
+void packedLanes() {
+  const BinaryCase cases[] = {
+      // Lanes wrap or clamp independently; C reports any lane
+      {"PADDB", 0xF010, 0x20F5, 0x1005, "C---"},
+      {"PADDUSB", 0xF010, 0x20F5, 0xFFFF, "C-N-"},
+      {"PADDUSB", 0x7F01, 0x0102, 0x8003, "--N-"},
+      {"PADDUSB", 0x10FF, 0x0001, 0x10FF, "C---"}, // Low lane only
+      {"PADDUSB", 0xFF10, 0x0100, 0xFF10, "C-N-"}, // High lane only
+      {"PSUBB", 0x1005, 0x0206, 0x0EFF, "C---"},
+      {"PSUBUSB", 0x1005, 0x0206, 0x0E00, "C---"},
+      {"PSUBUSB", 0x0102, 0x0102, 0x0000, "-Z--"},
+      {"PCMPEQB", 0x1234, 0x1299, 0xFF00, "--N-"},
+      {"PCMPEQB", 0x1234, 0x1234, 0xFFFF, "C-N-"},
+      {"PCMPHIB", 0x80FF, 0x7FFF, 0xFF00, "--N-"},
+      {"PMINUB", 0x80FF, 0x7F10, 0x7F10, "----"},
+      {"PMAXUB", 0x80FF, 0x7F10, 0x80FF, "--N-"},
+      // PACKUSB clamps both words as signed values into bytes
+      {"PACKUSB", 0x0042, 0x0017, 0x1742, "----"},
+      {"PACKUSB", 300, 0xFFFB, 0x00FF, "C---"},
+      {"PACKUSB", 0x8000, 0x7FFF, 0xFF00, "C-N-"},
+      {"PACKUSB", 0x00FF, 0x0000, 0x00FF, "----"},
+  };
+  for (const auto &test : cases) {
+    checkBinary(test);
+  }
+
+  // UNPKB splits a word and leaves the flags alone
+  const auto regs = run(R"(
+        LDI r2, #0xABCD
+        CMP r2, r2              ; Z=1, C=1
+        UNPKB r0, r2, r3
+        HALT
+)");
+  CHECK_EQ(regs.gpr[0], 0x00CD);
+  CHECK_EQ(regs.gpr[3], 0x00AB);
+  CHECK_EQ(flagString(regs.flags), "CZ--");
+}
+
+// Fixed-point and saturating arithmetic
+
+void fixedPointMultiply() {
+  struct Case {
+    const char *mnemonic;
+    std::uint16_t a;
+    std::uint16_t b;
+    std::uint16_t result;
+    bool saturated;
+  };
+  const Case cases[] = {
+      {"MULQ", 0x4000, 0x4000, 0x2000, false}, // 0.5 * 0.5
+      {"MULQ", 0x0001, 0x4000, 0x0001, false}, // Half an lsb rounds up
+      {"MULQ", 0xFFFF, 0x4000, 0x0000, false}, // -half an lsb rounds to 0
+      {"MULQ", 0xFFFF, 0x7FFF, 0xFFFF, false},
+      {"MULQ", 0x8000, 0x7FFF, 0x8001, false},
+      {"MULQ", 0x8000, 0x8000, 0x7FFF, true}, // -1 * -1 does not fit
+      {"MULQ8", 0x0180, 0xFE00, 0xFD00, false}, // 1.5 * -2
+      {"MULQ8", 0x0001, 0x0080, 0x0001, false}, // Rounds half up
+      {"MULQ8", 0x7FFF, 0x0200, 0x7FFF, true},
+      {"MULQ8", 0x8000, 0x0200, 0x8000, true},
+      {"ADDS", 0x7000, 0x2000, 0x7FFF, true},
+      {"ADDS", 0x9000, 0xE000, 0x8000, true},
+      {"ADDS", 0x7000, 0xF000, 0x6000, false},
+      {"SUBS", 0x9000, 0x2000, 0x8000, true},
+      {"SUBS", 0x7000, 0xE000, 0x7FFF, true},
+      {"SUBS", 5, 7, 0xFFFE, false},
+  };
+  for (const auto &test : cases) {
+    const auto regs = binary(test.mnemonic, test.a, test.b);
+    if (regs.gpr[0] != test.result) {
+      std::cerr << test.mnemonic << ' ' << std::hex << test.a << ", "
+                << test.b << std::dec << ":\n";
+    }
+    CHECK_EQ(regs.gpr[0], test.result);
+    CHECK_EQ(regs.flags.test(StatusFlag::kOverflow), test.saturated);
+  }
+}
+
+void absoluteAndNegate() {
+  auto regs = run("LDI r0, #-300\nABS r0\nHALT\n");
+  CHECK_EQ(regs.gpr[0], 300);
+  CHECK(!regs.flags.test(StatusFlag::kOverflow));
+  regs = run("LDI r0, #0x8000\nABS r0\nHALT\n");
+  CHECK_EQ(regs.gpr[0], 0x7FFF);
+  CHECK(regs.flags.test(StatusFlag::kOverflow));
+  // NEG sets flags like SUB from zero
+  regs = run("LDI r0, #0x7FFF\nNEG r0\nHALT\n");
+  CHECK_EQ(regs.gpr[0], 0x8001);
+  CHECK_EQ(flagString(regs.flags), "--N-");
+  regs = run("LDI r0, #0\nNEG r0\nHALT\n");
+  CHECK_EQ(regs.gpr[0], 0);
+  CHECK_EQ(flagString(regs.flags), "CZ--");
+  regs = run("LDI r0, #0x8000\nNEG r0\nHALT\n");
+  CHECK_EQ(regs.gpr[0], 0x8000);
+  CHECK_EQ(flagString(regs.flags), "--NV");
+}
+
+} // namespace
+
+int main() {
+  carryChains();
+  highProducts();
+  divisionAndRemainder();
+  autoIndexing();
+  byteAccesses();
+  byteStoreToADevice();
+  predicatedInstructions();
+  skippedInstructionsCostACycle();
+  conditionalJumps();
+  fusedBranches();
+  rotatesAndShifts();
+  bitCounts();
+  singleBits();
+  packedLanes();
+  fixedPointMultiply();
+  absoluteAndNegate();
+  return test::result();
+}
@@ -0,0 +1,104 @@
+#include "test_support.hpp"
+
+using namespace softcpu;
+
+namespace {
+
+void bankedCodeAndData() {
+  Emulator emulator;
+  emulator.setPhysicalMemory(512 * kPageSize);
+  const auto text = test::runSource(emulator, R"(
+.const PAGE8_BANK 0xFF80
+.const PAGE9_BANK 0xFF82
+        LDI r0, #20
+        STORE r0, [PAGE8_BANK]
+        CALL routine
+        LDI r0, #21
+        STORE r0, [PAGE8_BANK]
+        CALL routine
+        ; data written through frame 300 survives a round trip via frame 9
+        LDI r0, #300
+        STORE r0, [PAGE9_BANK]
+        LDI r1, #0x4242
+        STORE r1, [0x9000]
+        LDI r0, #9
+        STORE r0, [PAGE9_BANK]
+        LOAD r2, [0x9000]
+        LDI r0, #300
+        STORE r0, [PAGE9_BANK]
+        LOAD r3, [0x9000]
+        LOAD r4, [PAGE9_BANK]
+        LOAD r5, [IO_MMU_FRAMES]
+        HALT
+
+        .bank 20, 0x8000
+routine:
+        LDI r0, #'A'
+        STORE r0, [IO_CONSOLE_DATA]
+        RET
+        .bank 21, 0x8000
+        LDI r0, #'B'
+        STORE r0, [IO_CONSOLE_DATA]
+        RET
+        .endbank
+)");
+  CHECK_EQ(text, "AB");
+  const auto &regs = emulator.registers();
+  CHECK_EQ(regs.gpr[2], 0);
+  CHECK_EQ(regs.gpr[3], 0x4242);
+  CHECK_EQ(regs.gpr[4], 300);
+  CHECK_EQ(regs.gpr[5], 512);
+  // Frame 9 itself was never written
+  CHECK_EQ(emulator.memory().read16(0x9000), 0);
+
+  // Reset returns every page to its own frame
+  emulator.reset();
+  CHECK_EQ(emulator.fetch8(0x8000), 0);
+}
+
+void missingFrameIsRejected() {
+  Emulator emulator;
+  test::runSource(emulator, R"(
+        LDI r1, #0x1111
+        STORE r1, [0x8000]
+        LDI r0, #16              ; only frames 0-15 exist
+        STORE r0, [0xFF80]
+        LOAD.B r2, [IO_MMU_STATUS]
+        LOAD r3, [0x8000]        ; mapping unchanged
+        STORE.B r0, [IO_MMU_STATUS]
+        LOAD.B r4, [IO_MMU_STATUS]
+        LOAD r5, [0xFF80]
+        HALT
+)");
+  const auto &regs = emulator.registers();
+  CHECK_EQ(regs.gpr[2] & 0x40, 0x40);
+  CHECK_EQ(regs.gpr[3], 0x1111);
+  CHECK_EQ(regs.gpr[4] & 0x40, 0);
+  CHECK_EQ(regs.gpr[5], 8);
+}
+
+void devicesStayAboveARemappedPage() {
+  Emulator emulator;
+  emulator.setPhysicalMemory(32 * kPageSize);
+  const auto text = test::runSource(emulator, R"(
+        LDI r0, #31
+        STORE r0, [0xFF8E]       ; page 15 onto frame 31
+        LDI r0, #'x'
+        STORE r0, [IO_CONSOLE_DATA]
+        LDI r1, #0x5A5A
+        STORE r1, [0xF000]
+        HALT
+)");
+  CHECK_EQ(text, "x");
+  CHECK_EQ(emulator.fetch8(0xF000), 0x5A);
+  CHECK_EQ(emulator.memory().read8(0xF000), 0); // Frame 15 untouched
+}
+
+} // namespace
+
+int main() {
+  bankedCodeAndData();
+  missingFrameIsRejected();
+  devicesStayAboveARemappedPage();
+  return test::result();
+}
@@ -0,0 +1,157 @@
+#include "test_support.hpp"
+
+using namespace softcpu;
+
+namespace {
+
+// Every core bumps a counter with FADD and a lock-protected plain counter,
+// then core 0 waits for the others and loads both into R0 and R1
+const char *const kCounters = R"(
+.const COUNTER 0x4000
+.const DONE 0x4002
+.const LOCK 0x4004
+.const SHARED 0x4006
+.const ROUNDS 2000
+        LDI r1, #0
+loop:   LDI r2, #1
+        FADD [COUNTER], r2
+lock:   LDI r3, #0
+        LDI r4, #1
+        CAS [LOCK], r4, r3
+        JNZ lock
+        LOAD r5, [SHARED]
+        ADDI r5, #1
+        STORE r5, [SHARED]
+        LDI r4, #0
+        STORE r4, [LOCK]
+        ADDI r1, #1
+        CMP r1, #ROUNDS
+        JNZ loop
+        LDI r2, #1
+        FADD [DONE], r2
+        CMP r0, #0
+        JNZ finish
+        LOAD r6, [IO_MAILBOX_CORES]
+        AND r6, #0xFF
+wait:   LOAD r2, [DONE]
+        CMP r2, r6
+        JNZ wait
+        LOAD r0, [COUNTER]
+        LOAD r1, [SHARED]
+finish: HALT
+)";
+
+void atomicsAcrossCores(bool deterministic) {
+  Emulator emulator;
+  emulator.setCoreCount(4);
+  RunOptions options;
+  options.deterministic = deterministic;
+  options.quantum = 1000;
+  options.cycle_limit = 50'000'000;
+  test::runSource(emulator, kCounters, options);
+  CHECK(emulator.lastRunStats().stop_reason == StopReason::Halted);
+  CHECK_EQ(emulator.registers(0).gpr[0], 4 * 2000);
+  CHECK_EQ(emulator.registers(0).gpr[1], 4 * 2000);
+  for (std::size_t core = 1; core < 4; ++core) {
+    CHECK_EQ(emulator.registers(core).gpr[1], 2000);
+  }
+}
+
+void deterministicRunsRepeat() {
+  Emulator first;
+  first.setCoreCount(3);
+  RunOptions options;
+  options.deterministic = true;
+  options.quantum = 333;
+  test::runSource(first, kCounters, options);
+  Emulator second;
+  second.setCoreCount(3);
+  test::runSource(second, kCounters, options);
+  CHECK_EQ(first.lastRunStats().cycles, second.lastRunStats().cycles);
+  CHECK_EQ(first.instructions(), second.instructions());
+}
+
+void mailboxWakesAWaitingCore() {
+  Emulator emulator;
+  emulator.setCoreCount(2);
+  RunOptions options;
+  options.deterministic = true;
+  const auto text = test::runSource(emulator, R"(
+.const SLOT1 0xFFA4
+.const SLOT1_STATUS 0xFFA6
+        CMP r0, #0
+        JNZ secondary
+        LDI r1, #0x400
+delay:  SUBI r1, #1
+        JNZ delay
+        LDI r1, #1234
+        STORE r1, [SLOT1]
+        HALT
+secondary:
+        WAIT
+        LOAD r2, [SLOT1_STATUS]
+        AND r2, #0x80
+        JZ secondary
+        LOAD r0, [SLOT1]
+        SYS #2
+        STORE.B r0, [SLOT1_STATUS]
+        LOAD.B r3, [SLOT1_STATUS]
+        HALT
+)", options);
+  CHECK_EQ(text, "[R0=1234]\n");
+  CHECK(emulator.lastRunStats().stop_reason == StopReason::Halted);
+  CHECK_EQ(emulator.registers(1).gpr[3] & 0x80, 0); // Acknowledged
+}
+
+void faultNamesTheCore() {
+  Emulator emulator;
+  emulator.setCoreCount(3);
+  RunOptions options;
+  options.deterministic = true;
+  test::runSource(emulator, R"(
+        CMP r0, #2
+        JZ broken
+spin:   JMP spin
+broken:
+        .byte 0xFF, 0, 0, 0
+)", options);
+  const auto &stats = emulator.lastRunStats();
+  CHECK(stats.stop_reason == StopReason::Fault);
+  CHECK_EQ(stats.stop_core, 2);
+}
+
+void casReportsTheOldValue() {
+  Emulator emulator;
+  test::runSource(emulator, R"(
+        LDI r1, #5
+        STORE r1, [0x4000]
+        LDI r2, #9
+        LDI r3, #4
+        CAS [0x4000], r2, r3     ; 5 != 4: no swap, r3 = 5
+        JZ bad
+        CAS [0x4000], r2, r3     ; swaps in 9
+        JNZ bad
+        LDI r4, #3
+        FADD [0x4000], r4        ; r4 = 9, word = 12
+        LOAD r5, [0x4000]
+        HALT
+bad:    LDI r5, #0xDEAD
+        HALT
+)");
+  const auto &regs = emulator.registers();
+  CHECK_EQ(regs.gpr[3], 5);
+  CHECK_EQ(regs.gpr[4], 9);
+  CHECK_EQ(regs.gpr[5], 12);
+}
+
+} // namespace
+
+int main() {
+  atomicsAcrossCores(true);
+  atomicsAcrossCores(false);
+  deterministicRunsRepeat();
+  mailboxWakesAWaitingCore();
+  faultNamesTheCore();
+  casReportsTheOldValue();
+  return test::result();
+}
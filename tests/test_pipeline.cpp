@@ -0,0 +1,108 @@
+#include "test_support.hpp"
+
+using namespace softcpu;
+
+namespace {
+
+// Pipeline counters after running `source` with `config`; the extra cycles
+// must equal the model's stall cycles
+PipelineStats pipelineRun(const std::string &source,
+                          const PipelineConfig &config) {
+  Emulator plain;
+  test::runSource(plain, source);
+  Emulator timed;
+  test::loadSource(timed, source);
+  CHECK(timed.enablePipeline(config));
+  test::runCaptured(timed);
+  const auto stats = timed.pipeline()->stats();
+  CHECK_EQ(stats.instructions, timed.instructions());
+  CHECK_EQ(timed.cycles(), plain.cycles() + stats.stallCycles());
+  return stats;
+}
+
+void loadUseAndDataHazards() {
+  const char *const adjacent = R"(
+        LDI r2, #5
+        LOAD r1, [value]
+        ADD r2, r1
+        HALT
+value:  .word 3
+)";
+  auto stats = pipelineRun(adjacent, {});
+  CHECK_EQ(stats.load_use_cycles, 1u);
+  CHECK_EQ(stats.data_cycles, 0u);
+
+  // An independent instruction in between hides the load latency
+  stats = pipelineRun(R"(
+        LDI r2, #5
+        LOAD r1, [value]
+        LDI r3, #1
+        ADD r2, r1
+        HALT
+value:  .word 3
+)", {});
+  CHECK_EQ(stats.load_use_cycles, 0u);
+
+  // Without forwarding consumers wait for write-back: two cycles when
+  // adjacent, one at distance two
+  PipelineConfig no_forwarding;
+  no_forwarding.forwarding = false;
+  stats = pipelineRun(R"(
+        LDI r1, #1
+        ADD r2, r1
+        LDI r3, #1
+        LDI r4, #1
+        ADD r5, r3
+        HALT
+)", no_forwarding);
+  CHECK_EQ(stats.data_cycles, 3u);
+}
+
+const char *const kCountdown = R"(
+        LDI r1, #10
+loop:   SUBI r1, #1
+        JNZ loop
+        HALT
+)";
+
+void staticPredictorOnALoop() {
+  PipelineConfig config;
+  config.predictor = PredictorKind::Static;
+  const auto stats = pipelineRun(kCountdown, config);
+  CHECK_EQ(stats.branches, 10u);
+  CHECK_EQ(stats.taken, 9u);
+  // Backward taken: only the exit is mispredicted
+  CHECK_EQ(stats.mispredicts, 1u);
+  CHECK_EQ(stats.mispredict_cycles, 2u);
+}
+
+void dynamicPredictorsLearn() {
+  for (const auto kind : {PredictorKind::TwoBit, PredictorKind::Gshare}) {
+    PipelineConfig config;
+    config.predictor = kind;
+    config.table_bits = 4;
+    config.history_bits = 2;
+    const auto stats = pipelineRun(kCountdown, config);
+    CHECK_EQ(stats.branches, 10u);
+    CHECK(stats.mispredicts >= 1u);
+    CHECK(stats.mispredicts <= 4u);
+  }
+}
+
+void invalidTablesAreRejected() {
+  Emulator emulator;
+  PipelineConfig config;
+  config.table_bits = 40;
+  CHECK(!emulator.enablePipeline(config));
+  CHECK(emulator.pipeline() == nullptr);
+}
+
+} // namespace
+
+int main() {
+  loadUseAndDataHazards();
+  staticPredictorOnALoop();
+  dynamicPredictorsLearn();
+  invalidTablesAreRejected();
+  return test::result();
+}
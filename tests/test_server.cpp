@@ -0,0 +1,170 @@
+#include "test_support.hpp"
+
+#include "softcpu/server.hpp"
+
+#include <chrono>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace softcpu;
+
+namespace {
+
+// Blocking client for one connection to the job server
+class Client {
+public:
+  explicit Client(const std::string &path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    path.copy(address.sun_path, sizeof(address.sun_path) - 1);
+    // The server binds its socket on its own thread; retry for a while
+    for (int attempt = 0; attempt < 200; ++attempt) {
+      fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+      if (::connect(fd_, reinterpret_cast<const sockaddr *>(&address),
+                    sizeof(address)) == 0) {
+        return;
+      }
+      ::close(fd_);
+      fd_ = -1;
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+  ~Client() {
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+  }
+  Client(const Client &) = delete;
+  Client &operator=(const Client &) = delete;
+
+  bool connected() const { return fd_ >= 0; }
+
+  void send(const std::string &bytes) {
+    std::size_t done = 0;
+    while (done < bytes.size()) {
+      const auto sent = ::write(fd_, bytes.data() + done, bytes.size() - done);
+      if (sent <= 0) {
+        return;
+      }
+      done += static_cast<std::size_t>(sent);
+    }
+  }
+
+  void send(const std::vector<std::uint8_t> &bytes) {
+    send(std::string(bytes.begin(), bytes.end()));
+  }
+
+  // Response line without its newline, and the console bytes announced by
+  // an OK line
+  std::string receive(std::string *console = nullptr) {
+    std::string line;
+    char ch;
+    while (::read(fd_, &ch, 1) == 1 && ch != '\n') {
+      line += ch;
+    }
+    const auto field = line.find(" console=");
+    if (field != std::string::npos) {
+      auto length = std::stoul(line.substr(field + 9));
+      std::string text;
+      while (length-- > 0 && ::read(fd_, &ch, 1) == 1) {
+        text += ch;
+      }
+      if (console != nullptr) {
+        *console = text;
+      }
+    }
+    return line;
+  }
+
+private:
+  int fd_{-1};
+};
+
+std::vector<std::uint8_t> assemble(const std::string &source) {
+  Assembler assembler;
+  const auto assembled = assembler.assembleString(source);
+  CHECK(assembled.ok);
+  return assembled.bytes;
+}
+
+bool startsWith(const std::string &text, const std::string &prefix) {
+  return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+void protocol(const std::string &socket_path) {
+  Client client(socket_path);
+  CHECK(client.connected());
+  if (!client.connected()) {
+    return;
+  }
+
+  // Echo the input region to the console, then halt with R0 = 0x42
+  const auto echo = assemble(R"(
+        LDI r0, #0x4000
+        LDI r1, #3
+        STORE r0, [IO_DMA_SRC]
+        STORE r1, [IO_DMA_LEN]
+        LDI r0, #0x0102
+        STORE r0, [IO_DMA_MODE]
+        LDI r0, #0x42
+        HALT
+)");
+  client.send("RUN image=" + std::to_string(echo.size()) +
+              " input=0x4000:3\n");
+  client.send(echo);
+  client.send("abc");
+  std::string console;
+  auto reply = client.receive(&console);
+  CHECK(startsWith(reply, "OK reason=halted "));
+  CHECK(reply.find(" r0=0x0042 ") != std::string::npos);
+  CHECK(reply.find(" console=3") != std::string::npos);
+  CHECK_EQ(console, "abc");
+
+  // Errors answer the request and keep the connection in step
+  client.send("RUN image=4 cycles=0\n");
+  CHECK_EQ(client.receive(), "ERR invalid value for cycles");
+  client.send("RUN image=4 bogus=1\n");
+  CHECK_EQ(client.receive(), "ERR unknown field bogus");
+  client.send("RUN origin=0\n");
+  CHECK_EQ(client.receive(),
+           "ERR exactly one of path= or image= is required");
+  client.send("RUN path=/nonexistent/image.bin\n");
+  CHECK_EQ(client.receive(), "ERR unable to load /nonexistent/image.bin");
+  client.send("RUN image=16 origin=0xFFF8\n");
+  client.send(std::string(16, '\0'));
+  CHECK_EQ(client.receive(), "ERR image does not fit at origin");
+  client.send("STEP\n");
+  CHECK_EQ(client.receive(), "ERR unknown command");
+
+  // A runaway guest stops at its cycle budget; the warm emulator is reset
+  // before the next request
+  const auto spin = assemble("spin:\nJMP spin\n");
+  client.send("RUN image=" + std::to_string(spin.size()) + " cycles=100\n");
+  client.send(spin);
+  reply = client.receive();
+  CHECK(startsWith(reply, "OK reason=cycle_limit cycles=100 "));
+  CHECK(reply.find(" r0=0x0000 ") != std::string::npos);
+  CHECK(reply.find(" console=0") != std::string::npos);
+}
+
+} // namespace
+
+int main() {
+  const std::string socket_path =
+      "/tmp/softcpu-test-" + std::to_string(::getpid()) + ".sock";
+  ServerOptions options;
+  options.socket_path = socket_path;
+  options.workers = 2;
+  JobServer server(options);
+  bool served = false;
+  std::thread thread([&] { served = server.serve(); });
+  protocol(socket_path);
+  server.stop();
+  thread.join();
+  CHECK(served);
+  CHECK(::access(socket_path.c_str(), F_OK) != 0); // Socket removed
+  return test::result();
+}
@@ -0,0 +1,95 @@
+#include "test_support.hpp"
+
+#include "softcpu/fuzzer.hpp"
+
+#include <filesystem>
+
+using namespace softcpu;
+
+namespace {
+
+// Writes through a banked page (frame 20 at page 8) and to plain RAM
+const char *const kBanking = R"(
+        LDI r0, #20
+        STORE r0, [0xFF80]
+        LDI r1, #0x1234
+        STORE r1, [0x8000]
+        STORE r1, [0x4000]
+        LDI r3, #7
+        HALT
+)";
+
+void roundTripRestoresMemoryFramesAndMapping() {
+  Emulator emulator;
+  emulator.setPhysicalMemory(128 * 1024);
+  test::loadSource(emulator, kBanking);
+  emulator.registers().gpr[5] = 0xBEEF;
+  Snapshot initial;
+  emulator.saveSnapshot(initial);
+  CHECK_EQ(initial.extended.size(), 0u + 64 * 1024);
+
+  test::runCaptured(emulator);
+  CHECK_EQ(emulator.fetch8(0x8000), 0x34); // Frame 20 is mapped
+  Snapshot after;
+  emulator.saveSnapshot(after);
+  CHECK_EQ(after.extended[(20 - 16) * kPageSize], 0x34);
+  CHECK_EQ(after.memory[0x4000], 0x34);
+  CHECK_EQ(after.memory[0x8000], 0x00); // Frame 8 was not written
+
+  emulator.restoreSnapshot(initial);
+  Snapshot restored;
+  emulator.saveSnapshot(restored);
+  CHECK(restored.memory == initial.memory);
+  CHECK(restored.extended == initial.extended);
+  CHECK_EQ(restored.registers.gpr[5], 0xBEEF);
+  CHECK_EQ(restored.registers.pc, initial.registers.pc);
+  CHECK_EQ(emulator.cycles(), 0u);
+  CHECK_EQ(emulator.fetch8(0x8000), 0x00); // Back on frame 8
+
+  // A restored machine replays the run exactly
+  test::runCaptured(emulator);
+  Snapshot replay;
+  emulator.saveSnapshot(replay);
+  CHECK(replay.memory == after.memory);
+  CHECK(replay.extended == after.extended);
+  CHECK_EQ(replay.registers.gpr[3], 7);
+}
+
+void fuzzerFindsAGuardedFault() {
+  // Faults on an unknown opcode only when the first input byte is 'F'
+  Assembler assembler;
+  const auto assembled = assembler.assembleString(R"(
+        LOAD.B r0, [0x4000]
+        CMP r0, #'F'
+        JNZ fine
+        .byte 0xFF, 0, 0, 0
+fine:
+        HALT
+)");
+  CHECK(assembled.ok);
+  const auto output = std::filesystem::path("softcpu_test_fuzz");
+  std::filesystem::remove_all(output);
+  FuzzOptions options;
+  options.image = assembled.bytes;
+  options.input_address = 0x4000;
+  options.input_length = 4;
+  options.max_execs = 5000;
+  options.output_dir = output.string();
+  options.seeds = {{'a', 'b', 'c', 'd'}};
+  Fuzzer fuzzer(options);
+  const auto stats = fuzzer.run();
+  CHECK_EQ(stats.crashes, 1u);
+  // Workers count executions in batches, so the limit may be overshot a bit
+  CHECK(stats.execs >= options.max_execs);
+  CHECK(stats.execs < options.max_execs + 1000);
+  CHECK(std::filesystem::exists(output / "crashes"));
+  std::filesystem::remove_all(output);
+}
+
+} // namespace
+
+int main() {
+  roundTripRestoresMemoryFramesAndMapping();
+  fuzzerFindsAGuardedFault();
+  return test::result();
+}
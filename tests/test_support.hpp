@@ -0,0 +1,116 @@
+#pragma once
+
+#include "softcpu/assembler.hpp"
+#include "softcpu/console.hpp"
+#include "softcpu/emulator.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <string>
+
+// Minimal checks for the behaviour tests; each test executable runs its
+// cases from main and returns softcpu::test::result().
+namespace softcpu::test {
+
+// Number of failed checks so far
+inline int failures = 0;
+
+inline void fail(const char *file, int line, const std::string &message) {
+  std::cerr << file << ':' << line << ": " << message << '\n';
+  ++failures;
+}
+
+// Exit status for main: 0 if every check passed
+inline int result() {
+  if (failures > 0) {
+    std::cerr << failures << " check(s) failed\n";
+    return 1;
+  }
+  return 0;
+}
+
+template <typename Actual, typename Expected>
+void checkEqual(const Actual &actual, const Expected &expected,
+                const char *text, const char *file, int line) {
+  if (!(actual == expected)) {
+    std::cerr << file << ':' << line << ": " << text << "\n  actual:   "
+              << actual << "\n  expected: " << expected << '\n';
+    ++failures;
+  }
+}
+
+// Assemble `source` at the reset vector into a freshly reset emulator,
+// including banked sections (physical memory grows to hold them). An
+// assembly error counts as a failure.
+inline AssemblyResult loadSource(Emulator &emulator,
+                                 const std::string &source) {
+  Assembler assembler;
+  auto assembled = assembler.assembleString(source);
+  if (!assembled.ok) {
+    for (const auto &message : assembled.messages) {
+      std::cerr << message << '\n';
+    }
+    fail(__FILE__, __LINE__, "assembly failed");
+    return assembled;
+  }
+  std::size_t physical = emulator.physicalMemorySize();
+  for (const auto &block : assembled.banks) {
+    physical = std::max(physical, block.address + block.bytes.size());
+  }
+  if (physical > emulator.physicalMemorySize()) {
+    emulator.setPhysicalMemory(physical);
+  }
+  emulator.reset();
+  emulator.loadImage(assembled.bytes);
+  for (const auto &block : assembled.banks) {
+    emulator.loadPhysical(block.address, block.bytes);
+  }
+  return assembled;
+}
+
+// Address of a label defined by an assembled program
+inline std::uint16_t labelAddress(const AssemblyResult &assembled,
+                                  const std::string &name) {
+  for (const auto &[label, address] : assembled.labels) {
+    if (label == name) {
+      return address;
+    }
+  }
+  fail(__FILE__, __LINE__, "no label " + name);
+  return 0;
+}
+
+// Run the loaded program with its console captured and return the text.
+// Unlimited runs are capped so a broken program cannot hang the test.
+inline std::string runCaptured(Emulator &emulator, RunOptions options = {}) {
+  auto capture = std::make_shared<CaptureSink>(4096);
+  options.console = capture;
+  if (options.cycle_limit == 0) {
+    options.cycle_limit = 1'000'000;
+  }
+  emulator.run(options);
+  return std::string(capture->text());
+}
+
+// loadSource followed by runCaptured
+inline std::string runSource(Emulator &emulator, const std::string &source,
+                             RunOptions options = {}) {
+  if (!loadSource(emulator, source).ok) {
+    return {};
+  }
+  return runCaptured(emulator, options);
+}
+
+} // namespace softcpu::test
+
+#define CHECK(condition)                                                       \
+  do {                                                                         \
+    if (!(condition)) {                                                        \
+      ::softcpu::test::fail(__FILE__, __LINE__, "CHECK(" #condition ")");      \
+    }                                                                          \
+  } while (false)
+
+#define CHECK_EQ(actual, expected)                                             \
+  ::softcpu::test::checkEqual((actual), (expected), #actual " == " #expected, \
+                              __FILE__, __LINE__)
@@ -0,0 +1,144 @@
+#include "test_support.hpp"
+
+#include "softcpu/device.hpp"
+
+#include <array>
+
+using namespace softcpu;
+
+namespace {
+
+// A timer wired to line 0 of its own (unmasked) interrupt controller
+struct WiredTimer {
+  TimerDevice timer;
+  InterruptController interrupts;
+
+  WiredTimer(std::uint16_t period, std::uint16_t compare,
+             std::uint8_t control) {
+    timer.reset();
+    interrupts.reset();
+    interrupts.write(1, 0x01); // Unmask line 0
+    timer.connectInterrupt({&interrupts, 0});
+    timer.write(3, static_cast<std::uint8_t>(period & 0xFF));
+    timer.write(4, static_cast<std::uint8_t>(period >> 8));
+    timer.write(5, static_cast<std::uint8_t>(compare & 0xFF));
+    timer.write(6, static_cast<std::uint8_t>(compare >> 8));
+    timer.write(2, control);
+  }
+
+  // Counter, control and the pending latch (which is then cleared)
+  std::array<unsigned, 4> takeState() {
+    const std::array<unsigned, 4> state{timer.read(0), timer.read(1),
+                                        timer.read(2), interrupts.read(0)};
+    interrupts.write(0, 0xFF);
+    return state;
+  }
+};
+
+// Advance one timer in bulk and step a twin tick by tick; both must agree
+// after every step, including whether the compare interrupt fired
+void checkAdvanceMatchesTicks(std::uint16_t period, std::uint16_t compare,
+                              std::uint8_t control) {
+  WiredTimer bulk(period, compare, control);
+  WiredTimer stepped(period, compare, control);
+  const std::array<std::uint64_t, 7> steps{1, 3, 7, 64, 250, 1000, 4097};
+  for (int round = 0; round < 6; ++round) {
+    for (const auto cycles : steps) {
+      const auto until = bulk.timer.cyclesUntilEvent();
+      bulk.timer.advance(cycles);
+      bool fired = false;
+      std::uint64_t first_fire = 0;
+      for (std::uint64_t i = 0; i < cycles; ++i) {
+        stepped.timer.tick();
+        if (!fired && stepped.interrupts.read(0) != 0) {
+          fired = true;
+          first_fire = i + 1;
+        }
+      }
+      const auto expected = stepped.takeState();
+      CHECK(bulk.takeState() == expected);
+      // The predicted event is the first tick that raises the line
+      if (fired && until) {
+        CHECK_EQ(*until, first_fire);
+      }
+      if (until && *until <= cycles) {
+        CHECK(fired);
+      }
+    }
+  }
+}
+
+void closedFormAdvance() {
+  constexpr std::uint8_t kEnable = 0x01;
+  constexpr std::uint8_t kReload = 0x02;
+  constexpr std::uint8_t kCompare = 0x04;
+  checkAdvanceMatchesTicks(100, 40, kEnable | kReload | kCompare);
+  checkAdvanceMatchesTicks(100, 0, kEnable | kReload | kCompare);
+  checkAdvanceMatchesTicks(100, 150, kEnable | kReload | kCompare);
+  checkAdvanceMatchesTicks(1, 0, kEnable | kReload | kCompare);
+  checkAdvanceMatchesTicks(0, 0, kEnable | kReload | kCompare);
+  checkAdvanceMatchesTicks(500, 499, kEnable | kCompare);
+  checkAdvanceMatchesTicks(500, 500, kEnable | kCompare);
+  checkAdvanceMatchesTicks(0x1000, 0x0800, kEnable | kReload);
+  checkAdvanceMatchesTicks(100, 40, kReload | kCompare);
+}
+
+// Program the timer to match after `compare` cycles on line 0, with the
+// given interrupt mask, then WAIT with interrupts disabled
+std::string waitProgram(unsigned compare, unsigned mask) {
+  return R"(
+        LDI r0, #0x8000
+        STORE r0, [IO_TIMER_PERIOD]
+        LDI r0, #)" + std::to_string(compare) + R"(
+        STORE r0, [IO_TIMER_COMPARE]
+        LDI r0, #)" + std::to_string(mask) + R"(
+        STORE.B r0, [IO_IRQ_MASK]
+        LDI r0, #0x0007
+        STORE r0, [IO_TIMER_CONTROL]
+        WAIT
+        LDI r1, #1
+        HALT
+)";
+}
+
+void waitSkipsToTheNextEvent() {
+  Emulator emulator;
+  test::runSource(emulator, waitProgram(20000, 0x01));
+  const auto &stats = emulator.lastRunStats();
+  CHECK(stats.stop_reason == StopReason::Halted);
+  CHECK_EQ(emulator.registers().gpr[1], 1);
+  CHECK(stats.cycles >= 20000u);
+  CHECK(stats.cycles < 20100u);
+  CHECK_EQ(stats.instructions, 11u);
+}
+
+void waitHonoursTheCycleLimit() {
+  Emulator emulator;
+  RunOptions options;
+  options.cycle_limit = 5000;
+  test::runSource(emulator, waitProgram(20000, 0x01), options);
+  const auto &stats = emulator.lastRunStats();
+  CHECK(stats.stop_reason == StopReason::CycleLimit);
+  CHECK_EQ(stats.cycles, 5000u);
+}
+
+void waitWithoutWakeSourceIsIdle() {
+  Emulator emulator;
+  // The timer's line is masked, so its match cannot end the WAIT
+  test::runSource(emulator, waitProgram(20000, 0x00));
+  CHECK(emulator.lastRunStats().stop_reason == StopReason::Idle);
+  CHECK_EQ(emulator.registers().gpr[1], 0);
+
+  test::runSource(emulator, "WAIT\nHALT\n");
+  CHECK(emulator.lastRunStats().stop_reason == StopReason::Idle);
+}
+
+} // namespace
+
+int main() {
+  closedFormAdvance();
+  waitSkipsToTheNextEvent();
+  waitHonoursTheCycleLimit();
+  waitWithoutWakeSourceIsIdle();
+  return test::result();
+}